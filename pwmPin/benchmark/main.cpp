@@ -0,0 +1,120 @@
+/**
+ * @brief Benchmark for the PwmPin duty setters.
+ *
+ *        Counts CPU cycles per call with SysTick (the M0+ has no cycle
+ *        counter) and prints the results over stdio every few seconds.
+ */
+#include <cstdio>
+
+#include <pico/stdlib.h>
+#include <hardware/pwm.h>
+#include <hardware/structs/systick.h>
+
+#include "pwmPin.hpp"
+
+// Any free pins on the same slice
+const uint8_t PIN_A = 2;
+const uint8_t PIN_B = 3;
+
+const uint32_t ITERATIONS = 1000;
+
+/**
+ * @brief Start SysTick counting down from its maximum, at the CPU clock
+ */
+void startSysTick()
+{
+    systick_hw->rvr = 0x00FFFFFF;
+    systick_hw->cvr = 0;
+    systick_hw->csr = 0x5;      // Enable, processor clock, no interrupt
+}
+
+/**
+ * @brief Time a number of calls and print the cycles per call
+ *
+ * @param pName - name to print
+ * @param func - called with 0 - ITERATIONS - 1
+ * @param overhead - cycles per call of an empty loop
+ * @return uint32_t - cycles per call
+ */
+template <typename Func>
+uint32_t bench(const char* pName, Func func, const uint32_t overhead = 0)
+{
+    const uint32_t start = systick_hw->cvr;
+
+    for(uint32_t i = 0; i < ITERATIONS; i++)
+    {
+        func(i);
+    }
+
+    // Counts down; 24 bit
+    const uint32_t cycles = ((start - systick_hw->cvr) & 0x00FFFFFF) / ITERATIONS;
+
+    if(pName)
+    {
+        printf("%-32s %4lu cycles\n", pName, cycles - overhead);
+    }
+
+    return cycles;
+}
+
+int main()
+{
+    stdio_init_all();
+    startSysTick();
+
+    PwmPin pinA(PIN_A, 20'000);
+    PwmPin pinB(PIN_B, 20'000);
+    const uint slice = pinA.getSlice();
+    const uint32_t wrap = pinA.getWrap();
+    volatile uint32_t sink = 0;
+
+    while(true)
+    {
+        sleep_ms(3000);
+
+        const uint32_t overhead = bench(nullptr, [&](uint32_t i) { sink = i; });
+
+        printf("\nwrap %lu, %lu iterations, loop overhead %lu cycles\n",
+                wrap, ITERATIONS, overhead);
+
+        // What setDuty used to do: multiply, divide by 100, SDK write
+        bench("divide + pwm_set_chan_level", [&](uint32_t i)
+        {
+            sink = i;
+            pwm_set_chan_level(slice, PWM_CHAN_A, wrap * (i % 101) / 100);
+        }, overhead);
+
+        bench("setDuty", [&](uint32_t i)
+        {
+            sink = i;
+            pinA.setDuty(i & 0x3F);
+        }, overhead);
+
+        bench("setDutyTicks", [&](uint32_t i)
+        {
+            sink = i;
+            pinA.setDutyTicks(i);
+        }, overhead);
+
+        bench("setDutyFrac", [&](uint32_t i)
+        {
+            sink = i;
+            pinA.setDutyFrac(i << 6);
+        }, overhead);
+
+        bench("setDutyTicks x2", [&](uint32_t i)
+        {
+            sink = i;
+            pinA.setDutyTicks(i);
+            pinB.setDutyTicks(i);
+        }, overhead);
+
+        bench("setSliceLevels", [&](uint32_t i)
+        {
+            sink = i;
+            PwmPin::setSliceLevels(slice, i, i);
+        }, overhead);
+    }
+
+    return 0;
+}
@@ -1,33 +1,50 @@
 /**
  * @brief Example program that uses the PwmPin library to fade an LED
  *        in and out.
+ *
+ *        The fade is a table of levels played by PwmSequencer, one level
+ *        per PWM period, so the CPU is free once it has started.
  */
-#include <pico/time.h>
+#include <pico/stdlib.h>
+#include <hardware/pwm.h>
+#include <hardware/sync.h>
 
 #include "pwmPin.hpp"
+#include "pwmSequencer.hpp"
 
 // LED S pin connected to pin 4(GPIO 2)
 const uint8_t LED_PIN = 2;
 
+// One level per period: 1 second up, 1 second down at 1kHz
+const uint32_t FREQ = 1000;
+const size_t STEPS = 2000;
+
+uint32_t fadeTable[STEPS];
+
 int main()
 {
-    PwmPin led(LED_PIN);
+    PwmPin led(LED_PIN, FREQ);
+    PwmSequencer sequencer(led.getSlice());
 
-    uint16_t level = 0;
-    int step = 10;
+    const uint32_t wrap = led.getWrap();
+    const size_t half = STEPS / 2;
 
-    while(true)
-    {   
-        led.setDuty(level);
-        sleep_ms(100);
+    for(size_t i = 0; i < STEPS; i++)
+    {
+        const uint16_t level = wrap * ((i < half) ? i : STEPS - i) / half;
 
-        if(level < 10)
-            step = 10;
-        else if(level > 90)
-            step = -10;
+        // The other channel of the slice is left off
+        fadeTable[i] = (led.getChannel() == PWM_CHAN_A) ?
+                            PwmSequencer::makeLevels(level, 0) :
+                            PwmSequencer::makeLevels(0, level);
+    }
+
+    sequencer.play(fadeTable, STEPS, PwmSequencer::Mode::Loop);
 
-        level += step;
+    while(true)
+    {
+        __wfi();
     }
 
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <pico/stdlib.h>
+#include <hardware/structs/pwm.h>
+
+/**
+ * @brief Complementary PWM pair with dead time, for driving a half-bridge.
+ *
+ * Uses both pins of one slice: A drives the high side and B the low side.
+ * The slice runs phase-correct, B's output is inverted and B's compare
+ * value is A's plus the dead time, so B is high only while the counter is
+ * at least dead time ticks above A's level.  With the counter going up and
+ * down, that leaves the same gap on both edges of every pulse, where
+ * neither output is high.  (A trailing-edge slice would switch B off and A
+ * on at the same instant at wrap.)
+ *
+ * Both levels are written with a single store to the compare register, so
+ * the pair can never be latched half-updated.
+ */
+class ComplementaryPwm
+{
+public:
+
+    /// 100% duty for setDuty (Q16 fixed point)
+    static constexpr uint32_t DUTY_FULL = 1u << 16;
+
+    /**
+     * @brief Construct ComplementaryPwm object; starts shut down
+     *
+     * @param gpioPinA - GPIO pin of channel A (high side, even numbered);
+     *                   the next pin is channel B (low side)
+     * @param initFreq - Initial frequency (Hz)
+     * @param deadTimeNs - Dead time on each edge (ns)
+     * @param enable - If true, enable the slice
+     */
+    ComplementaryPwm( const uint8_t gpioPinA,
+                      const uint32_t initFreq = 20'000,
+                      const uint32_t deadTimeNs = 500,
+                      const bool enable = true);
+
+    /**
+     * @brief Set the frequency; duty and dead time are kept
+     *
+     * @param freq - Frequency (Hz)
+     * @return true if freq reachable, false if not (settings unchanged)
+     */
+    bool setFreq(const uint32_t freq);
+
+    /**
+     * @brief Get the frequency the pair actually runs at
+     *
+     * @return uint32_t - Achieved frequency, rounded (Hz)
+     */
+    uint32_t getActualFreq()
+    { return mActualFreq; }
+
+    /**
+     * @brief Set the dead time, rounded up to whole counter ticks
+     *
+     * @param deadTimeNs - Dead time on each edge (ns)
+     * @return true if set, false if longer than half a period
+     */
+    bool setDeadTime(const uint32_t deadTimeNs);
+
+    /**
+     * @brief Get the dead time in counter ticks
+     *
+     * @return uint32_t - Dead time on each edge (ticks)
+     */
+    uint32_t getDeadTicks()
+    { return mDeadTicks; }
+
+    /**
+     * @brief Set the high side duty cycle
+     *
+     * The low side is on for the rest of the period, less the dead time on
+     * each edge.  Ignored for output until resume() if shut down.
+     *
+     * @param frac - High side duty cycle, 0 - DUTY_FULL (Q16 fixed point)
+     */
+    void setDuty(const uint32_t frac);
+
+    /**
+     * @brief Get the high side duty cycle
+     *
+     * @return uint32_t - Duty cycle, 0 - DUTY_FULL (Q16 fixed point)
+     */
+    uint32_t getDuty()
+    { return mDutyFrac; }
+
+    /**
+     * @brief Force both outputs low
+     *
+     * A single write to the compare register (A = 0, inverted B = 0xFFFF);
+     * takes effect when the counter next reaches zero, within one period.
+     * Safe to call from an interrupt handler.
+     */
+    void shutdown();
+
+    /**
+     * @brief Drive the outputs from the duty cycle again after shutdown
+     */
+    void resume();
+
+    /**
+     * @brief Check if shut down
+     *
+     * @return true if both outputs are forced low
+     */
+    bool isShutdown()
+    { return mIsShutdown; }
+
+    /**
+     * @brief Get PWM generator of the pair
+     *
+     * @return uint - PWM slice number
+     */
+    uint getSlice()
+    { return mSlice; }
+
+private:
+
+    /**
+     * @brief Write both levels to the compare register
+     */
+    void writeLevels();
+
+    /**
+     * @brief Work out the dead time in ticks at the current divider
+     *
+     * @param deadTimeNs - Dead time (ns)
+     * @return uint32_t - Dead time (ticks)
+     */
+    uint32_t deadTimeToTicks(const uint32_t deadTimeNs);
+
+    /// PWM generator
+    uint mSlice;
+    /// Compare register of slice
+    io_rw_32* mpCc;
+    /// Clock divider, 8.4 fixed point
+    uint32_t mDiv16 = 16;
+    /// Wrap value for PWM counter
+    uint32_t mWrap = 0xFFFE;
+    /// Achieved frequency (Hz)
+    uint32_t mActualFreq = 0;
+    /// Dead time (ns)
+    uint32_t mDeadTimeNs;
+    /// Dead time (ticks)
+    uint32_t mDeadTicks = 0;
+    /// High side duty cycle (Q16 fraction of DUTY_FULL)
+    uint32_t mDutyFrac = 0;
+    /// True while both outputs are forced low
+    volatile bool mIsShutdown = true;
+
+}; // End class ComplementaryPwm
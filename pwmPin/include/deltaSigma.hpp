@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Delta-sigma modulator for PWM levels.
+ *
+ * Chooses a whole-tick level for each PWM period so the average duty
+ * matches a duty cycle finer than one counter tick.  The rounding error
+ * is fed back (first order) or fed back twice (second order), which
+ * pushes the dither noise up towards the PWM frequency where it is
+ * easily filtered.
+ *
+ * Has no SDK dependencies; DitheredPwm feeds its output to a slice with
+ * DMA.
+ */
+class DeltaSigma
+{
+public:
+
+    /// 100% duty (Q24 fixed point)
+    static constexpr uint32_t DUTY_FULL = 1u << 24;
+
+    /**
+     * @brief Noise shaping order
+     */
+    enum class Order
+    {
+        /// Error fed back once; noise rises 20dB/decade
+        First,
+        /// Error fed back twice; noise rises 40dB/decade
+        Second
+    };
+
+    /**
+     * @brief Construct a DeltaSigma modulator
+     *
+     * @param order - Noise shaping order
+     */
+    DeltaSigma(const Order order = Order::Second);
+
+    /**
+     * @brief Set the counter period
+     *
+     * @param ticks - Ticks per period (wrap + 1), up to 65535
+     */
+    void setPeriod(const uint32_t ticks);
+
+    /**
+     * @brief Set the average duty cycle
+     *
+     * @param duty - Duty cycle, 0 - DUTY_FULL (Q24 fixed point)
+     */
+    void setDuty(const uint32_t duty);
+
+    /**
+     * @brief Get the average duty cycle
+     *
+     * @return uint32_t - Duty cycle, 0 - DUTY_FULL (Q24 fixed point)
+     */
+    uint32_t getDuty()
+    { return mDuty; }
+
+    /**
+     * @brief Clear the modulator's error history
+     */
+    void reset();
+
+    /**
+     * @brief Get the level for the next period
+     *
+     * @return uint32_t - High time, 0 - ticks per period
+     */
+    uint32_t next();
+
+    /**
+     * @brief Fill a buffer with compare register values for the next periods
+     *
+     * @param pOut - Buffer
+     * @param count - Number of periods
+     * @param shift - Position of the level in each value (0 or 16)
+     * @param base - Bits to keep in each value (the other channel)
+     */
+    void fill(uint32_t* pOut, const size_t count, const uint32_t shift, const uint32_t base);
+
+    /**
+     * @brief Fill a buffer with a pattern to be played in a loop
+     *
+     * Starts from a cleared history and corrects the pattern so its
+     * average is as close to the duty as count periods allow (within
+     * 1 / (2 * count) ticks).
+     *
+     * @param pOut - Buffer
+     * @param count - Number of periods
+     * @param shift - Position of the level in each value (0 or 16)
+     * @param base - Bits to keep in each value (the other channel)
+     */
+    void fillLoop(uint32_t* pOut, const size_t count, const uint32_t shift, const uint32_t base);
+
+private:
+
+    /// Noise shaping order
+    Order mOrder;
+    /// Ticks per period
+    uint32_t mTicks = 1;
+    /// Duty cycle (Q24)
+    uint32_t mDuty = 0;
+    /// Target level, Q24 ticks
+    int64_t mTarget = 0;
+    /// Last error, Q24 ticks
+    int64_t mErr1 = 0;
+    /// Error before last, Q24 ticks
+    int64_t mErr2 = 0;
+
+}; // End class DeltaSigma
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <pico/stdlib.h>
+
+#include "deltaSigma.hpp"
+#include "pwmPin.hpp"
+#include "pwmSequencer.hpp"
+
+/**
+ * @brief PWM pin with duty resolution finer than one counter tick.
+ *
+ * A DeltaSigma modulator picks each period's level and a PwmSequencer
+ * writes it to the slice, so the carrier stays at the pin's frequency
+ * while the average duty has up to 24 bits of resolution.
+ *
+ * Loop mode plays a pattern of levels with no CPU time at all; a duty
+ * change builds a new pattern in the other half of the buffer and swaps
+ * to it.  Stream mode runs the modulator continuously from the DMA
+ * interrupt, one buffer half at a time, so duty changes never restart a
+ * pattern.
+ *
+ * The sequencer writes the whole compare register, so the other pin of
+ * the slice holds the level it had when dithering started.
+ */
+class DitheredPwm
+{
+public:
+
+    /**
+     * @brief How levels are fed to the slice
+     */
+    enum class Mode
+    {
+        /// Looped pattern, no CPU time
+        Loop,
+        /// Modulator refills a double buffer from the DMA interrupt
+        Stream
+    };
+
+    /**
+     * @brief Construct a DitheredPwm object
+     *
+     * @param pin - Pin to dither, at its final frequency
+     * @param pBuf - Buffer, split in two halves
+     * @param size - Entries in buffer (even); in Loop mode each half is one
+     *               pattern, so longer halves give finer average duty
+     * @param order - Noise shaping order
+     * @param mode - Loop or Stream
+     */
+    DitheredPwm
+    (
+        PwmPin& pin,
+        uint32_t* pBuf,
+        const size_t size,
+        const DeltaSigma::Order order = DeltaSigma::Order::Second,
+        const Mode mode = Mode::Loop
+    );
+
+    /**
+     * @brief Start dithering
+     *
+     * @param duty - Duty cycle, 0 - DeltaSigma::DUTY_FULL (Q24 fixed point)
+     * @return true if started, false if the buffer is too small
+     */
+    bool start(const uint32_t duty);
+
+    /**
+     * @brief Change the duty cycle
+     *
+     * @param duty - Duty cycle, 0 - DeltaSigma::DUTY_FULL (Q24 fixed point)
+     * @return true if set, false if not started
+     */
+    bool setDuty(const uint32_t duty);
+
+    /**
+     * @brief Get the duty cycle
+     *
+     * @return uint32_t - Duty cycle, 0 - DeltaSigma::DUTY_FULL (Q24)
+     */
+    uint32_t getDuty()
+    { return mDuty; }
+
+    /**
+     * @brief Stop dithering, leaving the last level
+     */
+    void stop();
+
+private:
+
+    /**
+     * @brief Stream refill callback
+     */
+    static void refill(uint32_t* pBuf, size_t size, void* pCtx);
+
+    /**
+     * @brief Compare register bits of the other channel
+     */
+    uint32_t getBase();
+
+    /// Pin being dithered
+    PwmPin& mPin;
+    /// Feeds the compare register
+    PwmSequencer mSequencer;
+    /// Chooses levels
+    DeltaSigma mModulator;
+    /// Buffer
+    uint32_t* mpBuf;
+    /// Entries in each half of buffer
+    size_t mHalfSize;
+    /// Loop or Stream
+    Mode mMode;
+    /// Position of the pin's level in the compare register
+    uint32_t mShift;
+    /// Half of buffer playing (Loop mode)
+    size_t mHalf = 0;
+    /// Compare register bits of the other channel
+    uint32_t mBase = 0;
+    /// Duty cycle (Q24)
+    volatile uint32_t mDuty = 0;
+    /// True while running
+    bool mIsRunning = false;
+
+}; // End class DitheredPwm
@@ -0,0 +1,200 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Gamma-corrected fades for many LED channels.
+ *
+ * Levels are perceived brightness, 0 - LEVEL_FULL (Q16).  Each tick()
+ * moves every active fade one step along its easing curve and sends the
+ * gamma-corrected duty (0 - LEVEL_FULL, same scale as
+ * PwmPin::setDutyFrac) to the channel's output function.  Easing and
+ * gamma curves are tables built at compile time.
+ *
+ * Active channels are kept on a list, so a tick costs O(active fades).
+ * Channel storage is supplied by the caller; nothing is allocated.
+ *
+ * Has no SDK dependencies and isn't thread safe: on the Pico,
+ * LedFaderTimer calls tick() from a repeating timer and locks around it.
+ */
+class LedFader
+{
+public:
+
+    /// Full brightness / 100% duty (Q16 fixed point)
+    static constexpr uint32_t LEVEL_FULL = 1u << 16;
+
+    /**
+     * @brief Shape of a fade over time
+     */
+    enum class Easing
+    {
+        /// Constant rate
+        Linear,
+        /// Slow start (quadratic)
+        EaseIn,
+        /// Slow finish (quadratic)
+        EaseOut,
+        /// Slow start and finish (smoothstep)
+        EaseInOut
+    };
+
+    /**
+     * @brief Send a duty cycle to an LED
+     *
+     * @param pCtx - Context given to attach()
+     * @param duty - Duty cycle, 0 - LEVEL_FULL (Q16 fixed point)
+     */
+    typedef void (*OutputFunc)(void* pCtx, uint32_t duty);
+
+    /**
+     * @brief State of one LED; storage for LedFader, not used directly
+     */
+    struct Channel
+    {
+        /// Output function, nullptr if not attached
+        OutputFunc pOutput;
+        /// Output context
+        void* pCtx;
+        /// Next active channel
+        Channel* pNext;
+        /// Current level
+        uint32_t level;
+        /// Fade start level
+        uint32_t from;
+        /// Fade end level
+        uint32_t to;
+        /// Fade progress, Q24 (1 << 24 = done)
+        uint32_t pos;
+        /// Progress per tick, Q24
+        uint32_t step;
+        /// Ticks left in fade
+        uint32_t ticksLeft;
+        /// Fade curve
+        Easing easing;
+        /// True while on the active list
+        bool isActive;
+    };
+
+    /**
+     * @brief Construct a LedFader
+     *
+     * @param pChannels - Storage for count channels
+     * @param count - Number of channels
+     */
+    LedFader(Channel* pChannels, const size_t count);
+
+    /**
+     * @brief Connect a channel to an output and set it dark
+     *
+     * @param channel - Channel number
+     * @param pOutput - Output function
+     * @param pCtx - Passed to pOutput
+     * @return true if attached, false if channel invalid
+     */
+    bool attach(const size_t channel, const OutputFunc pOutput, void* pCtx);
+
+    /**
+     * @brief Set a channel's level now, cancelling any fade
+     *
+     * @param channel - Channel number
+     * @param level - Brightness, 0 - LEVEL_FULL
+     * @return true if set, false if channel invalid or not attached
+     */
+    bool set(const size_t channel, const uint32_t level);
+
+    /**
+     * @brief Fade a channel from its current level
+     *
+     * @param channel - Channel number
+     * @param level - Final brightness, 0 - LEVEL_FULL
+     * @param ticks - Duration in ticks (0 sets the level now)
+     * @param easing - Fade curve
+     * @return true if started, false if channel invalid or not attached
+     */
+    bool fade
+    (
+        const size_t channel,
+        const uint32_t level,
+        const uint32_t ticks,
+        const Easing easing = Easing::EaseInOut
+    );
+
+    /**
+     * @brief Stop a fade, leaving the channel at its current level
+     *
+     * @param channel - Channel number
+     * @return true if stopped, false if channel invalid
+     */
+    bool stop(const size_t channel);
+
+    /**
+     * @brief Advance all active fades by one tick
+     */
+    void tick();
+
+    /**
+     * @brief Get a channel's current level
+     *
+     * @param channel - Channel number
+     * @return uint32_t - Brightness, 0 - LEVEL_FULL (0 if channel invalid)
+     */
+    uint32_t getLevel(const size_t channel);
+
+    /**
+     * @brief Check if a channel is fading
+     *
+     * @param channel - Channel number
+     * @return true if fading
+     */
+    bool isFading(const size_t channel);
+
+    /**
+     * @brief Get the number of fades in progress
+     *
+     * @return size_t - Active fades
+     */
+    size_t getActiveCount()
+    { return mActiveCount; }
+
+    /**
+     * @brief Convert brightness to duty cycle (gamma 2.2)
+     *
+     * @param level - Brightness, 0 - LEVEL_FULL
+     * @return uint32_t - Duty cycle, 0 - LEVEL_FULL
+     */
+    static uint32_t gamma(const uint32_t level);
+
+    /**
+     * @brief Apply an easing curve to fade progress
+     *
+     * @param easing - Fade curve
+     * @param t - Progress, 0 - LEVEL_FULL
+     * @return uint32_t - Eased progress, 0 - LEVEL_FULL
+     */
+    static uint32_t ease(const Easing easing, const uint32_t t);
+
+private:
+
+    /**
+     * @brief Send a channel's level to its output
+     */
+    static void output(Channel& chan)
+    { chan.pOutput(chan.pCtx, gamma(chan.level)); }
+
+    /**
+     * @brief Take a channel off the active list
+     */
+    void deactivate(Channel& chan);
+
+    /// Channel storage
+    Channel* mpChannels;
+    /// Number of channels
+    size_t mCount;
+    /// First active channel
+    Channel* mpActive = nullptr;
+    /// Number of active channels
+    size_t mActiveCount = 0;
+
+}; // End class LedFader
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <pico/stdlib.h>
+#include <pico/sync.h>
+
+#include "ledFader.hpp"
+
+class PwmPin;
+
+/**
+ * @brief Run a LedFader from a repeating timer.
+ *
+ * The fader ticks in the timer's alarm interrupt.  Fades are started
+ * through this class, which holds a critical section around each call, so
+ * they can be started from either core.
+ */
+class LedFaderTimer
+{
+public:
+
+    /**
+     * @brief Construct LedFaderTimer object
+     *
+     * @param fader - Fader to tick
+     */
+    LedFaderTimer(LedFader& fader);
+
+    /**
+     * @brief Stop the timer
+     */
+    ~LedFaderTimer();
+
+    /**
+     * @brief Start ticking
+     *
+     * @param periodUs - Tick period (us)
+     * @return true if started, false if no alarm slot free
+     */
+    bool start(const uint32_t periodUs);
+
+    /**
+     * @brief Stop ticking
+     */
+    void stop();
+
+    /**
+     * @brief Attach a PwmPin to a fader channel
+     *
+     * @param channel - Channel number
+     * @param pPin - PwmPin driven by setDutyFrac
+     * @return true if attached, false if channel invalid
+     */
+    bool attachPin(const size_t channel, PwmPin* pPin);
+
+    /**
+     * @brief Start a fade (see LedFader::fade)
+     */
+    bool fade
+    (
+        const size_t channel,
+        const uint32_t level,
+        const uint32_t ticks,
+        const LedFader::Easing easing = LedFader::Easing::EaseInOut
+    );
+
+    /**
+     * @brief Set a level now (see LedFader::set)
+     */
+    bool set(const size_t channel, const uint32_t level);
+
+    /**
+     * @brief Output function for PwmPin channels
+     *
+     * @param pCtx - PwmPin
+     * @param duty - Duty cycle, 0 - LedFader::LEVEL_FULL
+     */
+    static void pwmOutput(void* pCtx, uint32_t duty);
+
+private:
+
+    /**
+     * @brief Repeating timer callback
+     */
+    static bool onTimer(repeating_timer_t* pTimer);
+
+    /// Fader being ticked
+    LedFader& mFader;
+    /// Repeating timer
+    repeating_timer_t mTimer;
+    /// True while the timer is running
+    bool mIsRunning = false;
+    /// Guards the fader between callers and the timer
+    critical_section_t mLock;
+
+}; // End class LedFaderTimer
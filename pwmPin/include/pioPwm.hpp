@@ -0,0 +1,196 @@
+#pragma once
+
+#include <hardware/pio.h>
+#include <pico/stdlib.h>
+
+#include "pioPwmTable.hpp"
+
+/**
+ * @brief PWM on up to 32 consecutive pins from one PIO state machine.
+ *
+ * Every pin shares the state machine's period, counted in system clocks,
+ * and has its own high time.  The state machine plays a PioPwmTable of
+ * segments; a pair of DMA channels feeds the table to its TX FIFO and
+ * restarts it every period, so running costs no CPU time at all.
+ *
+ * Level changes build a new table and swap the pointer the DMA control
+ * channel reloads from, so they take effect at the start of the next
+ * period and a period never mixes two tables.  There are three tables, so
+ * one is always free of both the table being read and the one waiting to
+ * be loaded; a change never waits for the DMA, however many are made in
+ * a period (the last one made is the one played).
+ *
+ * Each engine takes a state machine and two DMA channels; the program is
+ * loaded once per PIO and shared.  See PioPwmPin for a PwmPin-like
+ * interface to one pin.
+ */
+class PioPwm
+{
+public:
+
+    /**
+     * @brief Construct a PioPwm object, pins low and stopped
+     *
+     * @param pio - PIO block (pio0 or pio1)
+     * @param basePin - First GPIO
+     * @param pinCount - Number of consecutive GPIOs, 1 - PioPwmTable::MAX_PINS
+     * @param initFreq - Initial frequency (Hz)
+     */
+    PioPwm(PIO pio, const uint basePin, const uint pinCount, const uint32_t initFreq = 1000);
+
+    /**
+     * @brief Stop and release the state machine, DMA channels and program
+     */
+    ~PioPwm();
+
+    // The DMA control channel holds the address of mpActive
+    PioPwm(const PioPwm&) = delete;
+    PioPwm& operator=(const PioPwm&) = delete;
+
+    /**
+     * @brief Start the state machine
+     */
+    void start();
+
+    /**
+     * @brief Stop the state machine and drive every pin low
+     */
+    void stop();
+
+    /**
+     * @brief Get whether the state machine runs
+     *
+     * @return true if running
+     */
+    bool isRunning()
+    { return mIsRunning; }
+
+    /**
+     * @brief Set the frequency of every pin
+     *
+     * Each pin keeps its duty cycle.
+     *
+     * @param freq - Frequency (Hz)
+     * @return true if set, false if the period is under
+     *         PioPwmTable::getMinPeriod clocks (settings unchanged)
+     */
+    bool setFreq(const uint32_t freq);
+
+    /**
+     * @brief Get the frequency
+     *
+     * @return uint32_t - Requested frequency (Hz)
+     */
+    uint32_t getFreq()
+    { return mFreq; }
+
+    /**
+     * @brief Get the frequency the state machine actually runs at
+     *
+     * @return uint32_t - Achieved frequency, rounded (Hz)
+     */
+    uint32_t getActualFreq()
+    { return (mClockFreq + mPeriod / 2) / mPeriod; }
+
+    /**
+     * @brief Get the period
+     *
+     * @return uint32_t - Period (clocks)
+     */
+    uint32_t getPeriod()
+    { return mPeriod; }
+
+    /**
+     * @brief Get the system clock the period was worked out from
+     *
+     * @return uint32_t - Clock frequency (Hz)
+     */
+    uint32_t getClockFreq()
+    { return mClockFreq; }
+
+    /**
+     * @brief Get the number of pins
+     */
+    uint getPinCount()
+    { return mPinCount; }
+
+    /**
+     * @brief Get the first GPIO
+     */
+    uint getBasePin()
+    { return mBasePin; }
+
+    /**
+     * @brief Set the high time of one pin
+     *
+     * @param index - Pin, 0 - pin count - 1
+     * @param level - High time (clocks), 0 - period (period is always on)
+     * @return true if set, false if index or level invalid
+     */
+    bool setLevel(const uint index, const uint32_t level);
+
+    /**
+     * @brief Set the high time of every pin in one update
+     *
+     * @param pLevels - High times (clocks), one per pin
+     * @return true if set, false if a level is over the period (none set)
+     */
+    bool setLevels(const uint32_t* pLevels);
+
+    /**
+     * @brief Get the high time of one pin
+     *
+     * @param index - Pin, 0 - pin count - 1
+     * @return uint32_t - High time (clocks)
+     */
+    uint32_t getLevel(const uint index)
+    { return (index < mPinCount) ? mLevels[index] : 0; }
+
+private:
+
+    /**
+     * @brief Build a table from mLevels and swap it in
+     *
+     * Builds into the table that is neither mpActive nor under the data
+     * channel's read address.
+     */
+    void publish();
+
+    /// Words in one table, plus one so the tables' ranges don't touch
+    static constexpr size_t TABLE_STRIDE = PioPwmTable::getSize(PioPwmTable::MAX_PINS) + 1;
+
+    /// Program offset in each PIO, -1 if not loaded
+    static int sOffset[NUM_PIOS];
+    /// Engines using the program in each PIO
+    static uint sUsers[NUM_PIOS];
+
+    /// PIO block
+    PIO mpPio;
+    /// State machine
+    uint mSm;
+    /// First GPIO
+    uint mBasePin;
+    /// Number of pins
+    uint mPinCount;
+    /// Feeds the table to the TX FIFO
+    uint mDataChan;
+    /// Restarts the data channel from mpActive
+    uint mCtrlChan;
+    /// State machine configuration
+    pio_sm_config mConfig;
+    /// System clock (Hz)
+    uint32_t mClockFreq;
+    /// Requested frequency (Hz)
+    uint32_t mFreq = 0;
+    /// Period (clocks)
+    uint32_t mPeriod = 0;
+    /// High time of each pin (clocks)
+    uint32_t mLevels[PioPwmTable::MAX_PINS] = {};
+    /// Tables: one being read, one waiting to be loaded and one to build in
+    uint32_t mTables[3][TABLE_STRIDE] = {};
+    /// Table the control channel loads next period
+    uint32_t* volatile mpActive;
+    /// True while running
+    bool mIsRunning = false;
+
+}; // End class PioPwm
@@ -0,0 +1,164 @@
+#pragma once
+
+#include "pioPwm.hpp"
+
+/**
+ * @brief One pin of a PioPwm engine, with the PwmPin interface.
+ *
+ * Ticks are system clocks and the wrap value is the period less one, so
+ * code written against PwmPin drives PIO pins unchanged.  Every pin of an
+ * engine shares its frequency; setFreq on any of them changes them all,
+ * and each keeps its duty cycle.
+ */
+class PioPwmPin
+{
+public:
+
+    /// 100% duty for setDutyFrac (Q16 fixed point)
+    static constexpr uint32_t DUTY_FULL = 1u << 16;
+
+    /**
+     * @brief Construct PioPwmPin object.
+     *
+     * @param engine - Engine driving the pin
+     * @param index - Pin of the engine, 0 - pin count - 1
+     * @param initDuty - Initial duty cycle (percent)
+     */
+    PioPwmPin(PioPwm& engine, const uint index, const uint8_t initDuty = 0);
+
+    /**
+     * @brief Enable/Disable the engine (Effects every pin of the engine)
+     *
+     * @param shouldEnable - If true start engine, if false stop it
+     */
+    void enablePin(const bool shouldEnable = true)
+    { shouldEnable ? mEngine.start() : mEngine.stop(); }
+
+    /**
+     * @brief Set frequency (Effects every pin of the engine)
+     *
+     * @param freq - Frequency (Hz)
+     * @return true if freq reachable, false if not (settings unchanged)
+     */
+    bool setFreq(const uint32_t freq)
+    { return mEngine.setFreq(freq); }
+
+    /**
+     * @brief Get frequency
+     *
+     * @return uint32_t - Requested frequency (Hz)
+     */
+    uint32_t getFreq()
+    { return mEngine.getFreq(); }
+
+    /**
+     * @brief Get the frequency the engine actually runs at
+     *
+     * @return uint32_t - Achieved frequency, rounded (Hz)
+     */
+    uint32_t getActualFreq()
+    { return mEngine.getActualFreq(); }
+
+    /**
+     * @brief Get the counter wrap value
+     *
+     * @return uint32_t - Wrap value; a period is wrap + 1 clocks
+     */
+    uint32_t getWrap()
+    { return mEngine.getPeriod() - 1; }
+
+    /**
+     * @brief Set duty cycle of pin
+     *
+     * @param percent - Duty cycle 0 - 100
+     */
+    void setDuty(const uint8_t percent)
+    {
+        if(percent <= 100)
+        {
+            setDutyFrac((percent * DUTY_FULL + 50) / 100);
+            mDuty = percent;
+        }
+    }
+
+    /**
+     * @brief Get duty cycle of pin
+     *
+     * @return uint8_t - Duty cycle (%)
+     */
+    uint8_t getDuty()
+    { return mDuty; }
+
+    /**
+     * @brief Set duty cycle of pin in clocks
+     *
+     * @param ticks - High time, 0 - wrap + 1 (wrap + 1 is always on)
+     * @return true if ticks valid, false if invalid
+     */
+    bool setDutyTicks(const uint32_t ticks)
+    {
+        if(!mEngine.setLevel(mIndex, ticks))
+        {
+            return false;
+        }
+
+        mDutyFrac = (static_cast<uint64_t>(ticks) << 16) / mEngine.getPeriod();
+        mDuty = (mDutyFrac * 100 + DUTY_FULL / 2) >> 16;
+        return true;
+    }
+
+    /**
+     * @brief Get duty cycle of pin in clocks
+     *
+     * @return uint32_t - High time (clocks)
+     */
+    uint32_t getDutyTicks()
+    { return mEngine.getLevel(mIndex); }
+
+    /**
+     * @brief Set duty cycle of pin as a fraction
+     *
+     * @param frac - Duty cycle, 0 - DUTY_FULL (Q16 fixed point)
+     */
+    void setDutyFrac(const uint32_t frac)
+    {
+        mDutyFrac = (frac < DUTY_FULL) ? frac : DUTY_FULL;
+        mDuty = (mDutyFrac * 100 + DUTY_FULL / 2) >> 16;
+
+        mEngine.setLevel(mIndex, (static_cast<uint64_t>(mEngine.getPeriod()) * mDutyFrac) >> 16);
+    }
+
+    /**
+     * @brief Get duty cycle of pin as a fraction
+     *
+     * @return uint32_t - Duty cycle, 0 - DUTY_FULL (Q16 fixed point)
+     */
+    uint32_t getDutyFrac()
+    { return mDutyFrac; }
+
+    /**
+     * @brief Get the system clock the engine's period was worked out from
+     *
+     * @return uint32_t - Clock frequency (Hz)
+     */
+    uint32_t getClockFreq()
+    { return mEngine.getClockFreq(); }
+
+    /**
+     * @brief Get GPIO of pin
+     */
+    uint getGpio()
+    { return mEngine.getBasePin() + mIndex; }
+
+private:
+
+    /// Engine driving the pin
+    PioPwm& mEngine;
+    /// Pin of the engine
+    uint mIndex;
+    /// Duty cycle (%)
+    uint8_t mDuty = 0;
+    /// Duty cycle (Q16)
+    uint32_t mDutyFrac = 0;
+
+}; // End class PioPwmPin
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+ * @brief PIO program run by PioPwm, hand encoded so the host PIO model in
+ *        pwmPin/sim runs exactly the same instructions.
+ *
+ *        0: out pins, 32     ; levels of every pin for this segment
+ *        1: out x, 32        ; segment length - SEGMENT_OVERHEAD
+ *        2: jmp x--, 2       ; one clock per count, plus one
+ *           (wrap to 0)
+ *
+ * Autopull with a threshold of 32 feeds a pair of words per segment from
+ * the TX FIFO, so a segment lasts x + 3 clocks and the pins change on the
+ * clock its first instruction runs.  The jump target is relative to the
+ * program, as pio_add_program expects.
+ */
+namespace PioPwmProgram
+{
+
+/// Instructions
+constexpr uint16_t INSTRUCTIONS[] =
+{
+    0x6000, // out pins, 32
+    0x6020, // out x, 32
+    0x0042  // jmp x--, 2
+};
+
+/// Number of instructions
+constexpr uint32_t LENGTH = sizeof(INSTRUCTIONS) / sizeof(INSTRUCTIONS[0]);
+/// First instruction after wrap
+constexpr uint32_t WRAP_TARGET = 0;
+/// Instruction that wraps
+constexpr uint32_t WRAP = 2;
+/// Clocks in a segment beyond its count
+constexpr uint32_t SEGMENT_OVERHEAD = 3;
+
+} // End namespace PioPwmProgram
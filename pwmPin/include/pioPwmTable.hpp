@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "pioPwmProgram.hpp"
+
+/**
+ * @brief Build the segment table PioPwm's state machine plays each period.
+ *
+ * A period is split into segments at the falling edges of the pins: every
+ * pin with a level above zero goes high at the start, and each segment
+ * after that drops the pins whose level it starts at.  Each segment is a
+ * pair of words, the pin levels and the segment length less
+ * PioPwmProgram::SEGMENT_OVERHEAD.
+ *
+ * The table always has one segment more than pins, so DMA can replay it
+ * with a fixed transfer count; when pins share an edge the longest
+ * segments are split in two, with the same pin levels.  A segment lasts at
+ * least SEGMENT_OVERHEAD clocks, so edges closer than that are merged:
+ * an edge within that of the one before moves back to it, and one within
+ * that of the end of the period moves to the end (error under
+ * SEGMENT_OVERHEAD clocks).
+ *
+ * Has no SDK dependencies; the host model in pwmPin/sim plays the same
+ * tables.
+ */
+class PioPwmTable
+{
+public:
+
+    /// Most pins one state machine drives
+    static constexpr uint32_t MAX_PINS = 32;
+
+    /**
+     * @brief Get the table size
+     *
+     * @param pinCount - Number of pins
+     * @return size_t - Words in table
+     */
+    static constexpr size_t getSize(const uint32_t pinCount)
+    { return 2 * (pinCount + 1); }
+
+    /**
+     * @brief Get the shortest period a table can have
+     *
+     * @param pinCount - Number of pins
+     * @return uint32_t - Period (clocks)
+     */
+    static constexpr uint32_t getMinPeriod(const uint32_t pinCount)
+    { return 2 * PioPwmProgram::SEGMENT_OVERHEAD * (pinCount + 1); }
+
+    /**
+     * @brief Build a table
+     *
+     * @param pLevels - High time of each pin (clocks, period or more is
+     *                  always high)
+     * @param pinCount - Number of pins, up to MAX_PINS
+     * @param period - Period (clocks), at least getMinPeriod
+     * @param pTable - Table, getSize(pinCount) words
+     * @return true if built, false if pinCount or period invalid
+     */
+    static bool build
+    (
+        const uint32_t* pLevels,
+        const uint32_t pinCount,
+        const uint32_t period,
+        uint32_t* pTable
+    );
+
+}; // End class PioPwmTable
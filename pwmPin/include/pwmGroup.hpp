@@ -0,0 +1,199 @@
+#pragma once
+
+#include <cstdint>
+
+#include "pwmHal.hpp"
+#include "pwmPin.hpp"
+
+/**
+ * @brief Drive a set of PWM pins, across slices, in step.
+ *
+ * Pins in a group stage their duty setters instead of writing the compare
+ * register; update() then writes every slice's compare register straight
+ * after a wrap, so all of them latch at the end of the same period.  Both
+ * pins of a slice always share a frequency, so the frequency is set
+ * through the group (PwmPin::setFreq fails for a pin whose sibling is in
+ * the group).
+ *
+ * Frequency changes are staged too.  update() writes each slice's TOP
+ * together with its compare register, so the two latch at the same wrap,
+ * and writes the divider (which applies as soon as it is written) once
+ * that wrap has happened, so no period mixes old and new settings.
+ *
+ * Slices are started and stopped with a single write to the enable
+ * register, so their counters stay aligned, apart from any phase offset
+ * set with setPhase (trailing-edge slices only).
+ */
+class PwmGroup
+{
+public:
+
+    /**
+     * @brief Construct an empty PwmGroup
+     */
+    PwmGroup();
+
+    /**
+     * @brief Remove all pins from the group
+     */
+    ~PwmGroup();
+
+    /**
+     * @brief Add a pin to the group
+     *
+     * @param pin - Pin to add; it leaves the group when destroyed
+     * @return true if added, false if the pin is already in a group or its
+     *         sibling is in this group at a different frequency or mode
+     */
+    bool add(PwmPin& pin);
+
+    /**
+     * @brief Remove a pin from the group
+     *
+     * The pin's staged level is written to its compare register.
+     *
+     * @param pin - Pin to remove
+     * @return true if removed, false if the pin isn't in the group
+     */
+    bool remove(PwmPin& pin);
+
+    /**
+     * @brief Check if the other pin of a pin's slice is in the group
+     *
+     * @param pin - Pin to check
+     * @return true if the sibling is in the group
+     */
+    bool hasSibling(const PwmPin& pin) const
+    { return mpPins[pin.mSlice][pin.mChan ^ 1] != nullptr; }
+
+    /**
+     * @brief Set the frequency of every slice in the group
+     *
+     * Each pin keeps its duty cycle; the new levels are written with
+     * update() before returning.
+     *
+     * @param freq - Frequency (Hz)
+     * @return true if freq reachable, false if not (settings unchanged)
+     */
+    bool setFreq(const uint32_t freq);
+
+    /**
+     * @brief Set the frequency of one pin's slice (both pins)
+     *
+     * Each pin keeps its duty cycle; call update() to apply the new
+     * frequency and levels.
+     *
+     * @param pin - Pin in the group
+     * @param freq - Frequency (Hz)
+     * @return true if set, false if freq not reachable or pin not in group
+     */
+    bool setSliceFreq(PwmPin& pin, const uint32_t freq);
+
+    /**
+     * @brief Set the phase offset of a pin's slice
+     *
+     * Takes effect at the next start().  Trailing-edge slices only: the
+     * direction of a phase-correct counter can't be set, so those slices
+     * refuse an offset and always start from 0.
+     *
+     * @param pin - Pin in the group
+     * @param frac - Delay, 0 - PwmPin::DUTY_FULL of a period (Q16)
+     * @return true if set, false if pin not in group, or phase-correct and
+     *         frac not 0
+     */
+    bool setPhase(PwmPin& pin, const uint32_t frac);
+
+    /**
+     * @brief Write all staged levels so they take effect together
+     *
+     * Waits for a wrap of the first running slice, then writes each slice's
+     * compare register with a single store, after its TOP if the frequency
+     * changed.  Slices at the same frequency and phase all switch at the
+     * end of that period; a slice with a phase offset switches at its own
+     * next wrap.  A changed divider is written as each slice reaches that
+     * wrap, so update() then waits up to one more period.
+     */
+    void update();
+
+    /**
+     * @brief Start all slices in the group together
+     *
+     * Counters are reset to their phase offsets and the slices enabled with
+     * a single write.
+     */
+    void start();
+
+    /**
+     * @brief Stop all slices in the group together
+     */
+    void stop();
+
+    /**
+     * @brief Get the slices used by the group
+     *
+     * @return uint32_t - Bit per slice
+     */
+    uint32_t getSliceMask()
+    { return mSliceMask; }
+
+private:
+
+    friend class PwmPin;
+
+    /**
+     * @brief Check if a pin is in this group
+     */
+    bool isMember(const PwmPin& pin) const
+    { return mpPins[pin.mSlice][pin.mChan] == &pin; }
+
+    /**
+     * @brief Build a slice's compare register value from its pins
+     *
+     * @param slice - PWM generator
+     * @return uint32_t - Compare register value
+     */
+    uint32_t getSliceLevels(const uint slice);
+
+    /**
+     * @brief Get a pin of a slice in the group
+     *
+     * @param slice - PWM generator with a pin in the group
+     * @return PwmPin* - Channel A's pin if in the group, else channel B's
+     */
+    PwmPin* getSlicePin(const uint slice) const
+    {
+        return (mpPins[slice][PwmHal::CHAN_A] != nullptr) ?
+                mpPins[slice][PwmHal::CHAN_A] : mpPins[slice][PwmHal::CHAN_B];
+    }
+
+    /**
+     * @brief Mark a slice's divider and wrap as changed, for update()
+     *
+     * @param slice - PWM generator
+     */
+    void stageFreq(const uint slice)
+    { mFreqMask |= 1u << slice; }
+
+    /**
+     * @brief Wait for each of a set of running slices to wrap once
+     *
+     * The counters are polled rather than the interrupt flags, which an
+     * interrupt handler may clear.  A trailing-edge slice has wrapped when
+     * its count drops; a phase-correct one when its count turns from
+     * falling to rising, at zero.
+     *
+     * @param mask - Bit per slice
+     * @param shouldWriteDiv - Write each slice's divider as soon as it wraps
+     */
+    void waitForWrap(const uint32_t mask, const bool shouldWriteDiv);
+
+    /// Pins in the group by slice and channel
+    PwmPin* mpPins[PwmHal::NUM_SLICES][2];
+    /// Phase offset of each slice (Q16 fraction of a period)
+    uint32_t mPhase[PwmHal::NUM_SLICES];
+    /// Bit per slice with a pin in the group
+    uint32_t mSliceMask = 0;
+    /// Bit per slice whose divider and wrap update() has to write
+    uint32_t mFreqMask = 0;
+
+}; // End class PwmGroup
@@ -0,0 +1,23 @@
+#pragma once
+
+/**
+ * @brief PWM backend used by PwmPin and PwmGroup.
+ *
+ * The backend is picked when compiling: the Pico SDK by default, or the
+ * host model of the PWM block (pwmPin/sim) when PWM_HAL_SIM is defined.
+ * Both put the same inline functions in namespace PwmHal, so the drivers
+ * compile to the same register accesses as calling the SDK directly.
+ *
+ * Functions (backend headers hold the definitions):
+ *  - gpioToSlice, gpioToChannel, setPwmFunction
+ *  - setDiv, setWrap, getWrap, setPhaseCorrect, setEnabled
+ *  - getCc, writeMasked, writeCc, readCc
+ *  - getCounter, setCounter
+ *  - getEnabledMask, enableMask, disableMask
+ *  - getClockHz
+ */
+#if defined(PWM_HAL_SIM)
+#include "pwmHalSim.hpp"
+#else
+#include "pwmHalPico.hpp"
+#endif
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <pico/stdlib.h>
+#include <hardware/address_mapped.h>
+#include <hardware/clocks.h>
+#include <hardware/pwm.h>
+
+/**
+ * @brief Pico SDK backend for PwmHal.
+ */
+namespace PwmHal
+{
+
+/// A PWM register
+typedef io_rw_32 Reg;
+
+/// Number of PWM generators
+constexpr uint NUM_SLICES = NUM_PWM_SLICES;
+/// Channel A
+constexpr uint CHAN_A = PWM_CHAN_A;
+/// Channel B
+constexpr uint CHAN_B = PWM_CHAN_B;
+/// Position of channel A level in compare register
+constexpr uint CC_A_LSB = PWM_CH0_CC_A_LSB;
+/// Position of channel B level in compare register
+constexpr uint CC_B_LSB = PWM_CH0_CC_B_LSB;
+/// Bits of channel A level in compare register
+constexpr uint32_t CC_A_BITS = PWM_CH0_CC_A_BITS;
+/// Bits of channel B level in compare register
+constexpr uint32_t CC_B_BITS = PWM_CH0_CC_B_BITS;
+
+inline uint gpioToSlice(const uint gpio)
+{ return pwm_gpio_to_slice_num(gpio); }
+
+inline uint gpioToChannel(const uint gpio)
+{ return pwm_gpio_to_channel(gpio); }
+
+inline void setPwmFunction(const uint gpio)
+{ gpio_set_function(gpio, GPIO_FUNC_PWM); }
+
+/// Clock divider, 8.4 fixed point (16 = divide by 1)
+inline void setDiv(const uint slice, const uint32_t div16)
+{ pwm_set_clkdiv_int_frac(slice, div16 >> 4, div16 & 0xF); }
+
+inline void setWrap(const uint slice, const uint32_t wrap)
+{ pwm_set_wrap(slice, wrap); }
+
+inline uint32_t getWrap(const uint slice)
+{ return pwm_hw->slice[slice].top; }
+
+inline void setPhaseCorrect(const uint slice, const bool isPhaseCorrect)
+{ pwm_set_phase_correct(slice, isPhaseCorrect); }
+
+inline void setEnabled(const uint slice, const bool isEnabled)
+{ pwm_set_enabled(slice, isEnabled); }
+
+inline Reg* getCc(const uint slice)
+{ return &pwm_hw->slice[slice].cc; }
+
+inline void writeMasked(Reg* pReg, const uint32_t value, const uint32_t mask)
+{ hw_write_masked(pReg, value, mask); }
+
+inline void writeCc(const uint slice, const uint32_t cc)
+{ pwm_hw->slice[slice].cc = cc; }
+
+inline uint32_t readCc(const uint slice)
+{ return pwm_hw->slice[slice].cc; }
+
+inline uint32_t getCounter(const uint slice)
+{ return pwm_hw->slice[slice].ctr; }
+
+inline void setCounter(const uint slice, const uint32_t ctr)
+{ pwm_hw->slice[slice].ctr = ctr; }
+
+inline uint32_t getEnabledMask()
+{ return pwm_hw->en; }
+
+/// Enable slices with a single write
+inline void enableMask(const uint32_t mask)
+{ hw_set_bits(&pwm_hw->en, mask); }
+
+/// Disable slices with a single write
+inline void disableMask(const uint32_t mask)
+{ hw_clear_bits(&pwm_hw->en, mask); }
+
+inline uint32_t getClockHz()
+{ return clock_get_hz(clk_sys); }
+
+} // End namespace PwmHal
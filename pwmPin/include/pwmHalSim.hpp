@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstdint>
+
+#include "pwmSim.hpp"
+
+/**
+ * @brief Host model backend for PwmHal (see pwmPin/sim/pwmSim.hpp).
+ */
+namespace PwmHal
+{
+
+/// A PWM register
+typedef volatile uint32_t Reg;
+
+/// Number of PWM generators
+constexpr uint NUM_SLICES = PwmSim::NUM_SLICES;
+/// Channel A
+constexpr uint CHAN_A = 0;
+/// Channel B
+constexpr uint CHAN_B = 1;
+/// Position of channel A level in compare register
+constexpr uint CC_A_LSB = 0;
+/// Position of channel B level in compare register
+constexpr uint CC_B_LSB = 16;
+/// Bits of channel A level in compare register
+constexpr uint32_t CC_A_BITS = 0x0000FFFF;
+/// Bits of channel B level in compare register
+constexpr uint32_t CC_B_BITS = 0xFFFF0000;
+
+inline uint gpioToSlice(const uint gpio)
+{ return (gpio >> 1) & 7; }
+
+inline uint gpioToChannel(const uint gpio)
+{ return gpio & 1; }
+
+inline void setPwmFunction(const uint gpio)
+{ (void)gpio; }
+
+/// Clock divider, 8.4 fixed point (16 = divide by 1)
+inline void setDiv(const uint slice, const uint32_t div16)
+{ PwmSim::sSlice[slice].div = div16 & 0xFFF; }
+
+inline void setWrap(const uint slice, const uint32_t wrap)
+{ PwmSim::sSlice[slice].top = wrap & 0xFFFF; }
+
+inline uint32_t getWrap(const uint slice)
+{ return PwmSim::sSlice[slice].top; }
+
+inline void setPhaseCorrect(const uint slice, const bool isPhaseCorrect)
+{
+    PwmSim::SliceRegs& regs = PwmSim::sSlice[slice];
+    regs.csr = (regs.csr & ~PwmSim::CSR_PH_CORRECT) | (isPhaseCorrect ? PwmSim::CSR_PH_CORRECT : 0);
+}
+
+inline void setEnabled(const uint slice, const bool isEnabled)
+{ PwmSim::sEn = (PwmSim::sEn & ~(1u << slice)) | (isEnabled ? (1u << slice) : 0); }
+
+inline Reg* getCc(const uint slice)
+{ return &PwmSim::sSlice[slice].cc; }
+
+inline void writeMasked(Reg* pReg, const uint32_t value, const uint32_t mask)
+{ *pReg = (*pReg & ~mask) | (value & mask); }
+
+inline void writeCc(const uint slice, const uint32_t cc)
+{ PwmSim::sSlice[slice].cc = cc; }
+
+inline uint32_t readCc(const uint slice)
+{ return PwmSim::sSlice[slice].cc; }
+
+/// Runs the model one clock, so polling loops make progress
+inline uint32_t getCounter(const uint slice)
+{
+    PwmSim::step();
+    return PwmSim::sSlice[slice].ctr;
+}
+
+inline void setCounter(const uint slice, const uint32_t ctr)
+{ PwmSim::sSlice[slice].ctr = ctr & 0xFFFF; }
+
+inline uint32_t getEnabledMask()
+{ return PwmSim::sEn; }
+
+/// Enable slices with a single write
+inline void enableMask(const uint32_t mask)
+{ PwmSim::sEn = PwmSim::sEn | mask; }
+
+/// Disable slices with a single write
+inline void disableMask(const uint32_t mask)
+{ PwmSim::sEn = PwmSim::sEn & ~mask; }
+
+inline uint32_t getClockHz()
+{ return PwmSim::sClockHz; }
+
+} // End namespace PwmHal
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <pico/stdlib.h>
+
+/**
+ * @brief Measure the frequency and duty cycle of a signal on a PWM B pin.
+ *
+ * The slice counter is used as an input counter: counting rising edges
+ * (PWM_DIV_B_RISING) over a window gives the frequency, counting system
+ * clocks while the pin is high (PWM_DIV_B_HIGH) gives the duty cycle.
+ * The two windows alternate from an alarm callback, so results update
+ * continuously without blocking.  Signals up to half the system clock can
+ * be counted.
+ *
+ * Each window is sized from the previous result, to fill as much of the
+ * 16 bit counter as possible without overflowing it.  An overflowed
+ * window is thrown away and retried shorter.  Windows are timed with the
+ * 1us system timer, which limits precision for short windows.
+ *
+ * The whole slice is used; the A pin of the slice can't be a PWM output.
+ */
+class PwmMeasure
+{
+public:
+
+    /// 100% duty (Q16 fixed point)
+    static constexpr uint32_t DUTY_FULL = 1u << 16;
+
+    /**
+     * @brief A measurement
+     */
+    struct Result
+    {
+        /// Frequency, rounded (Hz)
+        uint32_t freq;
+        /// Rising edges counted
+        uint32_t edges;
+        /// Frequency window (us)
+        uint32_t freqWindowUs;
+        /// Duty cycle, 0 - DUTY_FULL (Q16 fixed point)
+        uint32_t duty;
+        /// Duty window (us)
+        uint32_t dutyWindowUs;
+        /// Number of results so far
+        uint32_t count;
+    };
+
+    /**
+     * @brief Construct PwmMeasure object
+     *
+     * @param gpioPin - GPIO pin number (must be a B pin, odd numbered)
+     */
+    PwmMeasure(const uint8_t gpioPin);
+
+    /**
+     * @brief Stop measuring
+     */
+    ~PwmMeasure();
+
+    /**
+     * @brief Start measuring continuously
+     *
+     * @return true if started, false if not a B pin or no alarm free
+     */
+    bool start();
+
+    /**
+     * @brief Stop measuring
+     */
+    void stop();
+
+    /**
+     * @brief Get the latest measurement
+     *
+     * @param result - Latest measurement
+     * @return true if there is one, false if none yet
+     */
+    bool getResult(Result& result);
+
+    /**
+     * @brief Set the limits for the window lengths
+     *
+     * Longer windows give more precision but slower updates.
+     *
+     * @param minUs - Shortest window (us)
+     * @param maxUs - Longest window (us)
+     * @return true if set, false if invalid
+     */
+    bool setWindowLimits(const uint32_t minUs, const uint32_t maxUs);
+
+private:
+
+    /**
+     * @brief Which count is running
+     */
+    enum class Phase
+    {
+        Freq,
+        Duty
+    };
+
+    /**
+     * @brief Reset and start the counter for a window
+     *
+     * @param phase - Count to start
+     * @param div - Clock divider (duty only)
+     */
+    void startWindow(const Phase phase, const uint32_t div);
+
+    /**
+     * @brief End the current window and start the next
+     *
+     * The SDK times a positive return from when the callback returns; a
+     * negative one would count from when this alarm was due, cutting the
+     * next window short by the callback's latency.
+     *
+     * @return int64_t - Next window length (positive, us from now)
+     */
+    int64_t onWindowEnd();
+
+    /**
+     * @brief Alarm callback
+     */
+    static int64_t onAlarm(alarm_id_t id, void* pCtx);
+
+    /// GPIO pin
+    uint8_t mPin;
+    /// PWM generator
+    uint mSlice;
+    /// Alarm ending the current window, 0 if stopped
+    alarm_id_t mAlarm = 0;
+    /// Count running in the current window
+    Phase mPhase = Phase::Freq;
+    /// Clock divider of the current duty window
+    uint32_t mDiv = 1;
+    /// Start of the current window (us)
+    uint64_t mWindowStart = 0;
+    /// Frequency window to use next (us)
+    uint32_t mFreqWindowUs;
+    /// Duty window to use next (us)
+    uint32_t mDutyWindowUs;
+    /// Shortest window (us)
+    uint32_t mMinWindowUs = 100;
+    /// Longest window (us)
+    uint32_t mMaxWindowUs = 1'000'000;
+
+    /// Result being built
+    Result mPending = {};
+    /// Sequence count of mResult; odd while being written
+    volatile uint32_t mSeq = 0;
+    /// Latest complete result
+    volatile Result mResult = {};
+
+}; // End class PwmMeasure
@@ -1,95 +1,407 @@
 #pragma once
 
-#include <pico/stdlib.h>
+#include <cstdint>
+
+#include "pwmHal.hpp"
+
+class PwmGroup;
 
 /**
  * @brief Control PWM pin for rp2040.
+ *
+ * Duty can be set in whole percent, in counter ticks, or as a 16 bit
+ * fixed-point fraction (DUTY_FULL = 100%), giving the full resolution of
+ * the slice's wrap value.
+ *
+ * The duty setters are inline and free of divides (the M0+ has no divide
+ * instruction); the scale factors they need are recalculated whenever the
+ * wrap value changes.
+ *
+ * Pins added to a PwmGroup don't write their levels or frequency straight
+ * away; the group writes them together in PwmGroup::update.
+ *
+ * In phase-correct mode the counter counts up to wrap and back down, so
+ * pulses are centred on the counter reaching zero and a period is twice as
+ * many ticks.  Duty settings mean the same in either mode.
+ *
+ * Hardware is reached through PwmHal, so the class also builds on a host
+ * against the PWM model in pwmPin/sim.
+ *
+ * Every live PwmPin is kept in a list, so retuneAll can reprogram all of
+ * them for a new system clock in one pass.
  */
 class PwmPin
 {
 public:
 
+    friend class PwmGroup;
+
+    /// 100% duty for setDutyFrac (Q16 fixed point)
+    static constexpr uint32_t DUTY_FULL = 1u << 16;
+
+    /**
+     * @brief Divider and wrap settings for a PWM slice
+     */
+    struct PwmSettings
+    {
+        /// Clock divider, 8.4 fixed point (16 = divide by 1)
+        uint16_t div16;
+        /// Counter wrap (TOP) value; period is wrap + 1 ticks
+        uint16_t wrap;
+        /// Achieved frequency, rounded (Hz)
+        uint32_t freq;
+    };
+
     /**
      * @brief Construct PwmPin object.
-     * 
+     *
      * @param gpioPin - GPIO pin number
      * @param initFreq - Initial frequency (effects both channels for PWM generator)
      * @param initDuty - Initial duty cycle (percent)
      * @param enable - If true, enable PWM for pin
      */
-    PwmPin( const uint8_t gpioPin, 
-            const uint16_t initFreq = 0xFFFF, 
-            const uint8_t initDuty = 0, 
+    PwmPin( const uint8_t gpioPin,
+            const uint32_t initFreq = 0xFFFF,
+            const uint8_t initDuty = 0,
             const bool enable = true);
 
+    /**
+     * @brief Remove the pin from its group, if any, and the list of live pins
+     */
+    ~PwmPin();
+
+    // The list of live pins holds their addresses
+    PwmPin(const PwmPin&) = delete;
+    PwmPin& operator=(const PwmPin&) = delete;
+
+    /**
+     * @brief Find the divider and wrap closest to a frequency
+     *
+     * Picks the smallest divider that fits the period in the 16 bit counter
+     * (maximum duty resolution), then tries slightly larger fractional
+     * dividers, giving up at most 1/16 of the resolution (or less than one
+     * tick, for short periods), and keeps the one with the smallest
+     * frequency error.
+     *
+     * @param clockFreq - System clock frequency (Hz)
+     * @param freq - Requested frequency (Hz)
+     * @param settings - Divider, wrap and achieved frequency
+     * @param isPhaseCorrect - Solve for phase-correct mode (2 x (wrap + 1)
+     *                         ticks per period)
+     * @return true if freq reachable, false if too low or above clockFreq / 2
+     *         (clockFreq / 4 phase-correct)
+     */
+    static bool solveFreq
+    (
+        const uint32_t clockFreq,
+        const uint32_t freq,
+        PwmSettings& settings,
+        const bool isPhaseCorrect = false
+    );
+
     /**
      * @brief Enable/Disable PWM pin
-     * 
+     *
      * @param shouldEnable - If true enable pin, if false disable pin
      */
     void enablePin(const bool shouldEnable = true);
 
     /**
      * @brief Set frequency of PWM generator (Effects both pins of PWM generator)
-     * 
+     *
+     * The duty cycles of this pin and of a PwmPin on the other channel are
+     * kept as the wrap value changes.  A pin in a PwmGroup changes frequency
+     * at the group's next update().
+     *
      * @param freq - Frequency (Hz)
+     * @return true if freq reachable, false if not reachable or the other
+     *         pin of the slice is in the same PwmGroup (settings unchanged)
      */
-    void setFreq(const uint16_t freq);
-    
+    bool setFreq(const uint32_t freq);
+
+    /**
+     * @brief Set phase-correct (centre-aligned) mode of PWM generator
+     *        (Effects both pins of PWM generator)
+     *
+     * The frequency is solved again so it stays the same, and the duty
+     * cycles of both pins are kept.
+     *
+     * @param isPhaseCorrect - If true count up and down, if false count up
+     * @return true if set, false if the frequency is not reachable in the new
+     *         mode or the other pin of the slice is in the same PwmGroup
+     */
+    bool setPhaseCorrect(const bool isPhaseCorrect);
+
+    /**
+     * @brief Get phase-correct mode of PWM generator
+     *
+     * @return true if phase-correct, false if trailing edge
+     */
+    bool isPhaseCorrect()
+    { return mIsPhaseCorrect; }
+
     /**
      * @brief Get PWM generator frequency
-     * 
-     * @return uint16_t - Frequency (Hz)
+     *
+     * @return uint32_t - Requested frequency (Hz)
      */
-    uint16_t getFreq()
+    uint32_t getFreq()
     { return mFreq; }
 
+    /**
+     * @brief Get the frequency the PWM generator actually runs at
+     *
+     * @return uint32_t - Achieved frequency, rounded (Hz)
+     */
+    uint32_t getActualFreq()
+    { return mActualFreq; }
+
+    /**
+     * @brief Get the counter wrap value
+     *
+     * @return uint32_t - Wrap value; a period is wrap + 1 ticks
+     */
+    uint32_t getWrap()
+    { return mWrap; }
+
     /**
      * @brief Set duty cycle of PWM pin
-     * 
+     *
      * @param percent - Duty cycle 0 - 100
      */
-    void setDuty(const uint8_t percent);
+    void setDuty(const uint8_t percent)
+    {
+        if(percent <= 100)
+        {
+            mDuty = percent;
+            mDutyFrac = PERCENT_TO_FRAC[percent];
+
+            // Same as mWrap * percent / 100
+            writeLevel((percent * mPercentScale) >> 16);
+        }
+    }
 
     /**
      * @brief Get duty cycle of PWM pin
-     * 
+     *
      * @return uint8_t - Duty cycle (%)
      */
     uint8_t getDuty()
     { return mDuty; }
 
     /**
-     * @brief Set the system clock frequency used to calculate PWM parameters
-     * 
+     * @brief Set duty cycle of PWM pin in counter ticks
+     *
+     * @param ticks - High time, 0 - wrap + 1 (wrap + 1 is always on)
+     * @return true if ticks valid, false if invalid
+     */
+    bool setDutyTicks(const uint32_t ticks)
+    {
+        if(ticks > mWrap + 1)
+        {
+            return false;
+        }
+
+        mDutyFrac = (static_cast<uint64_t>(ticks) * mTickScale) >> 16;
+        mDuty = (mDutyFrac * 100 + DUTY_FULL / 2) >> 16;
+
+        writeLevel(ticks);
+        return true;
+    }
+
+    /**
+     * @brief Get duty cycle of PWM pin in counter ticks
+     *
+     * @return uint32_t - High time (ticks)
+     */
+    uint32_t getDutyTicks()
+    { return mLevel; }
+
+    /**
+     * @brief Set duty cycle of PWM pin as a fraction
+     *
+     * @param frac - Duty cycle, 0 - DUTY_FULL (Q16 fixed point)
+     */
+    void setDutyFrac(const uint32_t frac)
+    {
+        mDutyFrac = (frac < DUTY_FULL) ? frac : DUTY_FULL;
+        mDuty = (mDutyFrac * 100 + DUTY_FULL / 2) >> 16;
+
+        // (wrap + 1) * DUTY_FULL would overflow 32 bits
+        writeLevel((mDutyFrac == DUTY_FULL) ? mWrap + 1 : ((mWrap + 1) * mDutyFrac) >> 16);
+    }
+
+    /**
+     * @brief Get duty cycle of PWM pin as a fraction
+     *
+     * @return uint32_t - Duty cycle, 0 - DUTY_FULL (Q16 fixed point)
+     */
+    uint32_t getDutyFrac()
+    { return mDutyFrac; }
+
+    /**
+     * @brief Set the levels of both channels of a slice with one register write
+     *
+     * Nothing is checked and no PwmPin state is updated; meant for control
+     * loops that own both pins of a slice.
+     *
+     * @param slice - PWM generator
+     * @param levelA - Channel A high time (ticks)
+     * @param levelB - Channel B high time (ticks)
+     */
+    static void setSliceLevels(const uint slice, const uint16_t levelA, const uint16_t levelB)
+    { PwmHal::writeCc(slice, levelA | (static_cast<uint32_t>(levelB) << PwmHal::CC_B_LSB)); }
+
+    /**
+     * @brief Get PWM generator of pin
+     *
+     * @return uint - PWM slice number
+     */
+    uint getSlice()
+    { return mSlice; }
+
+    /**
+     * @brief Get PWM channel of pin
+     *
+     * @return uint - 0 for channel A, 1 for channel B
+     */
+    uint getChannel()
+    { return mChan; }
+
+    /**
+     * @brief Set the system clock frequency and reprogram the slice for it
+     *
+     * For a change of clk_sys, retuneAll does every pin at once and keeps
+     * the slices in step.
+     *
      * @param clockFreq - System clock frequency (Hz)
+     * @return true if the frequency is still reachable, false if not or the
+     *         other pin of the slice is in the same PwmGroup
      */
-    void setClockFreq(const uint32_t clockFreq)
-    { mClockFreq = clockFreq; }
+    bool setClockFreq(const uint32_t clockFreq);
 
     /**
      * @brief Get the system clock frequency being used for PWM calculations
-     * 
+     *
      * @return uint32_t - System clock frequency (Hz)
      */
     uint32_t getClockFreq()
     { return mClockFreq; }
 
+    /**
+     * @brief Reprogram every live pin for the current clk_sys frequency
+     *
+     * Call after changing the system clock.  The running slices are stopped
+     * with one register write, given new dividers and wraps for their
+     * requested frequencies, and restarted with one write, their counters
+     * scaled so slices keep their positions relative to each other.  Duty
+     * cycles are kept as fractions; levels of grouped pins are written
+     * straight away.
+     *
+     * Pins mustn't be changed from another core or an interrupt meanwhile,
+     * and a StagedPwmPin should have committed its last stage.
+     *
+     * @return true if every pin kept its frequency, false if any can't reach
+     *         it at the new clock (those keep their old settings)
+     */
+    static bool retuneAll();
+
 protected:
 
+    /// setDuty percent to setDutyFrac fraction, rounded
+    static const uint32_t PERCENT_TO_FRAC[101];
+
+    /**
+     * @brief Write a level to this pin's half of the compare register
+     *
+     * @param level - High time (ticks)
+     */
+    void writeLevel(const uint32_t level)
+    {
+        mLevel = level;
+
+        if(mpGroup == nullptr)
+        {
+            writeCc();
+        }
+    }
+
+    /**
+     * @brief Write the level to this pin's half of the compare register
+     */
+    void writeCc()
+    {
+        // A level above wrap keeps the output high for the whole period, but
+        // the CC register is only 16 bits
+        PwmHal::writeMasked(mpCc, ((mLevel > 0xFFFF) ? 0xFFFF : mLevel) << mCcShift, mCcMask);
+    }
+
+    /**
+     * @brief Write the divider and wrap to the slice
+     */
+    void writeFreq()
+    {
+        PwmHal::setDiv(mSlice, mDiv16);
+        PwmHal::setWrap(mSlice, mWrap);
+    }
+
+    /**
+     * @brief Apply solved divider and wrap settings to the slice
+     *
+     * The other pin of the slice, if it has a PwmPin, is updated too and
+     * both keep their duty cycles.  A pin in a group only stages them, like
+     * its level, for PwmGroup::update.
+     *
+     * @param freq - Requested frequency (Hz)
+     * @param settings - Settings from solveFreq
+     */
+    void applyFreq(const uint32_t freq, const PwmSettings& settings);
+
+    /**
+     * @brief Recalculate the duty scale factors after a wrap change
+     */
+    void updateScale();
+
     /// GPIO Pin
     uint8_t mPin;
     /// PWM generator
     uint mSlice;
     /// PWM channel
     uint mChan;
-    /// PWM frequency (Hz)
-    uint16_t mFreq;
+    /// Requested PWM frequency (Hz)
+    uint32_t mFreq;
+    /// Achieved PWM frequency (Hz)
+    uint32_t mActualFreq = 0;
     /// PWM Duty Cycle (%)
     uint8_t mDuty;
+    /// PWM Duty Cycle (Q16 fraction of DUTY_FULL)
+    uint32_t mDutyFrac = 0;
+    /// PWM level (ticks high per period)
+    uint32_t mLevel = 0;
+    /// Clock divider, 8.4 fixed point
+    uint32_t mDiv16 = 16;
     /// Wrap value for PWM counter
-    uint32_t mWrap;
+    uint32_t mWrap = 0xFFFF;
+    /// True if the counter counts up and down
+    bool mIsPhaseCorrect = false;
+    /// ceil(mWrap * 2^16 / 100), percent to level multiplier
+    uint32_t mPercentScale = 0;
+    /// ceil(2^32 / (mWrap + 1)), ticks to fraction multiplier
+    uint32_t mTickScale = 0;
+    /// Compare register of slice
+    PwmHal::Reg* mpCc;
+    /// Position of this channel's level in compare register
+    uint mCcShift;
+    /// Bits of this channel's level in compare register
+    uint32_t mCcMask;
+    /// Group the pin belongs to, if any
+    PwmGroup* mpGroup = nullptr;
     /// System Clock Frequency (Hz)
-    uint32_t mClockFreq = 125'000'000;
+    uint32_t mClockFreq;
+    /// Next live pin
+    PwmPin* mpNext = nullptr;
+
+    /// First live pin
+    static PwmPin* spFirst;
 
 }; // End class PwmPin
\ No newline at end of file
@@ -0,0 +1,195 @@
+#pragma once
+
+#include <pico/stdlib.h>
+#include <hardware/dma.h>
+
+/**
+ * @brief Play a table of levels into a PWM slice with DMA.
+ *
+ * Each table entry is a whole compare register value (channel A level in
+ * the low half, channel B in the high half, see makeLevels), written once
+ * per counter period or once every N periods.  The compare register is
+ * latched at wrap, so each entry takes effect on a period boundary.
+ *
+ * Once started, no CPU time is used per entry, except when streaming, where
+ * a callback refills each half of a double buffer from the DMA interrupt.
+ *
+ * Uses two DMA channels, plus a DMA pacing timer when an entry lasts more
+ * than one period.  Sequencers on several slices can be started on the
+ * same clock with startTogether.
+ */
+class PwmSequencer
+{
+public:
+
+    /**
+     * @brief How a table is played
+     */
+    enum class Mode
+    {
+        /// Play once and stop, leaving the last level
+        OneShot,
+        /// Repeat until stopped
+        Loop
+    };
+
+    /**
+     * @brief Fill one half of a stream buffer
+     *
+     * Called from the DMA interrupt (and twice before starting).
+     *
+     * @param pBuf - Buffer to fill
+     * @param size - Entries in buffer
+     * @param pCtx - Context given to stream()
+     */
+    typedef void (*RefillFunc)(uint32_t* pBuf, size_t size, void* pCtx);
+
+    /**
+     * @brief Construct a PwmSequencer, claiming two DMA channels
+     *
+     * @param slice - PWM generator to drive
+     */
+    PwmSequencer(const uint slice);
+
+    /**
+     * @brief Stop and release DMA resources
+     */
+    ~PwmSequencer();
+
+    /**
+     * @brief Build a compare register value
+     *
+     * @param levelA - Channel A high time (ticks)
+     * @param levelB - Channel B high time (ticks)
+     * @return uint32_t - Table entry
+     */
+    static constexpr uint32_t makeLevels(const uint16_t levelA, const uint16_t levelB)
+    { return levelA | (static_cast<uint32_t>(levelB) << 16); }
+
+    /**
+     * @brief Set how many counter periods each entry lasts
+     *
+     * More than one period needs a DMA pacing timer running at an exact
+     * fraction of the system clock, worked out from the slice's current
+     * divider and wrap; call again after changing the slice frequency.
+     * The timer can't run slower than clk_sys / 65535, so an entry lasts
+     * at most 65535 system clocks.
+     *
+     * @param periods - Periods per entry (1 - 65535)
+     * @return true if set, false if playing, the rate can't be made exactly
+     *         or no pacing timer is free
+     */
+    bool setPeriodsPerEntry(const uint32_t periods);
+
+    /**
+     * @brief Play a table
+     *
+     * @param pTable - Entries; must stay valid while playing
+     * @param size - Number of entries
+     * @param mode - OneShot or Loop
+     * @param shouldStart - If false, only set up (see startTogether)
+     * @return true if started, false if invalid or still playing
+     */
+    bool play
+    (
+        const uint32_t* pTable,
+        const size_t size,
+        const Mode mode = Mode::OneShot,
+        const bool shouldStart = true
+    );
+
+    /**
+     * @brief Stream entries from a double buffer
+     *
+     * While one half plays, the other is refilled by pRefill.
+     *
+     * @param pBufA - First half
+     * @param pBufB - Second half
+     * @param size - Entries in each half
+     * @param pRefill - Fills a half; runs in interrupt context
+     * @param pCtx - Passed to pRefill
+     * @param shouldStart - If false, only set up (see startTogether)
+     * @return true if started, false if invalid or still playing
+     */
+    bool stream
+    (
+        uint32_t* pBufA,
+        uint32_t* pBufB,
+        const size_t size,
+        const RefillFunc pRefill,
+        void* pCtx = nullptr,
+        const bool shouldStart = true
+    );
+
+    /**
+     * @brief Start set up sequencers on the same clock
+     *
+     * @param pSeqs - Sequencers set up with shouldStart = false
+     * @param count - Number of sequencers
+     */
+    static void startTogether(PwmSequencer* const* pSeqs, const size_t count);
+
+    /**
+     * @brief Stop playing, leaving the current level
+     */
+    void stop();
+
+    /**
+     * @brief Check if a table or stream is playing
+     *
+     * @return true if playing
+     */
+    bool isBusy();
+
+private:
+
+    /**
+     * @brief Set up a data channel writing to the compare register
+     */
+    void configData
+    (
+        const uint chan,
+        const uint chainTo,
+        const uint32_t* pData,
+        const size_t size
+    );
+
+    /**
+     * @brief Handle a completed stream buffer
+     */
+    void onComplete(const uint chan);
+
+    /**
+     * @brief Shared DMA_IRQ_0 handler
+     */
+    static void irqHandler();
+
+    /// PWM generator
+    uint mSlice;
+    /// DMA channel writing the compare register
+    uint mDataChan;
+    /// Loop: reloads mDataChan. Stream: second data channel
+    uint mAuxChan;
+    /// DMA pacing timer, or -1 when paced by the PWM wrap
+    int mTimer = -1;
+    /// DREQ pacing the data channels
+    uint mDreq;
+    /// Looped table start, read by the reload channel
+    const uint32_t* mpTable = nullptr;
+    /// Stream buffers
+    uint32_t* mpBuf[2] = { nullptr, nullptr };
+    /// Stream buffer size (entries)
+    size_t mBufSize = 0;
+    /// Stream refill callback
+    RefillFunc mpRefill = nullptr;
+    /// Stream refill context
+    void* mpRefillCtx = nullptr;
+    /// True while set up or playing
+    bool mIsActive = false;
+
+    /// Sequencer streaming on each DMA channel
+    static PwmSequencer* spChannels[NUM_DMA_CHANNELS];
+    /// True once irqHandler is installed
+    static bool sIsIrqInstalled;
+
+}; // End class PwmSequencer
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <pico/stdlib.h>
+
+#include "pwmPin.hpp"
+
+/**
+ * @brief PWM pin whose frequency and duty change together at a wrap.
+ *
+ * New settings are staged as a set (divider, wrap and level) and
+ * committed by the PWM wrap interrupt, so a period never mixes an old
+ * wrap with a new level.  The hand-off is a sequence lock: staging never
+ * blocks or disables interrupts, and the interrupt skips a wrap rather
+ * than wait if it catches a stage half written.
+ *
+ * Any one core or interrupt may stage at a time (single producer).  The
+ * committed TOP and CC values are latched by the hardware at the
+ * following wrap.  The divider takes effect as it is written, so a new
+ * divider is held back and written by the interrupt for that wrap, and
+ * every period runs with a matching divider, TOP and CC.  Only the few
+ * clocks of interrupt latency at the start of that period still count at
+ * the old divider.
+ *
+ * One StagedPwmPin per slice.  The setters of PwmPin aren't available, as
+ * they would bypass staging.
+ */
+class StagedPwmPin : protected PwmPin
+{
+public:
+
+    /**
+     * @brief Construct StagedPwmPin object and install the wrap interrupt.
+     *
+     * @param gpioPin - GPIO pin number
+     * @param initFreq - Initial frequency (effects both channels for PWM generator)
+     * @param initDuty - Initial duty cycle (percent)
+     * @param enable - If true, enable PWM for pin
+     */
+    StagedPwmPin(   const uint8_t gpioPin,
+                    const uint32_t initFreq = 0xFFFF,
+                    const uint8_t initDuty = 0,
+                    const bool enable = true);
+
+    /**
+     * @brief Remove the pin from the wrap interrupt
+     */
+    ~StagedPwmPin();
+
+    using PwmPin::DUTY_FULL;
+    using PwmPin::enablePin;
+    using PwmPin::getFreq;
+    using PwmPin::getActualFreq;
+    using PwmPin::getWrap;
+    using PwmPin::getDuty;
+    using PwmPin::getDutyTicks;
+    using PwmPin::getDutyFrac;
+    using PwmPin::getSlice;
+    using PwmPin::getChannel;
+    using PwmPin::getClockFreq;
+
+    /**
+     * @brief Stage a new frequency and duty cycle
+     *
+     * @param freq - Frequency (Hz)
+     * @param frac - Duty cycle, 0 - DUTY_FULL (Q16 fixed point)
+     * @return true if staged, false if freq not reachable or the slice
+     *         already has a StagedPwmPin
+     */
+    bool stage(const uint32_t freq, const uint32_t frac);
+
+    /**
+     * @brief Stage a new duty cycle at the current frequency
+     *
+     * @param frac - Duty cycle, 0 - DUTY_FULL (Q16 fixed point)
+     * @return true if staged, false if the slice already has a StagedPwmPin
+     */
+    bool stageDutyFrac(const uint32_t frac);
+
+    /**
+     * @brief Stage a new duty cycle in counter ticks at the current frequency
+     *
+     * @param ticks - High time, 0 - wrap + 1 (wrap + 1 is always on)
+     * @return true if staged, false if ticks invalid or the slice already
+     *         has a StagedPwmPin
+     */
+    bool stageDutyTicks(const uint32_t ticks);
+
+    /**
+     * @brief Check if the last staged settings have been committed
+     *
+     * @return true if committed
+     */
+    bool isCommitted()
+    { return mCommittedSeq == mSeq; }
+
+    /**
+     * @brief Get the number of late commits
+     *
+     * A commit is late if it missed the first wrap after staging, because
+     * the interrupt caught the stage half written or ran too late.
+     *
+     * @return uint32_t - Late commits since construction
+     */
+    uint32_t getLateCommits()
+    { return mLateCommits; }
+
+private:
+
+    /**
+     * @brief Publish settings for the wrap interrupt
+     */
+    void publish(const uint32_t div, const uint32_t top, const uint32_t level);
+
+    /**
+     * @brief Commit staged settings; called from the wrap interrupt
+     */
+    void commit();
+
+    /**
+     * @brief Shared PWM_IRQ_WRAP handler
+     */
+    static void irqHandler();
+
+    /// Sequence count; odd while a stage is half written
+    volatile uint32_t mSeq = 0;
+    /// Staged divider register (8.4)
+    volatile uint32_t mStagedDiv;
+    /// Staged TOP register
+    volatile uint32_t mStagedTop;
+    /// Staged level (ticks)
+    volatile uint32_t mStagedLevel;
+    /// Wrap count when staged
+    volatile uint32_t mStagedWrap = 0;
+
+    /// Sequence count of the last commit
+    volatile uint32_t mCommittedSeq = 0;
+    /// Wraps seen by the interrupt
+    volatile uint32_t mWraps = 0;
+    /// Commits that missed the first wrap after staging
+    volatile uint32_t mLateCommits = 0;
+    /// Divider to write at the wrap that latches the committed TOP and CC
+    uint32_t mPendingDiv = 0;
+    /// True if mPendingDiv is waiting for that wrap
+    bool mIsDivPending = false;
+    /// True if this pin owns its slice's interrupt
+    bool mIsRegistered = false;
+
+    /// StagedPwmPin on each slice
+    static StagedPwmPin* spSlices[NUM_PWM_SLICES];
+    /// True once irqHandler is installed
+    static bool sIsIrqInstalled;
+
+}; // End class StagedPwmPin
@@ -0,0 +1,166 @@
+/**
+ * @brief Host simulation of DeltaSigma.
+ *
+ *        For a PWM period of a given number of ticks, sweeps duty cycles
+ *        through first and second order modulators and reports:
+ *          - the worst average duty error, as effective bits of resolution,
+ *            both free running and for a looped pattern (duty cycles within
+ *            two ticks of 0% or 100% are left out; there the level clips)
+ *          - the noise power of the level sequence in octave bands below
+ *            the PWM frequency, showing the noise shaping
+ *
+ *        Usage: deltaSigma_sim [ticks per period] [periods]
+ */
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "deltaSigma.hpp"
+
+namespace
+{
+
+const char* orderName(const DeltaSigma::Order order)
+{
+    return (order == DeltaSigma::Order::First) ? "first" : "second";
+}
+
+/**
+ * @brief Power of a sequence at a frequency (single DFT bin)
+ *
+ * @param levels - Sequence, mean removed
+ * @param freq - Fraction of the sample rate
+ */
+double binPower(const std::vector<double>& levels, const double freq)
+{
+    double re = 0.0;
+    double im = 0.0;
+
+    for(size_t i = 0; i < levels.size(); i++)
+    {
+        // Hann window keeps the carrier's leakage out of low bins
+        const double w = 0.5 - 0.5 * cos(2.0 * M_PI * i / levels.size());
+        re += w * levels[i] * cos(2.0 * M_PI * freq * i);
+        im += w * levels[i] * sin(2.0 * M_PI * freq * i);
+    }
+
+    return (re * re + im * im) / levels.size();
+}
+
+} // End anonymous namespace
+
+int main(int argc, char* argv[])
+{
+    const uint32_t ticks = (argc > 1) ? strtoul(argv[1], nullptr, 0) : 125;
+    const size_t periods = (argc > 2) ? strtoul(argv[2], nullptr, 0) : 16384;
+    const DeltaSigma::Order orders[] = { DeltaSigma::Order::First, DeltaSigma::Order::Second };
+
+    printf("%u ticks per period (%.1f bits undithered), %zu periods\n\n",
+            ticks, log2(ticks), periods);
+
+    // Resolution: worst error of the average over many duty cycles
+    printf("order   free running bits   looped pattern bits\n");
+
+    for(const DeltaSigma::Order order : orders)
+    {
+        DeltaSigma modulator(order);
+        std::vector<uint32_t> pattern(periods);
+        double worstFree = 0.0;
+        double worstLoop = 0.0;
+
+        modulator.setPeriod(ticks);
+
+        // Second order needs a couple of ticks of headroom either side, so
+        // stay that far from 0% and 100%
+        const uint32_t margin = 2 * DeltaSigma::DUTY_FULL / ticks;
+
+        for(uint32_t duty = margin; duty < DeltaSigma::DUTY_FULL - margin; duty += 99'991)
+        {
+            const double target = static_cast<double>(duty) / DeltaSigma::DUTY_FULL;
+
+            modulator.setDuty(duty);
+            modulator.reset();
+
+            double sum = 0.0;
+            for(size_t i = 0; i < periods; i++)
+            {
+                sum += modulator.next();
+            }
+
+            const double freeErr = fabs(sum / periods / ticks - target);
+            worstFree = (freeErr > worstFree) ? freeErr : worstFree;
+
+            modulator.fillLoop(pattern.data(), periods, 0, 0);
+
+            sum = 0.0;
+            for(const uint32_t level : pattern)
+            {
+                sum += level;
+            }
+
+            const double loopErr = fabs(sum / periods / ticks - target);
+            worstLoop = (loopErr > worstLoop) ? loopErr : worstLoop;
+        }
+
+        printf("%-7s %17.1f %21.1f\n", orderName(order),
+                -log2(worstFree), -log2(worstLoop));
+    }
+
+    // Spectrum: average noise power in octave bands, relative to the PWM
+    // frequency; single bins are too ragged to compare
+    const double freqs[] = { 1.0 / 1024, 1.0 / 512, 1.0 / 256, 1.0 / 128, 1.0 / 64,
+                                1.0 / 32, 1.0 / 16, 1.0 / 8, 1.0 / 4 };
+    const size_t BINS_PER_BAND = 16;
+    const uint32_t duty = DeltaSigma::DUTY_FULL / 3 + 12345;
+
+    printf("\nnoise at duty %.6f (dB per bin)\nband/fpwm", static_cast<double>(duty) / DeltaSigma::DUTY_FULL);
+    for(const DeltaSigma::Order order : orders)
+    {
+        printf(" %10s", orderName(order));
+    }
+    printf("\n");
+
+    std::vector<double> spectra[2];
+
+    for(size_t o = 0; o < 2; o++)
+    {
+        DeltaSigma modulator(orders[o]);
+        std::vector<double> levels(periods);
+
+        modulator.setPeriod(ticks);
+        modulator.setDuty(duty);
+
+        double mean = 0.0;
+        for(double& level : levels)
+        {
+            level = modulator.next();
+            mean += level;
+        }
+
+        mean /= periods;
+        for(double& level : levels)
+        {
+            level -= mean;
+        }
+
+        for(const double freq : freqs)
+        {
+            // Band is freq - 2 * freq
+            double power = 0.0;
+            for(size_t bin = 0; bin < BINS_PER_BAND; bin++)
+            {
+                power += binPower(levels, freq * (1.0 + (bin + 0.5) / BINS_PER_BAND));
+            }
+
+            spectra[o].push_back(10.0 * log10(power / BINS_PER_BAND + 1e-20));
+        }
+    }
+
+    for(size_t f = 0; f < sizeof(freqs) / sizeof(freqs[0]); f++)
+    {
+        printf("1/%-7.0f %10.1f %10.1f\n", 1.0 / freqs[f], spectra[0][f], spectra[1][f]);
+    }
+
+    return 0;
+}
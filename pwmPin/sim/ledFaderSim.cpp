@@ -0,0 +1,130 @@
+/**
+ * @brief Host simulation of LedFader.
+ *
+ *        Ticks a set of fades without hardware and checks that every fade
+ *        is monotonic and lands on its target, then prints one fade per
+ *        easing curve as CSV (tick, level, duty) for plotting.
+ *
+ *        Usage: ledFader_sim [ticks]
+ */
+#include <cstdio>
+#include <cstdlib>
+
+#include "ledFader.hpp"
+
+namespace
+{
+
+const size_t CHANNELS = 32;
+
+/// Last duty sent to each channel
+uint32_t duties[CHANNELS];
+
+void simOutput(void* pCtx, uint32_t duty)
+{
+    duties[reinterpret_cast<size_t>(pCtx)] = duty;
+}
+
+const char* easingName(const LedFader::Easing easing)
+{
+    switch(easing)
+    {
+        case LedFader::Easing::Linear:      return "linear";
+        case LedFader::Easing::EaseIn:      return "easeIn";
+        case LedFader::Easing::EaseOut:     return "easeOut";
+        default:                            return "easeInOut";
+    }
+}
+
+} // End anonymous namespace
+
+int main(int argc, char* argv[])
+{
+    const uint32_t ticks = (argc > 1) ? strtoul(argv[1], nullptr, 0) : 100;
+    const LedFader::Easing easings[] =
+    {
+        LedFader::Easing::Linear,
+        LedFader::Easing::EaseIn,
+        LedFader::Easing::EaseOut,
+        LedFader::Easing::EaseInOut
+    };
+
+    LedFader::Channel channels[CHANNELS];
+    LedFader fader(channels, CHANNELS);
+
+    for(size_t i = 0; i < CHANNELS; i++)
+    {
+        fader.attach(i, simOutput, reinterpret_cast<void*>(i));
+    }
+
+    // Half the channels fade up, half fade down from full, with staggered
+    // lengths so they finish on different ticks; each pair uses one easing
+    for(size_t i = 0; i < CHANNELS; i++)
+    {
+        const bool isUp = (i % 2) == 0;
+
+        fader.set(i, (isUp) ? 0 : LedFader::LEVEL_FULL);
+        fader.fade(i, (isUp) ? LedFader::LEVEL_FULL : 0, ticks + i, easings[(i / 2) % 4]);
+    }
+
+    uint32_t prev[CHANNELS];
+    for(size_t i = 0; i < CHANNELS; i++)
+    {
+        prev[i] = duties[i];
+    }
+
+    int errors = 0;
+
+    printf("tick");
+    for(const LedFader::Easing easing : easings)
+    {
+        printf(",%s_level,%s_duty", easingName(easing), easingName(easing));
+    }
+    printf("\n");
+
+    for(uint32_t t = 1; fader.getActiveCount() > 0; t++)
+    {
+        fader.tick();
+
+        printf("%u", t);
+        for(size_t i = 0; i < 4; i++)
+        {
+            // Even channels 0, 2, 4, 6 fade up, one per easing
+            const size_t chan = i * 2;
+            printf(",%u,%u", fader.getLevel(chan), duties[chan]);
+        }
+        printf("\n");
+
+        for(size_t i = 0; i < CHANNELS; i++)
+        {
+            const bool isUp = (i % 2) == 0;
+
+            if((isUp && duties[i] < prev[i]) || (!isUp && duties[i] > prev[i]))
+            {
+                fprintf(stderr, "channel %zu not monotonic at tick %u\n", i, t);
+                errors++;
+            }
+            prev[i] = duties[i];
+        }
+
+        if(t > ticks + CHANNELS)
+        {
+            fprintf(stderr, "fades did not finish\n");
+            return 1;
+        }
+    }
+
+    for(size_t i = 0; i < CHANNELS; i++)
+    {
+        const uint32_t target = (i % 2 == 0) ? LedFader::LEVEL_FULL : 0;
+
+        if(duties[i] != target || fader.getLevel(i) != target)
+        {
+            fprintf(stderr, "channel %zu ended at %u\n", i, duties[i]);
+            errors++;
+        }
+    }
+
+    fprintf(stderr, "%d errors\n", errors);
+    return (errors == 0) ? 0 : 1;
+}
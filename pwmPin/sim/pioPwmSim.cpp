@@ -0,0 +1,368 @@
+/**
+ * @brief Host checks of PioPwm's program and tables against the PIO model.
+ *
+ *        Runs PioPwmProgram in PioSim, fed from PioPwmTable tables by a
+ *        model of the two DMA channels, and checks:
+ *         - every pin's high time per period, for 1 - 32 pins, several
+ *           periods and random and edge case levels
+ *         - the period is exact and the state machine never stalls
+ *         - a table swap takes effect at a period boundary, never part way
+ *        then times PioPwmTable::build.
+ *
+ *        Usage: pioPwm_sim [seed]
+ */
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+#include "pioPwmProgram.hpp"
+#include "pioPwmTable.hpp"
+#include "pioSim.hpp"
+
+namespace
+{
+
+/// Pin counts checked
+const uint32_t PIN_COUNTS[] = {1, 4, 16, 32};
+
+/// Periods checked, beyond each pin count's minimum (clocks)
+const uint32_t PERIODS[] = {1'000, 4'099, 12'345};
+
+/// Clocks the control channel takes to restart the data channel
+const uint32_t RELOAD_CLOCKS = 4;
+
+/// Periods measured per case
+const uint32_t PERIODS_RUN = 3;
+
+int errors = 0;
+
+void fail(const char* pMsg, const uint32_t pinCount, const uint32_t period)
+{
+    printf("  FAIL %s (%lu pins, period %lu)\n", pMsg,
+            static_cast<unsigned long>(pinCount), static_cast<unsigned long>(period));
+    errors++;
+}
+
+/**
+ * @brief Model of the data and control DMA channels
+ *
+ * Keeps the TX FIFO full from the table, and at the end of a table waits
+ * RELOAD_CLOCKS before reading the next from *ppActive.
+ */
+class DmaModel
+{
+public:
+
+    DmaModel(const uint32_t* const* ppActive, const size_t size)
+    :
+    mppActive(ppActive),
+    mpTable(*ppActive),
+    mSize(size)
+    {
+    }
+
+    void feed(PioSim& sim)
+    {
+        if(mReloadWait > 0)
+        {
+            mReloadWait--;
+            return;
+        }
+
+        while(sim.getTxLevel() < PioSim::FIFO_DEPTH)
+        {
+            sim.push(mpTable[mPos++]);
+
+            if(mPos == mSize)
+            {
+                mpTable = *mppActive;
+                mPos = 0;
+                mReloadWait = RELOAD_CLOCKS;
+                return;
+            }
+        }
+    }
+
+private:
+
+    const uint32_t* const* mppActive;
+    const uint32_t* mpTable;
+    size_t mSize;
+    size_t mPos = 0;
+    uint32_t mReloadWait = 0;
+
+}; // End class DmaModel
+
+PioSim makeSim(const uint32_t pinCount)
+{
+    PioSim sim(PioPwmProgram::INSTRUCTIONS, PioPwmProgram::LENGTH,
+                PioPwmProgram::WRAP_TARGET, PioPwmProgram::WRAP);
+    sim.setPins(0, pinCount);
+    sim.setOutShift(true, true, 32);
+
+    return sim;
+}
+
+/**
+ * @brief High time a pin should have; edges move up to SEGMENT_OVERHEAD - 1
+ *        clocks earlier, or to the end of the period
+ */
+bool isLevelOk(const uint32_t level, const uint32_t period, const uint64_t high)
+{
+    if(level == 0 || level >= period)
+    {
+        return high == ((level == 0) ? 0 : period);
+    }
+
+    return high <= period && high + PioPwmProgram::SEGMENT_OVERHEAD > level &&
+            (high <= level || high == period);
+}
+
+void checkCase(const uint32_t pinCount, const uint32_t period, const uint32_t* pLevels)
+{
+    uint32_t table[PioPwmTable::getSize(PioPwmTable::MAX_PINS)];
+    if(!PioPwmTable::build(pLevels, pinCount, period, table))
+    {
+        fail("table not built", pinCount, period);
+        return;
+    }
+
+    const uint32_t* pActive = table;
+    DmaModel dma(&pActive, PioPwmTable::getSize(pinCount));
+    PioSim sim = makeSim(pinCount);
+
+    // The first segment starts on clock 0, so the window is whole periods
+    uint64_t high[PioPwmTable::MAX_PINS] = {};
+    uint64_t lastRise = 0;
+    uint32_t rises = 0;
+    uint32_t lastPins = 0;
+    int riser = -1;
+
+    for(uint32_t pin = 0; pin < pinCount && riser < 0; pin++)
+    {
+        riser = (pLevels[pin] > 0 && pLevels[pin] + PioPwmProgram::SEGMENT_OVERHEAD <= period) ? pin : -1;
+    }
+
+    for(uint64_t clock = 0; clock < static_cast<uint64_t>(period) * PERIODS_RUN; clock++)
+    {
+        dma.feed(sim);
+        if(!sim.step())
+        {
+            fail("model stopped", pinCount, period);
+            return;
+        }
+
+        const uint32_t pins = sim.getPins();
+        for(uint32_t pin = 0; pin < pinCount; pin++)
+        {
+            high[pin] += (pins >> pin) & 1;
+        }
+
+        if(riser >= 0 && (pins & ~lastPins & (1u << riser)))
+        {
+            if(rises > 0 && clock - lastRise != period)
+            {
+                fail("period not exact", pinCount, period);
+            }
+
+            lastRise = clock;
+            rises++;
+        }
+        lastPins = pins;
+    }
+
+    if(sim.getStalls() != 0)
+    {
+        fail("state machine stalled", pinCount, period);
+    }
+
+    if((pinCount < 32) && (sim.getPins() >> pinCount) != 0)
+    {
+        fail("pin beyond the engine driven", pinCount, period);
+    }
+
+    for(uint32_t pin = 0; pin < pinCount; pin++)
+    {
+        if(!isLevelOk(pLevels[pin], period, high[pin] / PERIODS_RUN) || high[pin] % PERIODS_RUN != 0)
+        {
+            printf("    pin %lu level %lu high %llu per period\n", static_cast<unsigned long>(pin),
+                    static_cast<unsigned long>(pLevels[pin]),
+                    static_cast<unsigned long long>(high[pin] / PERIODS_RUN));
+            fail("high time", pinCount, period);
+        }
+    }
+}
+
+void checkLevels(std::mt19937& rng)
+{
+    printf("levels\n");
+
+    for(const uint32_t pinCount : PIN_COUNTS)
+    {
+        const uint32_t minPeriod = PioPwmTable::getMinPeriod(pinCount);
+        const uint32_t periods[] = {minPeriod, minPeriod + 1, PERIODS[0], PERIODS[1], PERIODS[2]};
+
+        for(const uint32_t period : periods)
+        {
+            const int errorsBefore = errors;
+            uint32_t levels[PioPwmTable::MAX_PINS];
+
+            // Random
+            for(uint32_t trial = 0; trial < 20; trial++)
+            {
+                for(uint32_t pin = 0; pin < pinCount; pin++)
+                {
+                    levels[pin] = rng() % (period + 1);
+                }
+                checkCase(pinCount, period, levels);
+            }
+
+            // Every pin the same
+            for(const uint32_t level : {0u, 1u, period / 2, period - 1, period})
+            {
+                for(uint32_t pin = 0; pin < pinCount; pin++)
+                {
+                    levels[pin] = level;
+                }
+                checkCase(pinCount, period, levels);
+            }
+
+            // Edges one clock apart, from both ends
+            for(uint32_t pin = 0; pin < pinCount; pin++)
+            {
+                levels[pin] = pin;
+            }
+            checkCase(pinCount, period, levels);
+
+            for(uint32_t pin = 0; pin < pinCount; pin++)
+            {
+                levels[pin] = period - pin;
+            }
+            checkCase(pinCount, period, levels);
+
+            printf("  %2lu pins, period %6lu: %s\n", static_cast<unsigned long>(pinCount),
+                    static_cast<unsigned long>(period), (errors == errorsBefore) ? "ok" : "FAIL");
+        }
+    }
+}
+
+void checkSwap(std::mt19937& rng)
+{
+    printf("table swap\n");
+
+    const uint32_t pinCount = 8;
+    const uint32_t period = 2'000;
+    uint32_t levelsA[pinCount];
+    uint32_t levelsB[pinCount];
+    uint32_t tableA[PioPwmTable::getSize(pinCount)];
+    uint32_t tableB[PioPwmTable::getSize(pinCount)];
+
+    for(uint32_t pin = 0; pin < pinCount; pin++)
+    {
+        levelsA[pin] = 100 + rng() % 1'800;
+        levelsB[pin] = 100 + rng() % 1'800;
+    }
+    PioPwmTable::build(levelsA, pinCount, period, tableA);
+    PioPwmTable::build(levelsB, pinCount, period, tableB);
+
+    // Swap at many points through the period
+    for(uint32_t swapAt = period; swapAt < 2 * period; swapAt += 97)
+    {
+        const uint32_t* pActive = tableA;
+        DmaModel dma(&pActive, PioPwmTable::getSize(pinCount));
+        PioSim sim = makeSim(pinCount);
+
+        uint32_t high[pinCount] = {};
+        uint32_t periodIndex = 0;
+        bool isOnB = false;
+
+        for(uint32_t clock = 0; clock < 5 * period; clock++)
+        {
+            if(clock == swapAt)
+            {
+                pActive = tableB;
+            }
+
+            dma.feed(sim);
+            sim.step();
+
+            for(uint32_t pin = 0; pin < pinCount; pin++)
+            {
+                high[pin] += (sim.getPins() >> pin) & 1;
+            }
+
+            // Every pin's high time over each whole period
+            if(clock % period == period - 1)
+            {
+                bool isA = true;
+                bool isB = true;
+
+                for(uint32_t pin = 0; pin < pinCount; pin++)
+                {
+                    isA = isA && isLevelOk(levelsA[pin], period, high[pin]);
+                    isB = isB && isLevelOk(levelsB[pin], period, high[pin]);
+                    high[pin] = 0;
+                }
+
+                if(!(isA || isB) || (isOnB && !isB))
+                {
+                    printf("    swap at %lu, period %lu\n", static_cast<unsigned long>(swapAt),
+                            static_cast<unsigned long>(periodIndex));
+                    fail("period mixes tables", pinCount, period);
+                }
+
+                isOnB = isOnB || (isB && !isA);
+                periodIndex++;
+            }
+        }
+
+        if(!isOnB)
+        {
+            fail("swap never took effect", pinCount, period);
+        }
+    }
+
+    printf("  %s\n", (errors == 0) ? "ok" : "FAIL");
+}
+
+void benchmark(std::mt19937& rng)
+{
+    const uint32_t CALLS = 1'000'000;
+    uint32_t levels[PioPwmTable::MAX_PINS];
+    uint32_t table[PioPwmTable::getSize(PioPwmTable::MAX_PINS)];
+
+    for(uint32_t& level : levels)
+    {
+        level = rng() % 10'001;
+    }
+
+    printf("host benchmark (ns per call)\n");
+
+    for(const uint32_t pinCount : PIN_COUNTS)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        for(uint32_t i = 0; i < CALLS; i++)
+        {
+            levels[i % pinCount] = i % 10'001;
+            PioPwmTable::build(levels, pinCount, 10'000, table);
+        }
+        const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+
+        printf("  build, %2lu pins  %.2f\n", static_cast<unsigned long>(pinCount), elapsed.count() / CALLS);
+    }
+}
+
+} // End anonymous namespace
+
+int main(int argc, char* argv[])
+{
+    std::mt19937 rng((argc > 1) ? strtoul(argv[1], nullptr, 0) : 1);
+
+    checkLevels(rng);
+    checkSwap(rng);
+    benchmark(rng);
+
+    printf("%d errors\n", errors);
+    return (errors == 0) ? 0 : 1;
+}
@@ -0,0 +1,273 @@
+#include "pioSim.hpp"
+
+namespace
+{
+
+uint32_t reverseBits(uint32_t value)
+{
+    uint32_t reversed = 0;
+
+    for(uint i = 0; i < 32; i++)
+    {
+        reversed = (reversed << 1) | (value & 1);
+        value >>= 1;
+    }
+
+    return reversed;
+}
+
+} // End anonymous namespace
+
+PioSim::PioSim(const uint16_t* pProgram, const uint length, const uint wrapTarget, const uint wrap)
+:
+mLength((length < 32) ? length : 32),
+mWrapTarget(wrapTarget),
+mWrap(wrap)
+{
+    for(uint i = 0; i < mLength; i++)
+    {
+        mProgram[i] = pProgram[i];
+    }
+}
+
+void PioSim::setPins(const uint outBase, const uint outCount, const uint setBase, const uint setCount)
+{
+    mOutBase = outBase;
+    mOutCount = outCount;
+    mSetBase = setBase;
+    mSetCount = setCount;
+}
+
+void PioSim::setOutShift(const bool shiftRight, const bool autoPull, const uint threshold)
+{
+    mShiftRight = shiftRight;
+    mAutoPull = autoPull;
+    mThreshold = threshold;
+}
+
+bool PioSim::push(const uint32_t word)
+{
+    if(mTxCount == FIFO_DEPTH)
+    {
+        return false;
+    }
+
+    mTx[(mTxHead + mTxCount) % FIFO_DEPTH] = word;
+    mTxCount++;
+    return true;
+}
+
+bool PioSim::step()
+{
+    mCycles++;
+
+    if(mDelay > 0)
+    {
+        mDelay--;
+        return true;
+    }
+
+    const uint16_t instr = mProgram[mPc];
+    const uint dest = (instr >> 5) & 7;
+    uint next = (mPc == mWrap) ? mWrapTarget : (mPc + 1) % 32;
+    bool isStalled = false;
+
+    switch(instr >> 13)
+    {
+        case 0: // JMP
+        {
+            bool isTaken;
+
+            switch(dest)
+            {
+                case 0: isTaken = true;                         break;
+                case 1: isTaken = (mX == 0);                    break;
+                case 2: isTaken = (mX-- != 0);                  break;
+                case 3: isTaken = (mY == 0);                    break;
+                case 4: isTaken = (mY-- != 0);                  break;
+                case 5: isTaken = (mX != mY);                   break;
+                case 7: isTaken = (mOsrShifted < mThreshold);   break;
+                default: return false;
+            }
+
+            if(isTaken)
+            {
+                next = instr & 0x1F;
+            }
+            break;
+        }
+
+        case 3: // OUT
+        {
+            const uint bits = ((instr & 0x1F) == 0) ? 32 : (instr & 0x1F);
+
+            if(mAutoPull && mOsrShifted >= mThreshold)
+            {
+                uint32_t word;
+                if(!pop(word))
+                {
+                    isStalled = true;
+                    break;
+                }
+
+                mOsr = word;
+                mOsrShifted = 0;
+            }
+
+            const uint32_t data = shiftOut(bits);
+
+            switch(dest)
+            {
+                case 0: writePins(mOutBase, mOutCount, data);   break;
+                case 1: mX = data;                              break;
+                case 2: mY = data;                              break;
+                case 3:                                         break;
+                case 5: next = data & 0x1F;                     break;
+                default: return false;
+            }
+            break;
+        }
+
+        case 4: // PULL (PUSH not modelled)
+        {
+            const bool isIfEmpty = instr & 0x40;
+            const bool isBlocking = instr & 0x20;
+
+            if((instr & 0x80) == 0)
+            {
+                return false;
+            }
+
+            if(isIfEmpty && mOsrShifted < mThreshold)
+            {
+                break;
+            }
+
+            uint32_t word;
+            if(pop(word))
+            {
+                mOsr = word;
+            }
+            else if(isBlocking)
+            {
+                isStalled = true;
+                break;
+            }
+            else
+            {
+                mOsr = mX;
+            }
+
+            mOsrShifted = 0;
+            break;
+        }
+
+        case 5: // MOV
+        {
+            uint32_t value;
+
+            switch(instr & 7)
+            {
+                case 0: value = mPins;  break;
+                case 1: value = mX;     break;
+                case 2: value = mY;     break;
+                case 3: value = 0;      break;
+                case 7: value = mOsr;   break;
+                default: return false;
+            }
+
+            switch((instr >> 3) & 3)
+            {
+                case 0:                                 break;
+                case 1: value = ~value;                 break;
+                case 2: value = reverseBits(value);     break;
+                default: return false;
+            }
+
+            switch(dest)
+            {
+                case 0: writePins(mOutBase, mOutCount, value);  break;
+                case 1: mX = value;                             break;
+                case 2: mY = value;                             break;
+                case 5: next = value & 0x1F;                    break;
+                case 7: mOsr = value; mOsrShifted = 0;          break;
+                default: return false;
+            }
+            break;
+        }
+
+        case 7: // SET
+        {
+            const uint32_t data = instr & 0x1F;
+
+            switch(dest)
+            {
+                case 0: writePins(mSetBase, mSetCount, data);   break;
+                case 1: mX = data;                              break;
+                case 2: mY = data;                              break;
+                default: return false;
+            }
+            break;
+        }
+
+        default:
+            return false;
+    }
+
+    // A stalled instruction runs again next clock, and its delay waits
+    if(isStalled)
+    {
+        mStalls++;
+        return true;
+    }
+
+    mPc = next;
+    mDelay = (instr >> 8) & 0x1F;
+    return true;
+}
+
+void PioSim::writePins(const uint base, const uint count, const uint32_t value)
+{
+    for(uint i = 0; i < count; i++)
+    {
+        const uint32_t bit = 1u << ((base + i) % 32);
+        mPins = (value & (1u << i)) ? (mPins | bit) : (mPins & ~bit);
+    }
+}
+
+uint32_t PioSim::shiftOut(const uint bits)
+{
+    uint32_t data;
+
+    if(bits == 32)
+    {
+        data = mOsr;
+        mOsr = 0;
+    }
+    else if(mShiftRight)
+    {
+        data = mOsr & ((1u << bits) - 1);
+        mOsr >>= bits;
+    }
+    else
+    {
+        data = mOsr >> (32 - bits);
+        mOsr <<= bits;
+    }
+
+    mOsrShifted = (mOsrShifted + bits < 32) ? mOsrShifted + bits : 32;
+    return data;
+}
+
+bool PioSim::pop(uint32_t& word)
+{
+    if(mTxCount == 0)
+    {
+        return false;
+    }
+
+    word = mTx[mTxHead];
+    mTxHead = (mTxHead + 1) % FIFO_DEPTH;
+    mTxCount--;
+    return true;
+}
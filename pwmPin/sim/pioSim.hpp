@@ -0,0 +1,171 @@
+#pragma once
+
+#include <cstdint>
+#include <sys/types.h>
+
+/**
+ * @brief Instruction level host model of one RP2040 PIO state machine.
+ *
+ * Runs program words clock by clock, with delays, stalls, wrap and
+ * autopull from a TX FIFO, and keeps the 32 pin outputs.  Modelled:
+ *
+ *  - JMP (all conditions but PIN)
+ *  - OUT to PINS, X, Y, NULL, PC
+ *  - PULL (block / noblock, ifempty)
+ *  - SET to PINS, X, Y
+ *  - MOV to PINS, X, Y, OSR from PINS, X, Y, NULL, OSR (none / invert /
+ *    bit-reverse)
+ *
+ * Anything else (WAIT, IN, PUSH, IRQ, side-set) stops the model with an
+ * error.  The clock divider is 1.
+ */
+class PioSim
+{
+public:
+
+    /// TX FIFO depth (joined)
+    static constexpr uint FIFO_DEPTH = 8;
+
+    /**
+     * @brief Load a program at address 0
+     *
+     * @param pProgram - Instructions
+     * @param length - Number of instructions, up to 32
+     * @param wrapTarget - First instruction after wrap
+     * @param wrap - Instruction that wraps
+     */
+    PioSim(const uint16_t* pProgram, const uint length, const uint wrapTarget, const uint wrap);
+
+    /**
+     * @brief Map OUT and SET pins
+     *
+     * @param outBase - First OUT pin
+     * @param outCount - Number of OUT pins
+     * @param setBase - First SET pin
+     * @param setCount - Number of SET pins
+     */
+    void setPins(const uint outBase, const uint outCount, const uint setBase = 0, const uint setCount = 0);
+
+    /**
+     * @brief Configure the output shift register
+     *
+     * @param shiftRight - True to shift out LSB first
+     * @param autoPull - True to refill from the FIFO at the threshold
+     * @param threshold - Bits shifted before a refill, 1 - 32
+     */
+    void setOutShift(const bool shiftRight, const bool autoPull, const uint threshold);
+
+    /**
+     * @brief Put a word in the TX FIFO
+     *
+     * @return true if queued, false if the FIFO is full
+     */
+    bool push(const uint32_t word);
+
+    /**
+     * @brief Get the number of words in the TX FIFO
+     */
+    uint getTxLevel()
+    { return mTxCount; }
+
+    /**
+     * @brief Run one clock
+     *
+     * @return true if run, false if an unmodelled instruction was reached
+     */
+    bool step();
+
+    /**
+     * @brief Get the pin outputs
+     *
+     * @return uint32_t - Bit per GPIO
+     */
+    uint32_t getPins()
+    { return mPins; }
+
+    /**
+     * @brief Get the clocks run
+     */
+    uint64_t getCycles()
+    { return mCycles; }
+
+    /**
+     * @brief Get the clocks spent stalled
+     */
+    uint64_t getStalls()
+    { return mStalls; }
+
+    /**
+     * @brief Get the program counter
+     */
+    uint getPc()
+    { return mPc; }
+
+private:
+
+    /**
+     * @brief Write bits to a range of pins
+     */
+    void writePins(const uint base, const uint count, const uint32_t value);
+
+    /**
+     * @brief Shift bits out of the OSR
+     */
+    uint32_t shiftOut(const uint bits);
+
+    /**
+     * @brief Take a word from the TX FIFO
+     *
+     * @return true if there was one
+     */
+    bool pop(uint32_t& word);
+
+    /// Program
+    uint16_t mProgram[32] = {};
+    /// Program length
+    uint mLength;
+    /// First instruction after wrap
+    uint mWrapTarget;
+    /// Instruction that wraps
+    uint mWrap;
+    /// First OUT pin
+    uint mOutBase = 0;
+    /// Number of OUT pins
+    uint mOutCount = 32;
+    /// First SET pin
+    uint mSetBase = 0;
+    /// Number of SET pins
+    uint mSetCount = 0;
+    /// OSR shift direction
+    bool mShiftRight = true;
+    /// Autopull enabled
+    bool mAutoPull = false;
+    /// Autopull threshold (bits)
+    uint mThreshold = 32;
+
+    /// Program counter
+    uint mPc = 0;
+    /// Scratch X
+    uint32_t mX = 0;
+    /// Scratch Y
+    uint32_t mY = 0;
+    /// Output shift register
+    uint32_t mOsr = 0;
+    /// Bits shifted out of the OSR since it was filled; full means empty
+    uint mOsrShifted = 32;
+    /// Delay clocks left
+    uint mDelay = 0;
+    /// Pin outputs
+    uint32_t mPins = 0;
+    /// TX FIFO
+    uint32_t mTx[FIFO_DEPTH] = {};
+    /// First word in TX FIFO
+    uint mTxHead = 0;
+    /// Words in TX FIFO
+    uint mTxCount = 0;
+    /// Clocks run
+    uint64_t mCycles = 0;
+    /// Clocks stalled
+    uint64_t mStalls = 0;
+
+}; // End class PioSim
@@ -0,0 +1,472 @@
+/**
+ * @brief Host checks of PwmPin against the PWM slice model.
+ *
+ *        Builds PwmPin and PwmGroup with the simulated backend and checks:
+ *         - solveFreq over a sweep of frequencies: the rounded frequency it
+ *           reports, its error, and the best error any divider could give
+ *         - the period and duty the model produces for those settings, in
+ *           trailing edge and phase-correct mode
+ *         - compare values latching at wrap
+ *         - PwmGroup phase offsets in both modes, and that a group
+ *           frequency change never runs a period with mixed settings
+ *         - retuneAll after a clock change
+ *        then times the duty setters.
+ *
+ *        Usage: pwmPin_sim [clockHz]
+ */
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <utility>
+#include <vector>
+
+#include "pwmGroup.hpp"
+#include "pwmPin.hpp"
+#include "pwmSim.hpp"
+
+namespace
+{
+
+/// Frequencies swept (Hz)
+const uint32_t FREQS[] =
+{
+    8, 10, 50, 100, 440, 1'000, 1'234, 5'000, 20'000, 44'100, 65'535,
+    100'000, 333'333, 1'000'000, 2'500'000, 7'777'777, 25'000'000
+};
+
+/// Longest period simulated (clocks)
+const uint64_t MAX_SIM_PERIOD = 300'000;
+
+int errors = 0;
+
+void fail(const char* pMsg, const uint32_t freq)
+{
+    printf("  FAIL %s (%lu Hz)\n", pMsg, static_cast<unsigned long>(freq));
+    errors++;
+}
+
+/**
+ * @brief Frequency of a divider and wrap
+ */
+double exactFreq(const uint32_t clockHz, const uint32_t div16, const uint32_t ticks)
+{
+    return clockHz * 16.0 / (static_cast<double>(div16) * ticks);
+}
+
+/**
+ * @brief Smallest error any divider and wrap can give, ignoring resolution
+ */
+double bestPpm(const uint32_t clockHz, const uint32_t freq, const bool isPhaseCorrect)
+{
+    const double rate = freq * (isPhaseCorrect ? 2.0 : 1.0);
+    double best = INFINITY;
+
+    for(uint32_t div16 = 16; div16 <= 0xFFF; div16++)
+    {
+        double ticks = std::round(clockHz * 16.0 / (rate * div16));
+        ticks = (ticks < 2) ? 2 : (ticks > 0x10000) ? 0x10000 : ticks;
+
+        const double err = std::fabs(exactFreq(clockHz, div16, ticks) / rate - 1) * 1e6;
+        best = (err < best) ? err : best;
+    }
+
+    return best;
+}
+
+void checkSolver(const uint32_t clockHz, const bool isPhaseCorrect)
+{
+    printf("solveFreq at %lu Hz, %s\n", static_cast<unsigned long>(clockHz),
+            isPhaseCorrect ? "phase-correct" : "trailing edge");
+    printf("  %10s %6s %6s %12s %10s %10s\n", "freq", "div16", "wrap", "actual", "ppm", "any div");
+
+    for(const uint32_t freq : FREQS)
+    {
+        PwmPin::PwmSettings settings;
+        if(!PwmPin::solveFreq(clockHz, freq, settings, isPhaseCorrect))
+        {
+            printf("  %10lu unreachable\n", static_cast<unsigned long>(freq));
+            continue;
+        }
+
+        const uint32_t ticks = (settings.wrap + 1) * (isPhaseCorrect ? 2 : 1);
+        const double actual = exactFreq(clockHz, settings.div16, ticks);
+        const double ppm = (actual / freq - 1) * 1e6;
+
+        printf("  %10lu %6u %6u %12.3f %10.3f %10.3f\n", static_cast<unsigned long>(freq),
+                settings.div16, settings.wrap, actual, ppm,
+                bestPpm(clockHz, freq, isPhaseCorrect));
+
+        if(settings.freq != static_cast<uint32_t>(std::llround(actual)))
+        {
+            fail("reported frequency not the rounded actual frequency", freq);
+        }
+    }
+}
+
+void checkTiming(const uint32_t clockHz, const bool isPhaseCorrect)
+{
+    printf("model timing, %s\n", isPhaseCorrect ? "phase-correct" : "trailing edge");
+
+    for(const uint32_t freq : FREQS)
+    {
+        PwmPin::PwmSettings settings;
+        if(!PwmPin::solveFreq(clockHz, freq, settings, isPhaseCorrect))
+        {
+            continue;
+        }
+
+        const uint64_t period16 = static_cast<uint64_t>(settings.div16) *
+                                    (settings.wrap + 1) * (isPhaseCorrect ? 2 : 1);
+        if(period16 / 16 > MAX_SIM_PERIOD)
+        {
+            continue;
+        }
+
+        PwmSim::reset(clockHz);
+
+        PwmPin pinA(0, freq, 0, false);
+        PwmPin pinB(1, freq, 0, false);
+        pinA.setPhaseCorrect(isPhaseCorrect);
+        pinB.setPhaseCorrect(isPhaseCorrect);
+        pinA.setDutyFrac(PwmPin::DUTY_FULL / 3);
+        pinB.setDutyFrac(PwmPin::DUTY_FULL * 9 / 10);
+
+        PwmSim::clearStats();
+        pinA.enablePin();
+
+        // 16 periods use every step of the divider's fraction equally
+        if(!PwmSim::runWraps(0, 17, period16 * 2))
+        {
+            fail("slice didn't wrap", freq);
+            continue;
+        }
+
+        const PwmSim::Stats& stats = PwmSim::getStats(0);
+        const uint64_t cycles = stats.lastWrap - stats.firstWrap;
+        const double measured = clockHz * 16.0 / cycles;
+        const uint32_t ticks = pinA.getWrap() + 1;
+        const double dutyErrA = static_cast<double>(stats.high[0]) * ticks / cycles - pinA.getDutyTicks();
+        const double dutyErrB = static_cast<double>(stats.high[1]) * ticks / cycles - pinB.getDutyTicks();
+
+        printf("  %10lu Hz: measured %12.3f Hz, duty error A %+.3f B %+.3f ticks\n",
+                static_cast<unsigned long>(freq), measured, dutyErrA, dutyErrB);
+
+        if(cycles != period16)
+        {
+            fail("period isn't div x ticks", freq);
+        }
+        if(std::fabs(measured - pinA.getActualFreq()) > 0.5)
+        {
+            fail("measured frequency isn't getActualFreq", freq);
+        }
+        if(std::fabs(dutyErrA) >= 1 || std::fabs(dutyErrB) >= 1)
+        {
+            fail("duty off by a tick or more", freq);
+        }
+    }
+}
+
+void checkLatching(const uint32_t clockHz)
+{
+    printf("compare latched at wrap\n");
+
+    PwmSim::reset(clockHz);
+
+    // Divide by 1, so ticks are clocks
+    PwmPin pin(0, clockHz / 1000, 0, false);
+    if(pin.getWrap() != 999)
+    {
+        fail("unexpected wrap", clockHz / 1000);
+        return;
+    }
+
+    pin.setDutyTicks(250);
+    PwmSim::clearStats();
+    pin.enablePin();
+
+    PwmSim::runWraps(0, 1, 2000);
+    PwmSim::step(500);
+    pin.setDutyTicks(750);
+    PwmSim::runWraps(0, 2, 2000);
+    const uint64_t first = PwmSim::getStats(0).high[0];
+    PwmSim::runWraps(0, 3, 2000);
+    const uint64_t second = PwmSim::getStats(0).high[0] - first;
+
+    printf("  period with change: %llu high, next: %llu high\n",
+            static_cast<unsigned long long>(first), static_cast<unsigned long long>(second));
+
+    if(first != 250 || second != 750)
+    {
+        fail("level changed mid-period", clockHz / 1000);
+    }
+}
+
+void checkGroup(const uint32_t clockHz, const bool isPhaseCorrect)
+{
+    printf("PwmGroup phase, %s\n", isPhaseCorrect ? "phase-correct" : "trailing edge");
+
+    PwmSim::reset(clockHz);
+
+    PwmPin pin0(0, 10'000, 50, false);
+    PwmPin pin1(2, 10'000, 50, false);
+    PwmGroup group;
+    group.add(pin0);
+    group.add(pin1);
+    group.setPhase(pin1, PwmPin::DUTY_FULL / 4);
+
+    // A phase-correct counter's direction can't be set, so its phase is
+    // refused, and one set before the mode change is ignored
+    if(isPhaseCorrect)
+    {
+        pin0.setPhaseCorrect(true);
+        pin1.setPhaseCorrect(true);
+
+        if(group.setPhase(pin1, PwmPin::DUTY_FULL / 4))
+        {
+            fail("phase on a phase-correct slice", 10'000);
+        }
+    }
+
+    PwmSim::clearStats();
+    group.start();
+    PwmSim::runWraps(0, 2, 100'000);
+    PwmSim::runWraps(1, 2, 100'000);
+
+    const uint64_t period = PwmSim::getStats(0).lastWrap - PwmSim::getStats(0).firstWrap;
+    const uint64_t lag = (PwmSim::getStats(1).firstWrap + period - PwmSim::getStats(0).firstWrap) % period;
+
+    printf("  period %llu clocks, slice 1 lags by %llu\n",
+            static_cast<unsigned long long>(period), static_cast<unsigned long long>(lag));
+
+    if(lag != (isPhaseCorrect ? 0 : period / 4))
+    {
+        fail("phase offset", 10'000);
+    }
+
+    // Frequency change through the group waits for a wrap; must not hang
+    if(!group.setFreq(20'000) || pin1.getActualFreq() != 20'000)
+    {
+        fail("group frequency change", 20'000);
+    }
+
+    // A pin destroyed first leaves the group
+    {
+        PwmPin pin2(4, 10'000, 50, false);
+        group.add(pin2);
+    }
+    if(group.getSliceMask() != 0b11)
+    {
+        fail("destroyed pin left in group", 10'000);
+    }
+}
+
+/// Periods of the slices watched by checkGroupFreq: clocks and clocks high
+std::vector<std::pair<uint64_t, uint64_t>> groupPeriods[2];
+
+void recordPeriod(const uint slice)
+{
+    static uint64_t lastWrap[2];
+    static uint64_t lastHigh[2];
+
+    if(slice >= 2)
+    {
+        return;
+    }
+
+    const PwmSim::Stats& stats = PwmSim::getStats(slice);
+    if(stats.wraps > 1)
+    {
+        groupPeriods[slice].emplace_back(stats.lastWrap - lastWrap[slice], stats.high[0] - lastHigh[slice]);
+    }
+
+    lastWrap[slice] = stats.lastWrap;
+    lastHigh[slice] = stats.high[0];
+}
+
+void checkGroupFreq(const uint32_t clockHz, const bool isPhaseCorrect)
+{
+    printf("PwmGroup frequency change, %s\n", isPhaseCorrect ? "phase-correct" : "trailing edge");
+
+    const uint32_t OLD_FREQ = 200;
+    const uint32_t NEW_FREQ = 20'000;
+
+    PwmSim::reset(clockHz);
+
+    // 90% duty: the old levels are far above the new wrap
+    PwmPin pin0(0, OLD_FREQ, 0, false);
+    PwmPin pin1(2, OLD_FREQ, 0, false);
+    pin0.setPhaseCorrect(isPhaseCorrect);
+    pin1.setPhaseCorrect(isPhaseCorrect);
+    pin0.setDutyFrac(PwmPin::DUTY_FULL * 9 / 10);
+    pin1.setDutyFrac(PwmPin::DUTY_FULL * 9 / 10);
+
+    PwmGroup group;
+    group.add(pin0);
+    group.add(pin1);
+
+    groupPeriods[0].clear();
+    groupPeriods[1].clear();
+    PwmSim::clearStats();
+    PwmSim::spOnWrap = recordPeriod;
+    group.start();
+
+    PwmSim::runWraps(0, 3, 10'000'000);
+    if(!group.setFreq(NEW_FREQ))
+    {
+        fail("group frequency change", NEW_FREQ);
+        return;
+    }
+    PwmSim::runWraps(0, PwmSim::getStats(0).wraps + 4, 10'000'000);
+    PwmSim::runWraps(1, PwmSim::getStats(1).wraps + 4, 10'000'000);
+    PwmSim::spOnWrap = nullptr;
+
+    const double oldPeriod = static_cast<double>(clockHz) / OLD_FREQ;
+    const double newPeriod = static_cast<double>(clockHz) / NEW_FREQ;
+
+    for(uint slice = 0; slice < 2; slice++)
+    {
+        bool isNew = false;
+
+        for(const auto& period : groupPeriods[slice])
+        {
+            const double clocks = static_cast<double>(period.first);
+            const double duty = period.second / clocks;
+            const bool isOld = std::fabs(clocks / oldPeriod - 1) < 0.01;
+            isNew = std::fabs(clocks / newPeriod - 1) < 0.01;
+
+            if((!isOld && !isNew) || std::fabs(duty - 0.9) > 0.01)
+            {
+                printf("  slice %u: period of %llu clocks, duty %.4f\n", slice,
+                        static_cast<unsigned long long>(period.first), duty);
+                fail("period with mixed settings", NEW_FREQ);
+            }
+        }
+
+        if(!isNew)
+        {
+            fail("new frequency not reached", NEW_FREQ);
+        }
+    }
+
+    printf("  %zu and %zu periods checked\n", groupPeriods[0].size(), groupPeriods[1].size());
+}
+
+void checkRetune(const uint32_t clockHz)
+{
+    printf("retuneAll\n");
+
+    PwmSim::reset(clockHz);
+
+    PwmPin pin(0, 1'000, 0);
+    pin.setDutyFrac(PwmPin::DUTY_FULL / 3);
+
+    PwmSim::sClockHz = clockHz / 3;
+    if(!PwmPin::retuneAll())
+    {
+        fail("retune", 1'000);
+        return;
+    }
+
+    PwmSim::clearStats();
+    PwmSim::runWraps(0, 17, 2'000'000);
+
+    const PwmSim::Stats& stats = PwmSim::getStats(0);
+    const uint64_t cycles = stats.lastWrap - stats.firstWrap;
+    const double measured = PwmSim::sClockHz * 16.0 / cycles;
+    const double duty = static_cast<double>(stats.high[0]) / cycles;
+
+    printf("  at %lu Hz: %.3f Hz, duty %.5f\n", static_cast<unsigned long>(PwmSim::sClockHz),
+            measured, duty);
+
+    if(pin.getClockFreq() != PwmSim::sClockHz || std::fabs(measured - 1'000) > 0.5 ||
+        std::fabs(duty - 1.0 / 3) > 1e-4)
+    {
+        fail("retuned frequency or duty", 1'000);
+    }
+
+    // Two pins on another slice: the frequency set last is the slice's, and
+    // both keep their duty cycles
+    PwmSim::reset(clockHz);
+
+    PwmPin pinA(2);
+    pinA.setDutyFrac(PwmPin::DUTY_FULL / 4);
+    PwmPin pinB(3, 1'000, 50);
+
+    PwmSim::sClockHz = clockHz / 3;
+    if(!PwmPin::retuneAll())
+    {
+        fail("retune, two pins", 1'000);
+        return;
+    }
+
+    PwmSim::clearStats();
+    PwmSim::runWraps(1, 17, 2'000'000);
+
+    const PwmSim::Stats& statsAB = PwmSim::getStats(1);
+    const uint64_t cyclesAB = statsAB.lastWrap - statsAB.firstWrap;
+    const double measuredAB = PwmSim::sClockHz * 16.0 / cyclesAB;
+    const double dutyA = static_cast<double>(statsAB.high[0]) / cyclesAB;
+    const double dutyB = static_cast<double>(statsAB.high[1]) / cyclesAB;
+
+    printf("  two pins: %.3f Hz, duty A %.5f B %.5f\n", measuredAB, dutyA, dutyB);
+
+    if(pinA.getFreq() != 1'000 || pinB.getFreq() != 1'000 || std::fabs(measuredAB - 1'000) > 0.5 ||
+        std::fabs(dutyA - 0.25) > 1e-4 || std::fabs(dutyB - 0.5) > 1e-4)
+    {
+        fail("retuned frequency or duty, two pins", 1'000);
+    }
+}
+
+void benchmark()
+{
+    const uint32_t CALLS = 10'000'000;
+
+    PwmSim::reset();
+    PwmPin pin(0, 20'000);
+
+    printf("host benchmark (ns per call)\n");
+
+    auto time = [&](const char* pName, auto call)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        for(uint32_t i = 0; i < CALLS; i++)
+        {
+            call(i);
+        }
+        const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+
+        printf("  %-14s %.2f\n", pName, elapsed.count() / CALLS);
+    };
+
+    time("setDuty", [&](uint32_t i) { pin.setDuty(i % 101); });
+    time("setDutyTicks", [&](uint32_t i) { pin.setDutyTicks(i % 6250); });
+    time("setDutyFrac", [&](uint32_t i) { pin.setDutyFrac(i & 0xFFFF); });
+    time("solveFreq", [&](uint32_t i)
+    {
+        PwmPin::PwmSettings settings;
+        PwmPin::solveFreq(125'000'000, 100 + (i & 0xFFFF), settings);
+    });
+}
+
+} // End anonymous namespace
+
+int main(int argc, char* argv[])
+{
+    const uint32_t clockHz = (argc > 1) ? strtoul(argv[1], nullptr, 0) : 125'000'000;
+
+    checkSolver(clockHz, false);
+    checkSolver(clockHz, true);
+    checkTiming(clockHz, false);
+    checkTiming(clockHz, true);
+    checkLatching(clockHz);
+    checkGroup(clockHz, false);
+    checkGroup(clockHz, true);
+    checkGroupFreq(clockHz, false);
+    checkGroupFreq(clockHz, true);
+    checkRetune(clockHz);
+    benchmark();
+
+    printf("%d errors\n", errors);
+    return (errors == 0) ? 0 : 1;
+}
@@ -0,0 +1,176 @@
+#include "pwmSim.hpp"
+
+PwmSim::SliceRegs PwmSim::sSlice[NUM_SLICES];
+volatile uint32_t PwmSim::sEn = 0;
+volatile uint32_t PwmSim::sIntr = 0;
+uint32_t PwmSim::sClockHz = 125'000'000;
+void (*PwmSim::spOnWrap)(const uint slice) = nullptr;
+PwmSim::SliceState PwmSim::sState[NUM_SLICES];
+PwmSim::Stats PwmSim::sStats[NUM_SLICES];
+uint64_t PwmSim::sCycles = 0;
+
+void PwmSim::reset(const uint32_t clockHz)
+{
+    for(uint slice = 0; slice < NUM_SLICES; slice++)
+    {
+        SliceRegs& regs = sSlice[slice];
+        regs.csr = 0;
+        regs.div = 0x10;
+        regs.ctr = 0;
+        regs.cc = 0;
+        regs.top = 0xFFFF;
+
+        sState[slice] = SliceState{};
+        sState[slice].top = 0xFFFF;
+    }
+
+    sEn = 0;
+    sIntr = 0;
+    sClockHz = clockHz;
+    spOnWrap = nullptr;
+    sCycles = 0;
+    clearStats();
+}
+
+void PwmSim::step(const uint64_t cycles)
+{
+    for(uint64_t cycle = 0; cycle < cycles; cycle++)
+    {
+        for(uint slice = 0; slice < NUM_SLICES; slice++)
+        {
+            SliceRegs& regs = sSlice[slice];
+            SliceState& state = sState[slice];
+
+            // Buffered registers go straight through while disabled, up to
+            // the clock it is enabled
+            if(!state.isRunning || (sEn & (1u << slice)) == 0)
+            {
+                state.top = regs.top;
+                state.cc = regs.cc;
+                state.isRunning = (sEn & (1u << slice)) != 0;
+
+                if(!state.isRunning)
+                {
+                    continue;
+                }
+            }
+
+            if(regs.ctr != state.lastCtr)
+            {
+                state.pos = regs.ctr & 0xFFFF;
+                state.lastCtr = state.pos;
+            }
+
+            if(sStats[slice].wraps > 0)
+            {
+                for(uint chan = 0; chan < 2; chan++)
+                {
+                    state.high[chan] += getOutput(slice, chan);
+                }
+            }
+
+            if(state.tickLength == 0)
+            {
+                // Divider INT or INT + 1 clocks; the fraction carries the +1
+                const uint32_t intPart = (regs.div >> 4) & 0xFF;
+                state.fracAcc += regs.div & 0xF;
+                state.tickLength = (intPart == 0) ? 256 : intPart;
+
+                if(state.fracAcc >= 16)
+                {
+                    state.fracAcc -= 16;
+                    state.tickLength++;
+                }
+            }
+
+            if(++state.divCount >= state.tickLength)
+            {
+                state.divCount = 0;
+                state.tickLength = 0;
+                tick(slice);
+            }
+        }
+
+        sCycles++;
+    }
+}
+
+bool PwmSim::runWraps(const uint slice, const uint64_t wraps, const uint64_t maxCycles)
+{
+    const uint64_t end = sCycles + maxCycles;
+
+    while(sStats[slice].wraps < wraps)
+    {
+        if(sCycles >= end)
+        {
+            return false;
+        }
+
+        step();
+    }
+
+    return true;
+}
+
+bool PwmSim::getOutput(const uint slice, const uint chan)
+{
+    const SliceState& state = sState[slice];
+    const uint32_t level = (state.cc >> (chan * 16)) & 0xFFFF;
+    const bool isInverted = sSlice[slice].csr & ((chan == 0) ? CSR_A_INV : CSR_B_INV);
+
+    return (state.lastCtr < level) != isInverted;
+}
+
+void PwmSim::clearStats()
+{
+    for(uint slice = 0; slice < NUM_SLICES; slice++)
+    {
+        sStats[slice] = Stats{};
+        sState[slice].high[0] = 0;
+        sState[slice].high[1] = 0;
+    }
+}
+
+void PwmSim::tick(const uint slice)
+{
+    SliceRegs& regs = sSlice[slice];
+    SliceState& state = sState[slice];
+
+    const bool isPhaseCorrect = regs.csr & CSR_PH_CORRECT;
+    const uint32_t ticks = (state.top + 1) * (isPhaseCorrect ? 2 : 1);
+
+    if(++state.pos >= ticks)
+    {
+        // Wrap: latch the buffered registers and raise the flag
+        state.pos = 0;
+        state.top = regs.top;
+        state.cc = regs.cc;
+        sIntr = sIntr | (1u << slice);
+
+        // The clock after this one is the first of the new period
+        Stats& stats = sStats[slice];
+        if(stats.wraps == 0)
+        {
+            stats.firstWrap = sCycles + 1;
+            state.high[0] = 0;
+            state.high[1] = 0;
+        }
+
+        stats.wraps++;
+        stats.lastWrap = sCycles + 1;
+        stats.high[0] = state.high[0];
+        stats.high[1] = state.high[1];
+
+        if(spOnWrap != nullptr)
+        {
+            spOnWrap(slice);
+        }
+    }
+
+    // Phase-correct counts back down over the second half
+    const uint32_t ctr = (isPhaseCorrect && state.pos > state.top) ?
+                            2 * state.top + 1 - state.pos : state.pos;
+
+    regs.ctr = ctr;
+    state.lastCtr = ctr;
+}
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <cstdint>
+#include <sys/types.h>
+
+/**
+ * @brief Cycle accurate host model of the RP2040 PWM block.
+ *
+ * Software (through PwmHal with PWM_HAL_SIM) reads and writes the
+ * registers below; step() runs the slices one system clock at a time:
+ *
+ *  - The 8.4 divider advances the counter every INT or INT + 1 clocks,
+ *    the fraction adding the extra clock FRAC times in 16 (INT 0 is 256).
+ *  - Trailing edge: the counter runs 0 - TOP and wraps to 0.
+ *  - Phase-correct: the counter runs 0 - TOP and back down to 0, holding
+ *    each end for two ticks, so a period is 2 x (TOP + 1) ticks; it wraps
+ *    at the bottom.
+ *  - TOP and CC are latched at wrap.  A disabled slice latches them as
+ *    they are written.
+ *  - A channel is high while the counter is below its latched level,
+ *    inverted by the CSR A_INV/B_INV bits.
+ *
+ * Only the free-running divider mode is modelled.  The enable bits live in
+ * the en register only, not in each CSR.  A counter written by software
+ * resumes counting up.
+ */
+class PwmSim
+{
+public:
+
+    /// Number of PWM generators
+    static constexpr uint NUM_SLICES = 8;
+
+    /// CSR phase-correct bit
+    static constexpr uint32_t CSR_PH_CORRECT = 1u << 1;
+    /// CSR channel A invert bit
+    static constexpr uint32_t CSR_A_INV = 1u << 2;
+    /// CSR channel B invert bit
+    static constexpr uint32_t CSR_B_INV = 1u << 3;
+
+    /**
+     * @brief Registers of one slice, as on the RP2040
+     */
+    struct SliceRegs
+    {
+        volatile uint32_t csr;
+        volatile uint32_t div;
+        volatile uint32_t ctr;
+        volatile uint32_t cc;
+        volatile uint32_t top;
+    };
+
+    /**
+     * @brief Output measurements of one slice, from its first wrap after
+     *        clearStats to its latest wrap
+     */
+    struct Stats
+    {
+        /// Wraps counted
+        uint64_t wraps;
+        /// Clock of first wrap
+        uint64_t firstWrap;
+        /// Clock of latest wrap
+        uint64_t lastWrap;
+        /// Clocks each channel was high, up to the latest wrap
+        uint64_t high[2];
+    };
+
+    /// Slice registers
+    static SliceRegs sSlice[NUM_SLICES];
+    /// Enable bit per slice
+    static volatile uint32_t sEn;
+    /// Raw wrap flag per slice
+    static volatile uint32_t sIntr;
+    /// System clock frequency reported to software (Hz)
+    static uint32_t sClockHz;
+    /// Called at every wrap, after the stats are updated (optional)
+    static void (*spOnWrap)(const uint slice);
+
+    /**
+     * @brief Put every register back to its reset value and clear stats
+     *
+     * @param clockHz - System clock frequency (Hz)
+     */
+    static void reset(const uint32_t clockHz = 125'000'000);
+
+    /**
+     * @brief Run the enabled slices
+     *
+     * @param cycles - System clocks to run
+     */
+    static void step(const uint64_t cycles = 1);
+
+    /**
+     * @brief Run until a slice has wrapped a number of times since clearStats
+     *
+     * @param slice - PWM generator
+     * @param wraps - Wraps to wait for
+     * @param maxCycles - Give up after this many clocks
+     * @return true if reached, false if timed out
+     */
+    static bool runWraps(const uint slice, const uint64_t wraps, const uint64_t maxCycles);
+
+    /**
+     * @brief Get the level of an output
+     *
+     * @param slice - PWM generator
+     * @param chan - 0 for channel A, 1 for channel B
+     * @return true if high
+     */
+    static bool getOutput(const uint slice, const uint chan);
+
+    /**
+     * @brief Get the measurements of a slice
+     */
+    static const Stats& getStats(const uint slice)
+    { return sStats[slice]; }
+
+    /**
+     * @brief Restart the measurements of every slice
+     */
+    static void clearStats();
+
+    /**
+     * @brief Get the number of clocks run since reset
+     */
+    static uint64_t getCycles()
+    { return sCycles; }
+
+private:
+
+    /**
+     * @brief Model state a slice keeps besides its registers
+     */
+    struct SliceState
+    {
+        /// Latched TOP
+        uint32_t top;
+        /// Latched CC
+        uint32_t cc;
+        /// Clocks since the last counter tick
+        uint32_t divCount;
+        /// Clocks in the current tick
+        uint32_t tickLength;
+        /// Fraction accumulator (1/16 clocks)
+        uint32_t fracAcc;
+        /// Position in the period (ticks)
+        uint32_t pos;
+        /// Counter value last written by the model
+        uint32_t lastCtr;
+        /// Clocks each channel has been high since the first wrap
+        uint64_t high[2];
+        /// True once enabled, until disabled
+        bool isRunning;
+    };
+
+    /**
+     * @brief Advance a slice's counter by one tick
+     */
+    static void tick(const uint slice);
+
+    /// Model state per slice
+    static SliceState sState[NUM_SLICES];
+    /// Measurements per slice
+    static Stats sStats[NUM_SLICES];
+    /// Clocks run since reset
+    static uint64_t sCycles;
+
+}; // End class PwmSim
@@ -0,0 +1,146 @@
+#include "complementaryPwm.hpp"
+
+#include <hardware/clocks.h>
+#include <hardware/pwm.h>
+#include <hardware/sync.h>
+
+#include "pwmPin.hpp"
+
+namespace
+{
+
+/// A = 0 and inverted B held high (above any wrap): both outputs low
+constexpr uint32_t SHUTDOWN_LEVELS = 0xFFFFu << PWM_CH0_CC_B_LSB;
+
+/// Largest wrap; a B level of 0xFFFF must stay above it to hold B low
+constexpr uint32_t MAX_WRAP = 0xFFFE;
+
+} // End anonymous namespace
+
+ComplementaryPwm::ComplementaryPwm
+(
+    const uint8_t gpioPinA,
+    const uint32_t initFreq,
+    const uint32_t deadTimeNs,
+    const bool enable
+)
+:
+mSlice(pwm_gpio_to_slice_num(gpioPinA)),
+mpCc(&pwm_hw->slice[mSlice].cc),
+mDeadTimeNs(deadTimeNs)
+{
+    // Outputs low before the pins are handed to the slice
+    *mpCc = SHUTDOWN_LEVELS;
+    pwm_set_output_polarity(mSlice, false, true);
+    pwm_set_phase_correct(mSlice, true);
+
+    gpio_set_function(gpioPinA, GPIO_FUNC_PWM);
+    gpio_set_function(gpioPinA + 1, GPIO_FUNC_PWM);
+
+    setFreq(initFreq);
+    pwm_set_enabled(mSlice, enable);
+}
+
+bool ComplementaryPwm::setFreq(const uint32_t freq)
+{
+    PwmPin::PwmSettings settings;
+    if(!PwmPin::solveFreq(clock_get_hz(clk_sys), freq, settings, true))
+    {
+        return false;
+    }
+
+    if(settings.wrap > MAX_WRAP)
+    {
+        // Costs at most 1/65536 of the frequency
+        settings.wrap = MAX_WRAP;
+        const uint64_t period16 = static_cast<uint64_t>(settings.div16) * (MAX_WRAP + 1) * 2;
+        settings.freq = (static_cast<uint64_t>(clock_get_hz(clk_sys)) * 16 + period16 / 2) / period16;
+    }
+
+    const uint32_t oldDiv16 = mDiv16;
+    mDiv16 = settings.div16;
+    const uint32_t deadTicks = deadTimeToTicks(mDeadTimeNs);
+
+    if(deadTicks > settings.wrap / 2)
+    {
+        mDiv16 = oldDiv16;
+        return false;
+    }
+
+    mWrap = settings.wrap;
+    mActualFreq = settings.freq;
+    mDeadTicks = deadTicks;
+
+    pwm_set_clkdiv_int_frac(mSlice, mDiv16 / 16, mDiv16 & 0xF);
+    pwm_set_wrap(mSlice, mWrap);
+    writeLevels();
+
+    return true;
+}
+
+bool ComplementaryPwm::setDeadTime(const uint32_t deadTimeNs)
+{
+    const uint32_t deadTicks = deadTimeToTicks(deadTimeNs);
+
+    if(deadTicks > mWrap / 2)
+    {
+        return false;
+    }
+
+    mDeadTimeNs = deadTimeNs;
+    mDeadTicks = deadTicks;
+    writeLevels();
+
+    return true;
+}
+
+void ComplementaryPwm::setDuty(const uint32_t frac)
+{
+    mDutyFrac = (frac < DUTY_FULL) ? frac : DUTY_FULL;
+    writeLevels();
+}
+
+void ComplementaryPwm::shutdown()
+{
+    mIsShutdown = true;
+    *mpCc = SHUTDOWN_LEVELS;
+}
+
+void ComplementaryPwm::resume()
+{
+    mIsShutdown = false;
+    writeLevels();
+}
+
+void ComplementaryPwm::writeLevels()
+{
+    // wrap + 1 keeps A high for the whole period
+    const uint32_t levelA = (mDutyFrac == DUTY_FULL) ? mWrap + 1 : ((mWrap + 1) * mDutyFrac) >> 16;
+
+    // B is inverted: high once the counter is dead time past A's level
+    uint32_t levelB = levelA + mDeadTicks;
+    if(levelB > 0xFFFF)
+    {
+        levelB = 0xFFFF;
+    }
+
+    const uint32_t cc = levelA | (levelB << PWM_CH0_CC_B_LSB);
+
+    // A shutdown from an interrupt between the check and the store would
+    // be overwritten
+    const uint32_t status = save_and_disable_interrupts();
+    if(!mIsShutdown)
+    {
+        *mpCc = cc;
+    }
+    restore_interrupts(status);
+}
+
+uint32_t ComplementaryPwm::deadTimeToTicks(const uint32_t deadTimeNs)
+{
+    // A tick is div16 / 16 clocks; clock in kHz keeps the product in 64 bits
+    const uint64_t clocks = static_cast<uint64_t>(deadTimeNs) * (clock_get_hz(clk_sys) / 1000);
+    const uint64_t perTick = static_cast<uint64_t>(mDiv16) * 62'500;
+
+    return (clocks + perTick - 1) / perTick;
+}
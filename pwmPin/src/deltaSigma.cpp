@@ -0,0 +1,117 @@
+#include "deltaSigma.hpp"
+
+namespace
+{
+
+/// One tick, Q24
+constexpr int64_t TICK = 1 << 24;
+
+/// Error is limited to this many ticks; near 0% and 100% the level clips
+/// and a second order loop would otherwise wind up
+constexpr int64_t MAX_ERR = 2 * TICK;
+
+} // End anonymous namespace
+
+DeltaSigma::DeltaSigma(const Order order)
+:
+mOrder(order)
+{
+}
+
+void DeltaSigma::setPeriod(const uint32_t ticks)
+{
+    // A level must fit the 16 bit compare register
+    mTicks = (ticks == 0) ? 1 : (ticks > 0xFFFF) ? 0xFFFF : ticks;
+    mTarget = static_cast<int64_t>(mTicks) * mDuty;
+}
+
+void DeltaSigma::setDuty(const uint32_t duty)
+{
+    mDuty = (duty < DUTY_FULL) ? duty : DUTY_FULL;
+    mTarget = static_cast<int64_t>(mTicks) * mDuty;
+}
+
+void DeltaSigma::reset()
+{
+    mErr1 = 0;
+    mErr2 = 0;
+}
+
+uint32_t DeltaSigma::next()
+{
+    // y = x + e - e1 (first order), y = x + e - 2e1 + e2 (second order)
+    const int64_t v = (mOrder == Order::Second) ?
+                        mTarget - 2 * mErr1 + mErr2 :
+                        mTarget - mErr1;
+
+    int64_t level = (v + TICK / 2) >> 24;
+    if(level < 0)
+    {
+        level = 0;
+    }
+    else if(level > mTicks)
+    {
+        level = mTicks;
+    }
+
+    int64_t err = (level << 24) - v;
+    if(err > MAX_ERR)
+    {
+        err = MAX_ERR;
+    }
+    else if(err < -MAX_ERR)
+    {
+        err = -MAX_ERR;
+    }
+
+    mErr2 = mErr1;
+    mErr1 = err;
+
+    return static_cast<uint32_t>(level);
+}
+
+void DeltaSigma::fill(uint32_t* pOut, const size_t count, const uint32_t shift, const uint32_t base)
+{
+    for(size_t i = 0; i < count; i++)
+    {
+        pOut[i] = base | (next() << shift);
+    }
+}
+
+void DeltaSigma::fillLoop(uint32_t* pOut, const size_t count, const uint32_t shift, const uint32_t base)
+{
+    if(count == 0)
+    {
+        return;
+    }
+
+    reset();
+
+    int64_t sum = 0;
+    for(size_t i = 0; i < count; i++)
+    {
+        const uint32_t level = next();
+        pOut[i] = base | (level << shift);
+        sum += level;
+    }
+
+    // The loop starts with a cleared history, so the pattern's total can be
+    // a tick or two off; spread the difference evenly over the pattern
+    const int64_t total = (mTarget * static_cast<int64_t>(count) + TICK / 2) >> 24;
+    int64_t diff = total - sum;
+    const int64_t step = (diff > 0) ? 1 : -1;
+    const size_t stride = (diff != 0) ? count / static_cast<size_t>((diff > 0) ? diff : -diff) : 0;
+
+    for(size_t i = 0; diff != 0 && i < count; i += (stride > 0) ? stride : 1)
+    {
+        const int64_t level = (pOut[i] >> shift) & 0xFFFF;
+
+        if(level + step >= 0 && level + step <= mTicks)
+        {
+            pOut[i] = base | (static_cast<uint32_t>(level + step) << shift);
+            diff -= step;
+        }
+    }
+
+    reset();
+}
@@ -0,0 +1,106 @@
+#include "ditheredPwm.hpp"
+
+#include <hardware/pwm.h>
+
+DitheredPwm::DitheredPwm
+(
+    PwmPin& pin,
+    uint32_t* pBuf,
+    const size_t size,
+    const DeltaSigma::Order order,
+    const Mode mode
+)
+:
+mPin(pin),
+mSequencer(pin.getSlice()),
+mModulator(order),
+mpBuf(pBuf),
+mHalfSize(size / 2),
+mMode(mode),
+mShift((pin.getChannel() == PWM_CHAN_B) ? PWM_CH0_CC_B_LSB : PWM_CH0_CC_A_LSB)
+{
+}
+
+uint32_t DitheredPwm::getBase()
+{
+    const uint32_t mask = (mShift == 0) ? PWM_CH0_CC_A_BITS : PWM_CH0_CC_B_BITS;
+    return pwm_hw->slice[mPin.getSlice()].cc & ~mask;
+}
+
+bool DitheredPwm::start(const uint32_t duty)
+{
+    if(mpBuf == nullptr || mHalfSize == 0)
+    {
+        return false;
+    }
+
+    stop();
+
+    mBase = getBase();
+    mDuty = duty;
+    mModulator.setPeriod(mPin.getWrap() + 1);
+    mModulator.setDuty(duty);
+    mModulator.reset();
+
+    if(mMode == Mode::Stream)
+    {
+        mIsRunning = mSequencer.stream(mpBuf, mpBuf + mHalfSize, mHalfSize,
+                                        refill, this);
+    }
+    else
+    {
+        mHalf = 0;
+        mModulator.fillLoop(mpBuf, mHalfSize, mShift, mBase);
+        mIsRunning = mSequencer.play(mpBuf, mHalfSize, PwmSequencer::Mode::Loop);
+    }
+
+    return mIsRunning;
+}
+
+bool DitheredPwm::setDuty(const uint32_t duty)
+{
+    if(!mIsRunning)
+    {
+        return false;
+    }
+
+    mDuty = duty;
+
+    if(mMode == Mode::Loop)
+    {
+        // Build the new pattern while the old one plays, then swap; the
+        // compare register holds its value for the moment between
+        uint32_t* pNext = mpBuf + ((mHalf == 0) ? mHalfSize : 0);
+
+        mModulator.setDuty(duty);
+        mModulator.fillLoop(pNext, mHalfSize, mShift, mBase);
+
+        mSequencer.stop();
+        mSequencer.play(pNext, mHalfSize, PwmSequencer::Mode::Loop);
+        mHalf ^= 1;
+    }
+
+    // Stream mode picks mDuty up at the next refill
+    return true;
+}
+
+void DitheredPwm::stop()
+{
+    if(mIsRunning)
+    {
+        mSequencer.stop();
+        mIsRunning = false;
+    }
+}
+
+void DitheredPwm::refill(uint32_t* pBuf, size_t size, void* pCtx)
+{
+    DitheredPwm* pThis = static_cast<DitheredPwm*>(pCtx);
+
+    if(pThis->mDuty != pThis->mModulator.getDuty())
+    {
+        pThis->mModulator.setDuty(pThis->mDuty);
+    }
+
+    pThis->mModulator.fill(pBuf, size, pThis->mShift, pThis->mBase);
+}
@@ -0,0 +1,282 @@
+#include "ledFader.hpp"
+
+namespace
+{
+
+/// Table size for a curve with 2^bits segments
+template <size_t bits>
+struct CurveTable
+{
+    uint32_t values[(1 << bits) + 1];
+};
+
+/**
+ * @brief Fifth root by Newton's method, for 0 < x <= 1
+ */
+constexpr double root5(const double x)
+{
+    double r = 1.0;
+
+    for(int i = 0; i < 60; i++)
+    {
+        r = (4.0 * r + x / (r * r * r * r)) / 5.0;
+    }
+
+    return r;
+}
+
+/**
+ * @brief Build a table of f(x) for x = 0 - 1, scaled to LEVEL_FULL
+ */
+template <size_t bits, typename Func>
+constexpr CurveTable<bits> makeTable(Func func)
+{
+    CurveTable<bits> table = {};
+    constexpr size_t size = 1 << bits;
+
+    for(size_t i = 0; i <= size; i++)
+    {
+        const double y = func(static_cast<double>(i) / size);
+        table.values[i] = static_cast<uint32_t>(y * LedFader::LEVEL_FULL + 0.5);
+    }
+
+    return table;
+}
+
+// Gamma needs the finer table; the low end is where the eye notices
+constexpr CurveTable<8> GAMMA_TABLE = makeTable<8>([](const double x)
+{
+    // x^2.2 = x^2 * x^0.2
+    return (x > 0.0) ? x * x * root5(x) : 0.0;
+});
+
+constexpr CurveTable<6> EASE_IN_TABLE = makeTable<6>([](const double x)
+{
+    return x * x;
+});
+
+constexpr CurveTable<6> EASE_OUT_TABLE = makeTable<6>([](const double x)
+{
+    return 1.0 - (1.0 - x) * (1.0 - x);
+});
+
+constexpr CurveTable<6> EASE_IN_OUT_TABLE = makeTable<6>([](const double x)
+{
+    return x * x * (3.0 - 2.0 * x);
+});
+
+/**
+ * @brief Look up a curve, interpolating between entries
+ *
+ * @param table - Curve table
+ * @param x - 0 - LEVEL_FULL
+ * @return uint32_t - 0 - LEVEL_FULL
+ */
+template <size_t bits>
+uint32_t lookup(const CurveTable<bits>& table, const uint32_t x)
+{
+    constexpr uint32_t shift = 16 - bits;
+    constexpr uint32_t fracMask = (1u << shift) - 1;
+
+    if(x >= LedFader::LEVEL_FULL)
+    {
+        return LedFader::LEVEL_FULL;
+    }
+
+    const uint32_t i = x >> shift;
+    const uint32_t frac = x & fracMask;
+    const uint32_t y0 = table.values[i];
+    const uint32_t y1 = table.values[i + 1];
+
+    // All curves rise, so y1 >= y0
+    return y0 + (((y1 - y0) * frac) >> shift);
+}
+
+} // End anonymous namespace
+
+LedFader::LedFader(Channel* pChannels, const size_t count)
+:
+mpChannels(pChannels),
+mCount(count)
+{
+    for(size_t i = 0; i < count; i++)
+    {
+        mpChannels[i] = Channel{ nullptr, nullptr, nullptr, 0, 0, 0, 0, 0, 0,
+                                    Easing::Linear, false };
+    }
+}
+
+bool LedFader::attach(const size_t channel, const OutputFunc pOutput, void* pCtx)
+{
+    if(channel >= mCount || pOutput == nullptr)
+    {
+        return false;
+    }
+
+    Channel& chan = mpChannels[channel];
+    deactivate(chan);
+
+    chan.pOutput = pOutput;
+    chan.pCtx = pCtx;
+    chan.level = 0;
+    output(chan);
+
+    return true;
+}
+
+bool LedFader::set(const size_t channel, const uint32_t level)
+{
+    if(channel >= mCount || mpChannels[channel].pOutput == nullptr)
+    {
+        return false;
+    }
+
+    Channel& chan = mpChannels[channel];
+    deactivate(chan);
+
+    chan.level = (level < LEVEL_FULL) ? level : LEVEL_FULL;
+    output(chan);
+
+    return true;
+}
+
+bool LedFader::fade
+(
+    const size_t channel,
+    const uint32_t level,
+    const uint32_t ticks,
+    const Easing easing
+)
+{
+    if(ticks == 0)
+    {
+        return set(channel, level);
+    }
+
+    if(channel >= mCount || mpChannels[channel].pOutput == nullptr)
+    {
+        return false;
+    }
+
+    Channel& chan = mpChannels[channel];
+
+    chan.from = chan.level;
+    chan.to = (level < LEVEL_FULL) ? level : LEVEL_FULL;
+    chan.pos = 0;
+    // The only divide; ticks work from step and ticksLeft
+    chan.step = (1u << 24) / ticks;
+    chan.ticksLeft = ticks;
+    chan.easing = easing;
+
+    if(!chan.isActive)
+    {
+        chan.isActive = true;
+        chan.pNext = mpActive;
+        mpActive = &chan;
+        mActiveCount++;
+    }
+
+    return true;
+}
+
+bool LedFader::stop(const size_t channel)
+{
+    if(channel >= mCount)
+    {
+        return false;
+    }
+
+    deactivate(mpChannels[channel]);
+    return true;
+}
+
+void LedFader::tick()
+{
+    Channel** ppLink = &mpActive;
+
+    while(*ppLink != nullptr)
+    {
+        Channel& chan = **ppLink;
+
+        if(--chan.ticksLeft == 0)
+        {
+            // Land exactly on the target and drop off the list
+            chan.level = chan.to;
+            output(chan);
+
+            chan.isActive = false;
+            *ppLink = chan.pNext;
+            mActiveCount--;
+            continue;
+        }
+
+        chan.pos += chan.step;
+
+        const uint32_t t = ease(chan.easing, chan.pos >> 8);
+
+        if(chan.to >= chan.from)
+        {
+            chan.level = chan.from + (((chan.to - chan.from) * t) >> 16);
+        }
+        else
+        {
+            chan.level = chan.from - (((chan.from - chan.to) * t) >> 16);
+        }
+
+        output(chan);
+        ppLink = &chan.pNext;
+    }
+}
+
+uint32_t LedFader::getLevel(const size_t channel)
+{
+    return (channel < mCount) ? mpChannels[channel].level : 0;
+}
+
+bool LedFader::isFading(const size_t channel)
+{
+    return channel < mCount && mpChannels[channel].isActive;
+}
+
+uint32_t LedFader::gamma(const uint32_t level)
+{
+    return lookup(GAMMA_TABLE, level);
+}
+
+uint32_t LedFader::ease(const Easing easing, const uint32_t t)
+{
+    switch(easing)
+    {
+        case Easing::EaseIn:
+            return lookup(EASE_IN_TABLE, t);
+
+        case Easing::EaseOut:
+            return lookup(EASE_OUT_TABLE, t);
+
+        case Easing::EaseInOut:
+            return lookup(EASE_IN_OUT_TABLE, t);
+
+        default:
+            return (t < LEVEL_FULL) ? t : LEVEL_FULL;
+    }
+}
+
+void LedFader::deactivate(Channel& chan)
+{
+    if(!chan.isActive)
+    {
+        return;
+    }
+
+    for(Channel** ppLink = &mpActive; *ppLink != nullptr; ppLink = &(*ppLink)->pNext)
+    {
+        if(*ppLink == &chan)
+        {
+            *ppLink = chan.pNext;
+            break;
+        }
+    }
+
+    chan.isActive = false;
+    mActiveCount--;
+}
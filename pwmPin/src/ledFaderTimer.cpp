@@ -0,0 +1,84 @@
+#include "ledFaderTimer.hpp"
+
+#include "pwmPin.hpp"
+
+LedFaderTimer::LedFaderTimer(LedFader& fader)
+:
+mFader(fader)
+{
+    critical_section_init(&mLock);
+}
+
+LedFaderTimer::~LedFaderTimer()
+{
+    stop();
+    critical_section_deinit(&mLock);
+}
+
+bool LedFaderTimer::start(const uint32_t periodUs)
+{
+    stop();
+
+    // Negative period: ticks are periodUs apart start to start
+    mIsRunning = add_repeating_timer_us(-static_cast<int64_t>(periodUs),
+                                        onTimer, this, &mTimer);
+    return mIsRunning;
+}
+
+void LedFaderTimer::stop()
+{
+    if(mIsRunning)
+    {
+        cancel_repeating_timer(&mTimer);
+        mIsRunning = false;
+    }
+}
+
+bool LedFaderTimer::attachPin(const size_t channel, PwmPin* pPin)
+{
+    critical_section_enter_blocking(&mLock);
+    const bool result = mFader.attach(channel, pwmOutput, pPin);
+    critical_section_exit(&mLock);
+
+    return result;
+}
+
+bool LedFaderTimer::fade
+(
+    const size_t channel,
+    const uint32_t level,
+    const uint32_t ticks,
+    const LedFader::Easing easing
+)
+{
+    critical_section_enter_blocking(&mLock);
+    const bool result = mFader.fade(channel, level, ticks, easing);
+    critical_section_exit(&mLock);
+
+    return result;
+}
+
+bool LedFaderTimer::set(const size_t channel, const uint32_t level)
+{
+    critical_section_enter_blocking(&mLock);
+    const bool result = mFader.set(channel, level);
+    critical_section_exit(&mLock);
+
+    return result;
+}
+
+void LedFaderTimer::pwmOutput(void* pCtx, uint32_t duty)
+{
+    static_cast<PwmPin*>(pCtx)->setDutyFrac(duty);
+}
+
+bool LedFaderTimer::onTimer(repeating_timer_t* pTimer)
+{
+    LedFaderTimer* pThis = static_cast<LedFaderTimer*>(pTimer->user_data);
+
+    critical_section_enter_blocking(&pThis->mLock);
+    pThis->mFader.tick();
+    critical_section_exit(&pThis->mLock);
+
+    return true;
+}
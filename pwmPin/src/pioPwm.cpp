@@ -0,0 +1,222 @@
+#include "pioPwm.hpp"
+
+#include <hardware/clocks.h>
+#include <hardware/dma.h>
+
+#include "trace.hpp"
+
+int PioPwm::sOffset[NUM_PIOS] = {-1, -1};
+uint PioPwm::sUsers[NUM_PIOS] = {};
+
+namespace
+{
+
+/// The PWM program, for pio_add_program and pio_remove_program; a
+/// constant, so it sits in flash and needs no code at boot or first use
+const pio_program PROGRAM = {PioPwmProgram::INSTRUCTIONS, PioPwmProgram::LENGTH, -1};
+
+} // End anonymous namespace
+
+PioPwm::PioPwm(PIO pio, const uint basePin, const uint pinCount, const uint32_t initFreq)
+:
+mpPio(pio),
+mSm(pio_claim_unused_sm(pio, true)),
+mBasePin(basePin),
+mPinCount((pinCount == 0) ? 1 : (pinCount > PioPwmTable::MAX_PINS) ? PioPwmTable::MAX_PINS : pinCount),
+mDataChan(dma_claim_unused_channel(true)),
+mCtrlChan(dma_claim_unused_channel(true)),
+mClockFreq(clock_get_hz(clk_sys)),
+mpActive(mTables[0])
+{
+    const uint pioIndex = pio_get_index(pio);
+    if(sUsers[pioIndex]++ == 0)
+    {
+        sOffset[pioIndex] = pio_add_program(pio, &PROGRAM);
+    }
+
+    const uint offset = sOffset[pioIndex];
+
+    // Autopull a word for each OUT, so a segment is two FIFO words
+    mConfig = pio_get_default_sm_config();
+    sm_config_set_wrap(&mConfig, offset + PioPwmProgram::WRAP_TARGET, offset + PioPwmProgram::WRAP);
+    sm_config_set_out_pins(&mConfig, basePin, mPinCount);
+    sm_config_set_out_shift(&mConfig, true, true, 32);
+    sm_config_set_fifo_join(&mConfig, PIO_FIFO_JOIN_TX);
+    sm_config_set_clkdiv_int_frac(&mConfig, 1, 0);
+
+    for(uint i = 0; i < mPinCount; i++)
+    {
+        pio_gpio_init(pio, basePin + i);
+    }
+    pio_sm_set_pins_with_mask(pio, mSm, 0, static_cast<uint32_t>(((1ull << mPinCount) - 1) << basePin));
+    pio_sm_set_consecutive_pindirs(pio, mSm, basePin, mPinCount, true);
+
+    // The data channel feeds one table per period, then chains to the
+    // control channel, which writes mpActive to the data channel's read
+    // address trigger and so restarts it with the same count
+    dma_channel_config config = dma_channel_get_default_config(mDataChan);
+    channel_config_set_transfer_data_size(&config, DMA_SIZE_32);
+    channel_config_set_read_increment(&config, true);
+    channel_config_set_write_increment(&config, false);
+    channel_config_set_dreq(&config, pio_get_dreq(pio, mSm, true));
+    channel_config_set_chain_to(&config, mCtrlChan);
+
+    dma_channel_configure(mDataChan, &config, &pio->txf[mSm], mpActive,
+                            PioPwmTable::getSize(mPinCount), false);
+
+    config = dma_channel_get_default_config(mCtrlChan);
+    channel_config_set_transfer_data_size(&config, DMA_SIZE_32);
+    channel_config_set_read_increment(&config, false);
+    channel_config_set_write_increment(&config, false);
+
+    dma_channel_configure(mCtrlChan, &config, &dma_hw->ch[mDataChan].al3_read_addr_trig,
+                            &mpActive, 1, false);
+
+    // The fastest frequency the pins allow is always reachable
+    if(!setFreq(initFreq))
+    {
+        setFreq(mClockFreq / PioPwmTable::getMinPeriod(mPinCount));
+    }
+}
+
+PioPwm::~PioPwm()
+{
+    stop();
+
+    dma_channel_unclaim(mDataChan);
+    dma_channel_unclaim(mCtrlChan);
+    pio_sm_unclaim(mpPio, mSm);
+
+    const uint pioIndex = pio_get_index(mpPio);
+    if(--sUsers[pioIndex] == 0)
+    {
+        pio_remove_program(mpPio, &PROGRAM, sOffset[pioIndex]);
+        sOffset[pioIndex] = -1;
+    }
+}
+
+void PioPwm::start()
+{
+    if(mIsRunning)
+    {
+        return;
+    }
+
+    // Clears the FIFO and shift counters and jumps to the first instruction
+    pio_sm_init(mpPio, mSm, sOffset[pio_get_index(mpPio)] + PioPwmProgram::WRAP_TARGET, &mConfig);
+
+    dma_channel_set_trans_count(mDataChan, PioPwmTable::getSize(mPinCount), false);
+    dma_channel_set_read_addr(mDataChan, mpActive, true);
+
+    pio_sm_set_enabled(mpPio, mSm, true);
+    mIsRunning = true;
+}
+
+void PioPwm::stop()
+{
+    if(!mIsRunning)
+    {
+        return;
+    }
+
+    // Abort both together so neither can chain to the other
+    const uint32_t mask = (1u << mDataChan) | (1u << mCtrlChan);
+    dma_hw->abort = mask;
+    while(dma_hw->abort & mask)
+    {
+        tight_loop_contents();
+    }
+
+    pio_sm_set_enabled(mpPio, mSm, false);
+    pio_sm_clear_fifos(mpPio, mSm);
+    pio_sm_set_pins_with_mask(mpPio, mSm, 0, static_cast<uint32_t>(((1ull << mPinCount) - 1) << mBasePin));
+
+    mIsRunning = false;
+}
+
+bool PioPwm::setFreq(const uint32_t freq)
+{
+    if(freq == 0)
+    {
+        return false;
+    }
+
+    const uint32_t period = (static_cast<uint64_t>(mClockFreq) + freq / 2) / freq;
+    if(period < PioPwmTable::getMinPeriod(mPinCount))
+    {
+        return false;
+    }
+
+    // Same fraction of the new period
+    if(mPeriod != 0)
+    {
+        for(uint i = 0; i < mPinCount; i++)
+        {
+            mLevels[i] = (static_cast<uint64_t>(mLevels[i]) * period + mPeriod / 2) / mPeriod;
+        }
+    }
+
+    mFreq = freq;
+    mPeriod = period;
+    publish();
+
+    return true;
+}
+
+bool PioPwm::setLevel(const uint index, const uint32_t level)
+{
+    if(index >= mPinCount || level > mPeriod)
+    {
+        return false;
+    }
+
+    mLevels[index] = level;
+    publish();
+
+    return true;
+}
+
+bool PioPwm::setLevels(const uint32_t* pLevels)
+{
+    for(uint i = 0; i < mPinCount; i++)
+    {
+        if(pLevels[i] > mPeriod)
+        {
+            return false;
+        }
+    }
+
+    for(uint i = 0; i < mPinCount; i++)
+    {
+        mLevels[i] = pLevels[i];
+    }
+    publish();
+
+    return true;
+}
+
+void PioPwm::publish()
+{
+    TRACE_SCOPE("PioPwm::publish");
+
+    // The data channel may be reading one table, and reloads mpActive at
+    // the end of the period (its read address is one past the end of the
+    // table until then); neither can be written, which leaves the third
+    const uintptr_t readAddr = mIsRunning ? dma_hw->ch[mDataChan].read_addr : 0;
+    uint32_t* pNext = nullptr;
+
+    for(uint32_t* pTable : mTables)
+    {
+        const uintptr_t first = reinterpret_cast<uintptr_t>(pTable);
+        const uintptr_t last = reinterpret_cast<uintptr_t>(pTable + PioPwmTable::getSize(mPinCount));
+
+        if(pTable != mpActive && (readAddr < first || readAddr > last))
+        {
+            pNext = pTable;
+            break;
+        }
+    }
+
+    PioPwmTable::build(mLevels, mPinCount, mPeriod, pNext);
+    mpActive = pNext;
+}
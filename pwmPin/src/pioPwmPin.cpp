@@ -0,0 +1,9 @@
+#include "pioPwmPin.hpp"
+
+PioPwmPin::PioPwmPin(PioPwm& engine, const uint index, const uint8_t initDuty)
+:
+mEngine(engine),
+mIndex(index)
+{
+    setDuty(initDuty);
+}
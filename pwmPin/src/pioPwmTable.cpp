@@ -0,0 +1,116 @@
+#include "pioPwmTable.hpp"
+
+bool PioPwmTable::build
+(
+    const uint32_t* pLevels,
+    const uint32_t pinCount,
+    const uint32_t period,
+    uint32_t* pTable
+)
+{
+    constexpr uint32_t MIN_SEGMENT = PioPwmProgram::SEGMENT_OVERHEAD;
+
+    if(pinCount == 0 || pinCount > MAX_PINS || period < getMinPeriod(pinCount))
+    {
+        return false;
+    }
+
+    // Falling edges, sorted by time
+    uint32_t edgeTimes[MAX_PINS];
+    uint32_t edgePins[MAX_PINS];
+    uint32_t edgeCount = 0;
+    uint32_t highMask = 0;
+
+    for(uint32_t pin = 0; pin < pinCount; pin++)
+    {
+        const uint32_t level = pLevels[pin];
+
+        if(level == 0)
+        {
+            continue;
+        }
+
+        highMask |= 1u << pin;
+
+        // Too close to the end for a segment after it; always high
+        if(level > period - MIN_SEGMENT)
+        {
+            continue;
+        }
+
+        uint32_t i = edgeCount++;
+        while(i > 0 && edgeTimes[i - 1] > level)
+        {
+            edgeTimes[i] = edgeTimes[i - 1];
+            edgePins[i] = edgePins[i - 1];
+            i--;
+        }
+
+        edgeTimes[i] = level;
+        edgePins[i] = pin;
+    }
+
+    // Segment start times and pin levels
+    uint32_t starts[MAX_PINS + 1];
+    uint32_t masks[MAX_PINS + 1];
+    uint32_t count = 1;
+
+    starts[0] = 0;
+    masks[0] = highMask;
+
+    for(uint32_t i = 0; i < edgeCount; i++)
+    {
+        const uint32_t bit = 1u << edgePins[i];
+
+        if(edgeTimes[i] - starts[count - 1] < MIN_SEGMENT)
+        {
+            // Too close to the last edge; fall with it
+            masks[count - 1] &= ~bit;
+        }
+        else
+        {
+            starts[count] = edgeTimes[i];
+            masks[count] = masks[count - 1] & ~bit;
+            count++;
+        }
+    }
+
+    uint32_t lengths[MAX_PINS + 1];
+    for(uint32_t i = 0; i < count; i++)
+    {
+        lengths[i] = ((i + 1 < count) ? starts[i + 1] : period) - starts[i];
+    }
+
+    // Pad to a fixed count by halving the longest segments; the minimum
+    // period leaves the longest at least two segments long
+    while(count < pinCount + 1)
+    {
+        uint32_t longest = 0;
+        for(uint32_t i = 1; i < count; i++)
+        {
+            if(lengths[i] > lengths[longest])
+            {
+                longest = i;
+            }
+        }
+
+        for(uint32_t i = count; i > longest + 1; i--)
+        {
+            lengths[i] = lengths[i - 1];
+            masks[i] = masks[i - 1];
+        }
+
+        lengths[longest + 1] = lengths[longest] - lengths[longest] / 2;
+        masks[longest + 1] = masks[longest];
+        lengths[longest] /= 2;
+        count++;
+    }
+
+    for(uint32_t i = 0; i < count; i++)
+    {
+        pTable[2 * i] = masks[i];
+        pTable[2 * i + 1] = lengths[i] - MIN_SEGMENT;
+    }
+
+    return true;
+}
@@ -0,0 +1,296 @@
+#include "pwmGroup.hpp"
+
+#include "trace.hpp"
+
+PwmGroup::PwmGroup()
+{
+    for(uint slice = 0; slice < PwmHal::NUM_SLICES; slice++)
+    {
+        mpPins[slice][PwmHal::CHAN_A] = nullptr;
+        mpPins[slice][PwmHal::CHAN_B] = nullptr;
+        mPhase[slice] = 0;
+    }
+}
+
+PwmGroup::~PwmGroup()
+{
+    for(uint slice = 0; slice < PwmHal::NUM_SLICES; slice++)
+    {
+        for(uint chan = 0; chan < 2; chan++)
+        {
+            if(mpPins[slice][chan] != nullptr)
+            {
+                remove(*mpPins[slice][chan]);
+            }
+        }
+    }
+}
+
+bool PwmGroup::add(PwmPin& pin)
+{
+    if(pin.mpGroup != nullptr)
+    {
+        return false;
+    }
+
+    const PwmPin* pSibling = mpPins[pin.mSlice][pin.mChan ^ 1];
+    if(pSibling != nullptr && (pSibling->mFreq != pin.mFreq ||
+                                pSibling->mIsPhaseCorrect != pin.mIsPhaseCorrect))
+    {
+        return false;
+    }
+
+    mpPins[pin.mSlice][pin.mChan] = &pin;
+    mSliceMask |= 1u << pin.mSlice;
+    pin.mpGroup = this;
+
+    return true;
+}
+
+bool PwmGroup::remove(PwmPin& pin)
+{
+    if(!isMember(pin))
+    {
+        return false;
+    }
+
+    mpPins[pin.mSlice][pin.mChan] = nullptr;
+    if(mpPins[pin.mSlice][pin.mChan ^ 1] == nullptr)
+    {
+        mSliceMask &= ~(1u << pin.mSlice);
+    }
+
+    // Back to writing settings directly
+    pin.mpGroup = nullptr;
+    if(mFreqMask & (1u << pin.mSlice))
+    {
+        pin.writeFreq();
+    }
+    pin.writeLevel(pin.mLevel);
+
+    return true;
+}
+
+bool PwmGroup::setFreq(const uint32_t freq)
+{
+    TRACE_SCOPE("PwmGroup::setFreq");
+
+    // Check every slice first so a failure changes nothing
+    for(uint slice = 0; slice < PwmHal::NUM_SLICES; slice++)
+    {
+        for(PwmPin* pPin : mpPins[slice])
+        {
+            PwmPin::PwmSettings settings;
+            if(pPin != nullptr && !PwmPin::solveFreq(pPin->mClockFreq, freq, settings,
+                                                                pPin->mIsPhaseCorrect))
+            {
+                return false;
+            }
+        }
+    }
+
+    for(uint slice = 0; slice < PwmHal::NUM_SLICES; slice++)
+    {
+        if(mSliceMask & (1u << slice))
+        {
+            setSliceFreq(*getSlicePin(slice), freq);
+        }
+    }
+
+    update();
+    return true;
+}
+
+bool PwmGroup::setSliceFreq(PwmPin& pin, const uint32_t freq)
+{
+    PwmPin::PwmSettings settings;
+
+    if(!isMember(pin) || !PwmPin::solveFreq(pin.mClockFreq, freq, settings,
+                                                            pin.mIsPhaseCorrect))
+    {
+        return false;
+    }
+
+    // Updates the sibling as well
+    pin.applyFreq(freq, settings);
+
+    return true;
+}
+
+bool PwmGroup::setPhase(PwmPin& pin, const uint32_t frac)
+{
+    const uint32_t phase = (frac < PwmPin::DUTY_FULL) ? frac : 0;
+
+    // Software can't set which way a phase-correct counter counts, and an
+    // offset of less than a half period would need it to start counting down
+    if(!isMember(pin) || (pin.mIsPhaseCorrect && phase != 0))
+    {
+        return false;
+    }
+
+    mPhase[pin.mSlice] = phase;
+    return true;
+}
+
+uint32_t PwmGroup::getSliceLevels(const uint slice)
+{
+    // Keep the level of a channel that isn't in the group
+    uint32_t cc = PwmHal::readCc(slice);
+
+    for(const PwmPin* pPin : mpPins[slice])
+    {
+        if(pPin != nullptr)
+        {
+            const uint32_t level = (pPin->mLevel > 0xFFFF) ? 0xFFFF : pPin->mLevel;
+            cc = (cc & ~pPin->mCcMask) | (level << pPin->mCcShift);
+        }
+    }
+
+    return cc;
+}
+
+void PwmGroup::update()
+{
+    TRACE_SCOPE("PwmGroup::update");
+
+    uint32_t levels[PwmHal::NUM_SLICES];
+
+    // Work out every register value before waiting
+    for(uint slice = 0; slice < PwmHal::NUM_SLICES; slice++)
+    {
+        if(mSliceMask & (1u << slice))
+        {
+            levels[slice] = getSliceLevels(slice);
+        }
+    }
+
+    const uint32_t running = mSliceMask & PwmHal::getEnabledMask();
+    const uint32_t freqMask = mFreqMask & mSliceMask;
+    mFreqMask = 0;
+
+    // Write straight after a wrap of a running slice, so the writes below
+    // all land in the same period
+    if(running != 0)
+    {
+        waitForWrap(1u << __builtin_ctz(running), false);
+    }
+
+    // TOP and CC back to back, so each slice latches both at its next wrap
+    for(uint slice = 0; slice < PwmHal::NUM_SLICES; slice++)
+    {
+        if(freqMask & (1u << slice))
+        {
+            PwmHal::setWrap(slice, getSlicePin(slice)->mWrap);
+        }
+
+        if(mSliceMask & (1u << slice))
+        {
+            PwmHal::writeCc(slice, levels[slice]);
+        }
+    }
+
+    // The divider applies as written: a stopped slice takes it now, a
+    // running one at the wrap that latches its new TOP and CC
+    const uint32_t divMask = freqMask & running;
+
+    for(uint slice = 0; slice < PwmHal::NUM_SLICES; slice++)
+    {
+        if(freqMask & ~running & (1u << slice))
+        {
+            PwmHal::setDiv(slice, getSlicePin(slice)->mDiv16);
+        }
+    }
+
+    waitForWrap(divMask, true);
+}
+
+void PwmGroup::waitForWrap(const uint32_t mask, const bool shouldWriteDiv)
+{
+    uint32_t last[PwmHal::NUM_SLICES];
+
+    for(uint slice = 0; slice < PwmHal::NUM_SLICES; slice++)
+    {
+        if(mask & (1u << slice))
+        {
+            last[slice] = PwmHal::getCounter(slice);
+        }
+    }
+
+    uint32_t waiting = mask;
+    uint32_t falling = 0;
+
+    while(waiting != 0)
+    {
+        for(uint slice = 0; slice < PwmHal::NUM_SLICES; slice++)
+        {
+            if(waiting & (1u << slice))
+            {
+                const uint32_t now = PwmHal::getCounter(slice);
+                bool hasWrapped = false;
+
+                if(!getSlicePin(slice)->mIsPhaseCorrect)
+                {
+                    // Counting up, so a smaller value means it wrapped
+                    hasWrapped = (now < last[slice]);
+                }
+                else if(now < last[slice])
+                {
+                    falling |= 1u << slice;
+                }
+                else if(now > last[slice] && (falling & (1u << slice)))
+                {
+                    // Phase-correct wraps at the bottom, where the count
+                    // turns from down to up
+                    hasWrapped = true;
+                }
+
+                if(hasWrapped)
+                {
+                    waiting &= ~(1u << slice);
+                    if(shouldWriteDiv)
+                    {
+                        PwmHal::setDiv(slice, getSlicePin(slice)->mDiv16);
+                    }
+                }
+
+                last[slice] = now;
+            }
+        }
+    }
+}
+
+void PwmGroup::start()
+{
+    PwmHal::disableMask(mSliceMask);
+
+    for(uint slice = 0; slice < PwmHal::NUM_SLICES; slice++)
+    {
+        if(mSliceMask & (1u << slice))
+        {
+            // Stopped, so a staged frequency can go straight in
+            if(mFreqMask & (1u << slice))
+            {
+                getSlicePin(slice)->writeFreq();
+            }
+
+            // A slice delayed by phase starts that far back from wrap; a
+            // phase-correct one (switched after setPhase) always starts at 0
+            const uint32_t ticks = PwmHal::getWrap(slice) + 1;
+            const uint32_t delay = getSlicePin(slice)->mIsPhaseCorrect ?
+                                    0 : (ticks * mPhase[slice]) >> 16;
+
+            PwmHal::setCounter(slice, (delay == 0) ? 0 : ticks - delay);
+            PwmHal::writeCc(slice, getSliceLevels(slice));
+        }
+    }
+
+    mFreqMask = 0;
+
+    // One write starts them all on the same clock
+    PwmHal::enableMask(mSliceMask);
+}
+
+void PwmGroup::stop()
+{
+    PwmHal::disableMask(mSliceMask);
+}
@@ -0,0 +1,202 @@
+#include "pwmMeasure.hpp"
+
+#include <hardware/clocks.h>
+#include <hardware/pwm.h>
+#include <hardware/sync.h>
+
+namespace
+{
+
+/// Aim to fill the counter this far, leaving headroom for the signal to
+/// speed up between windows
+constexpr uint32_t TARGET_COUNT = 40'000;
+
+/// Largest duty window clock divider (8 bit integer part)
+constexpr uint32_t MAX_DIV = 255;
+
+} // End anonymous namespace
+
+PwmMeasure::PwmMeasure(const uint8_t gpioPin)
+:
+mPin(gpioPin),
+mSlice(pwm_gpio_to_slice_num(gpioPin)),
+mFreqWindowUs(mMinWindowUs),
+mDutyWindowUs(mMinWindowUs)
+{
+}
+
+PwmMeasure::~PwmMeasure()
+{
+    stop();
+}
+
+bool PwmMeasure::start()
+{
+    if(pwm_gpio_to_channel(mPin) != PWM_CHAN_B)
+    {
+        return false;
+    }
+
+    stop();
+
+    gpio_set_function(mPin, GPIO_FUNC_PWM);
+    pwm_set_wrap(mSlice, 0xFFFF);
+
+    mFreqWindowUs = mMinWindowUs;
+    mDutyWindowUs = mMinWindowUs;
+    startWindow(Phase::Freq, 1);
+
+    mAlarm = add_alarm_in_us(mFreqWindowUs, onAlarm, this, true);
+    if(mAlarm <= 0)
+    {
+        pwm_set_enabled(mSlice, false);
+        mAlarm = 0;
+        return false;
+    }
+
+    return true;
+}
+
+void PwmMeasure::stop()
+{
+    if(mAlarm > 0)
+    {
+        cancel_alarm(mAlarm);
+        mAlarm = 0;
+    }
+
+    pwm_set_enabled(mSlice, false);
+}
+
+bool PwmMeasure::getResult(Result& result)
+{
+    uint32_t seq;
+
+    // Retry if the alarm wrote a result while it was being copied
+    do
+    {
+        seq = mSeq;
+        __dmb();
+
+        result.freq = mResult.freq;
+        result.edges = mResult.edges;
+        result.freqWindowUs = mResult.freqWindowUs;
+        result.duty = mResult.duty;
+        result.dutyWindowUs = mResult.dutyWindowUs;
+        result.count = mResult.count;
+
+        __dmb();
+    } while((seq & 1) || seq != mSeq);
+
+    return result.count > 0;
+}
+
+bool PwmMeasure::setWindowLimits(const uint32_t minUs, const uint32_t maxUs)
+{
+    if(minUs < 10 || minUs > maxUs)
+    {
+        return false;
+    }
+
+    mMinWindowUs = minUs;
+    mMaxWindowUs = maxUs;
+    return true;
+}
+
+void PwmMeasure::startWindow(const Phase phase, const uint32_t div)
+{
+    mPhase = phase;
+    mDiv = div;
+
+    pwm_set_clkdiv_mode(mSlice, (phase == Phase::Freq) ? PWM_DIV_B_RISING : PWM_DIV_B_HIGH);
+    pwm_set_clkdiv_int_frac(mSlice, div, 0);
+    pwm_set_counter(mSlice, 0);
+
+    // The raw wrap flag shows if the counter overflowed in the window
+    pwm_clear_irq(mSlice);
+
+    mWindowStart = time_us_64();
+    pwm_set_enabled(mSlice, true);
+}
+
+int64_t PwmMeasure::onWindowEnd()
+{
+    const uint64_t now = time_us_64();
+    const uint32_t count = pwm_get_counter(mSlice);
+    pwm_set_enabled(mSlice, false);
+
+    const bool isOverflow = (pwm_hw->intr & (1u << mSlice)) != 0;
+    const uint64_t elapsed = (now > mWindowStart) ? now - mWindowStart : 1;
+
+    if(mPhase == Phase::Freq)
+    {
+        if(isOverflow)
+        {
+            // Too many edges; retry a much shorter window
+            mFreqWindowUs = (mFreqWindowUs / 16 > mMinWindowUs) ? mFreqWindowUs / 16 : mMinWindowUs;
+            startWindow(Phase::Freq, 1);
+            return static_cast<int64_t>(mFreqWindowUs);
+        }
+
+        mPending.edges = count;
+        mPending.freqWindowUs = elapsed;
+        mPending.freq = (count * 1'000'000ull + elapsed / 2) / elapsed;
+
+        // Next frequency window: long enough for TARGET_COUNT edges
+        uint64_t window = (count > 0) ?
+                            TARGET_COUNT * elapsed / count : mMaxWindowUs;
+        mFreqWindowUs = (window < mMinWindowUs) ? mMinWindowUs :
+                        (window > mMaxWindowUs) ? mMaxWindowUs : window;
+
+        // Duty window: the same length, so it holds about TARGET_COUNT
+        // periods and the partial period at each end costs about as much as
+        // the counter's resolution; capped by the largest divider
+        const uint32_t clkPerUs = clock_get_hz(clk_sys) / 1'000'000;
+        const uint32_t maxDutyUs = MAX_DIV * TARGET_COUNT / clkPerUs;
+        mDutyWindowUs = (mFreqWindowUs < maxDutyUs) ? mFreqWindowUs : maxDutyUs;
+
+        // Divider so a signal high the whole window reaches TARGET_COUNT
+        uint32_t div = (static_cast<uint64_t>(mDutyWindowUs) * clkPerUs + TARGET_COUNT - 1) / TARGET_COUNT;
+        div = (div < 1) ? 1 : (div > MAX_DIV) ? MAX_DIV : div;
+
+        startWindow(Phase::Duty, div);
+        return static_cast<int64_t>(mDutyWindowUs);
+    }
+
+    if(isOverflow)
+    {
+        // The window ran long; a larger divider covers it next time
+        mDutyWindowUs = (mDutyWindowUs / 2 > mMinWindowUs) ? mDutyWindowUs / 2 : mMinWindowUs;
+        startWindow(Phase::Duty, (mDiv * 2 < MAX_DIV) ? mDiv * 2 : MAX_DIV);
+        return static_cast<int64_t>(mDutyWindowUs);
+    }
+
+    // High clocks over window clocks
+    const uint64_t highClocks = static_cast<uint64_t>(count) * mDiv;
+    const uint64_t clocks = elapsed * clock_get_hz(clk_sys) / 1'000'000;
+    const uint64_t duty = (highClocks * DUTY_FULL + clocks / 2) / clocks;
+
+    mPending.duty = (duty < DUTY_FULL) ? duty : DUTY_FULL;
+    mPending.dutyWindowUs = elapsed;
+    mPending.count++;
+
+    // Publish; readers retry while the count is odd
+    mSeq = mSeq + 1;
+    __dmb();
+    mResult.freq = mPending.freq;
+    mResult.edges = mPending.edges;
+    mResult.freqWindowUs = mPending.freqWindowUs;
+    mResult.duty = mPending.duty;
+    mResult.dutyWindowUs = mPending.dutyWindowUs;
+    mResult.count = mPending.count;
+    __dmb();
+    mSeq = mSeq + 1;
+
+    startWindow(Phase::Freq, 1);
+    return static_cast<int64_t>(mFreqWindowUs);
+}
+
+int64_t PwmMeasure::onAlarm(alarm_id_t id, void* pCtx)
+{
+    return static_cast<PwmMeasure*>(pCtx)->onWindowEnd();
+}
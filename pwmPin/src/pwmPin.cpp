@@ -1,54 +1,324 @@
 #include "pwmPin.hpp"
 
-#include <hardware/pwm.h>
+#include "pwmGroup.hpp"
+#include "trace.hpp"
+
+PwmPin* PwmPin::spFirst = nullptr;
+
+const uint32_t PwmPin::PERCENT_TO_FRAC[101] =
+{
+        0,   655,  1311,  1966,  2621,  3277,  3932,  4588,  5243,  5898,
+     6554,  7209,  7864,  8520,  9175,  9830, 10486, 11141, 11796, 12452,
+    13107, 13763, 14418, 15073, 15729, 16384, 17039, 17695, 18350, 19005,
+    19661, 20316, 20972, 21627, 22282, 22938, 23593, 24248, 24904, 25559,
+    26214, 26870, 27525, 28180, 28836, 29491, 30147, 30802, 31457, 32113,
+    32768, 33423, 34079, 34734, 35389, 36045, 36700, 37356, 38011, 38666,
+    39322, 39977, 40632, 41288, 41943, 42598, 43254, 43909, 44564, 45220,
+    45875, 46531, 47186, 47841, 48497, 49152, 49807, 50463, 51118, 51773,
+    52429, 53084, 53740, 54395, 55050, 55706, 56361, 57016, 57672, 58327,
+    58982, 59638, 60293, 60948, 61604, 62259, 62915, 63570, 64225, 64881,
+    65536
+};
 
 PwmPin::PwmPin
-( 
-    const uint8_t gpioPin, 
-    const uint16_t initFreq, 
-    const uint8_t initDuty, 
+(
+    const uint8_t gpioPin,
+    const uint32_t initFreq,
+    const uint8_t initDuty,
     const bool enable
 )
 :
 mPin(gpioPin),
-mSlice(pwm_gpio_to_slice_num(gpioPin)),
-mChan(pwm_gpio_to_channel(gpioPin)),
+mSlice(PwmHal::gpioToSlice(gpioPin)),
+mChan(PwmHal::gpioToChannel(gpioPin)),
 mFreq(initFreq),
-mDuty(initDuty)
+mDuty(initDuty),
+mpCc(PwmHal::getCc(mSlice)),
+mCcShift((mChan == PwmHal::CHAN_B) ? PwmHal::CC_B_LSB : PwmHal::CC_A_LSB),
+mCcMask((mChan == PwmHal::CHAN_B) ? PwmHal::CC_B_BITS : PwmHal::CC_A_BITS),
+mClockFreq(PwmHal::getClockHz())
 {
-    gpio_set_function(mPin, GPIO_FUNC_PWM);
+    mpNext = spFirst;
+    spFirst = this;
+
+    PwmHal::setPwmFunction(mPin);
+    updateScale();
     setFreq(initFreq);
     setDuty(initDuty);
     enablePin(enable);
 }
 
+PwmPin::~PwmPin()
+{
+    if(mpGroup != nullptr)
+    {
+        mpGroup->remove(*this);
+    }
+
+    for(PwmPin** ppPin = &spFirst; *ppPin != nullptr; ppPin = &(*ppPin)->mpNext)
+    {
+        if(*ppPin == this)
+        {
+            *ppPin = mpNext;
+            break;
+        }
+    }
+}
+
+bool PwmPin::solveFreq
+(
+    const uint32_t clockFreq,
+    const uint32_t freq,
+    PwmSettings& settings,
+    const bool isPhaseCorrect
+)
+{
+    // Phase-correct counts up and down, so solve for twice the frequency
+    const uint64_t rate = static_cast<uint64_t>(freq) * (isPhaseCorrect ? 2 : 1);
+
+    // Need at least 2 ticks per period
+    if(rate == 0 || rate > clockFreq / 2)
+    {
+        return false;
+    }
+
+    // Work in 1/16 clock cycles to match the 8.4 divider
+    const uint64_t clock16 = static_cast<uint64_t>(clockFreq) * 16;
+    const uint64_t maxTicks = 0x10000;
+
+    // Smallest divider that fits the period in the counter
+    uint64_t minDiv16 = (clock16 + rate * maxTicks - 1) / (rate * maxTicks);
+    if(minDiv16 < 16)
+    {
+        minDiv16 = 16;
+    }
+    if(minDiv16 > 0xFFF)
+    {
+        return false;
+    }
+
+    // Larger dividers may land closer, but cost resolution; allow up to 1/16,
+    // or at short periods up to the divider giving the whole number of ticks
+    // below the smallest divider's (1/16 would be less than a tick)
+    uint64_t maxDiv16 = minDiv16 + minDiv16 / 16;
+    const uint64_t wholeTicks = clock16 / (rate * minDiv16);
+    if(wholeTicks >= 2)
+    {
+        const uint64_t wholeDiv16 = (clock16 + rate * wholeTicks - 1) / (rate * wholeTicks);
+        maxDiv16 = (wholeDiv16 > maxDiv16) ? wholeDiv16 : maxDiv16;
+    }
+    if(maxDiv16 > 0xFFF)
+    {
+        maxDiv16 = 0xFFF;
+    }
+
+    uint64_t bestErr = UINT64_MAX;
+
+    for(uint64_t div16 = minDiv16; div16 <= maxDiv16; div16++)
+    {
+        uint64_t ticks = (clock16 + rate * div16 / 2) / (rate * div16);
+        if(ticks > maxTicks)
+        {
+            ticks = maxTicks;
+        }
+        if(ticks < 2)
+        {
+            ticks = 2;
+        }
+
+        // Period error, scaled by rate to stay in integers
+        const uint64_t period = div16 * ticks * rate;
+        const uint64_t err = (period > clock16) ? period - clock16 : clock16 - period;
+
+        if(err < bestErr)
+        {
+            bestErr = err;
+            settings.div16 = div16;
+            settings.wrap = ticks - 1;
+        }
+    }
+
+    const uint64_t period16 = static_cast<uint64_t>(settings.div16) *
+                                (settings.wrap + 1) * (isPhaseCorrect ? 2 : 1);
+    settings.freq = (clock16 + period16 / 2) / period16;
+
+    return true;
+}
+
 void PwmPin::enablePin(const bool shouldEnable)
 {
-    pwm_set_enabled(mSlice, shouldEnable);
+    PwmHal::setEnabled(mSlice, shouldEnable);
 }
 
-void PwmPin::setFreq(const uint16_t freq)
+bool PwmPin::setFreq(const uint32_t freq)
 {
-    mFreq = freq;
-    uint32_t divider16 = mClockFreq / mFreq / 4096 + 
-                            (mClockFreq % (mFreq * 4096) != 0);
-    if (divider16 / 16 == 0)
+    TRACE_SCOPE("PwmPin::setFreq");
+
+    // The group keeps both pins of a slice at the same frequency
+    if(mpGroup != nullptr && mpGroup->hasSibling(*this))
+    {
+        return false;
+    }
+
+    PwmSettings settings;
+    if(!solveFreq(mClockFreq, freq, settings, mIsPhaseCorrect))
     {
-        divider16 = 16;
+        return false;
     }
-    
-    mWrap = mClockFreq * 16 / divider16 / mFreq - 1;
-    pwm_set_clkdiv_int_frac(mSlice, divider16/16,
-                                        divider16 & 0xF);
-    pwm_set_wrap(mSlice, mWrap);
+
+    applyFreq(freq, settings);
+    return true;
 }
 
-void PwmPin::setDuty(const uint8_t percent)
+bool PwmPin::setPhaseCorrect(const bool isPhaseCorrect)
 {
-    if(percent <= 100)
+    if(mpGroup != nullptr && mpGroup->hasSibling(*this))
     {
-        mDuty = percent;
+        return false;
+    }
+
+    PwmSettings settings;
+    if(!solveFreq(mClockFreq, mFreq, settings, isPhaseCorrect))
+    {
+        return false;
+    }
 
-        pwm_set_chan_level(mSlice, mChan, mWrap * mDuty / 100);
+    // The mode is the slice's, so the other pin follows
+    for(PwmPin* pPin = spFirst; pPin != nullptr; pPin = pPin->mpNext)
+    {
+        if(pPin->mSlice == mSlice)
+        {
+            pPin->mIsPhaseCorrect = isPhaseCorrect;
+        }
     }
-}
\ No newline at end of file
+
+    PwmHal::setPhaseCorrect(mSlice, isPhaseCorrect);
+    applyFreq(mFreq, settings);
+    return true;
+}
+
+bool PwmPin::setClockFreq(const uint32_t clockFreq)
+{
+    const uint32_t oldClockFreq = mClockFreq;
+
+    mClockFreq = clockFreq;
+    if(!setFreq(mFreq))
+    {
+        mClockFreq = oldClockFreq;
+        return false;
+    }
+
+    return true;
+}
+
+bool PwmPin::retuneAll()
+{
+    TRACE_SCOPE("PwmPin::retuneAll");
+
+    const uint32_t clockFreq = PwmHal::getClockHz();
+
+    uint32_t sliceMask = 0;
+    for(PwmPin* pPin = spFirst; pPin != nullptr; pPin = pPin->mpNext)
+    {
+        sliceMask |= 1u << pPin->mSlice;
+    }
+
+    // Stop together, so the counters hold their relative positions
+    const uint32_t running = sliceMask & PwmHal::getEnabledMask();
+    PwmHal::disableMask(running);
+
+    uint32_t oldTicks[PwmHal::NUM_SLICES];
+    for(uint slice = 0; slice < PwmHal::NUM_SLICES; slice++)
+    {
+        oldTicks[slice] = PwmHal::getWrap(slice) + 1;
+    }
+
+    bool isAllSet = true;
+    uint32_t solvedMask = 0;
+
+    // Once per slice; applyFreq brings the other pin of the slice along
+    for(PwmPin* pPin = spFirst; pPin != nullptr; pPin = pPin->mpNext)
+    {
+        if(solvedMask & (1u << pPin->mSlice))
+        {
+            continue;
+        }
+        solvedMask |= 1u << pPin->mSlice;
+
+        PwmSettings settings;
+        if(!solveFreq(clockFreq, pPin->mFreq, settings, pPin->mIsPhaseCorrect))
+        {
+            isAllSet = false;
+            continue;
+        }
+
+        pPin->mClockFreq = clockFreq;
+        pPin->applyFreq(pPin->mFreq, settings);
+    }
+
+    // A stopped slice latches its settings at once; no wrap to wait for
+    for(PwmPin* pPin = spFirst; pPin != nullptr; pPin = pPin->mpNext)
+    {
+        if(pPin->mpGroup != nullptr)
+        {
+            pPin->writeFreq();
+            pPin->writeCc();
+        }
+    }
+
+    // Same fraction of the new period
+    for(uint slice = 0; slice < PwmHal::NUM_SLICES; slice++)
+    {
+        if(running & (1u << slice))
+        {
+            PwmHal::setCounter(slice, (PwmHal::getCounter(slice) *
+                                        (PwmHal::getWrap(slice) + 1)) / oldTicks[slice]);
+        }
+    }
+
+    PwmHal::enableMask(running);
+    return isAllSet;
+}
+
+void PwmPin::applyFreq(const uint32_t freq, const PwmSettings& settings)
+{
+    // Both pins of a slice share its divider and wrap, so the other pin
+    // (if it has a PwmPin) takes the new frequency too
+    for(PwmPin* pPin = spFirst; pPin != nullptr; pPin = pPin->mpNext)
+    {
+        if(pPin->mSlice == mSlice)
+        {
+            pPin->mFreq = freq;
+            pPin->mActualFreq = settings.freq;
+            pPin->mDiv16 = settings.div16;
+            pPin->mWrap = settings.wrap;
+            pPin->mClockFreq = mClockFreq;
+            pPin->updateScale();
+        }
+    }
+
+    if(mpGroup == nullptr)
+    {
+        writeFreq();
+    }
+    else
+    {
+        mpGroup->stageFreq(mSlice);
+    }
+
+    // Keep the same duty cycles at the new wrap value
+    for(PwmPin* pPin = spFirst; pPin != nullptr; pPin = pPin->mpNext)
+    {
+        if(pPin->mSlice == mSlice)
+        {
+            pPin->setDutyFrac(pPin->mDutyFrac);
+        }
+    }
+}
+
+void PwmPin::updateScale()
+{
+    // Rounding up makes (percent * scale) >> 16 exact for percent <= 100
+    mPercentScale = ((mWrap << 16) + 99) / 100;
+    mTickScale = ((1ull << 32) + mWrap) / (mWrap + 1);
+}
@@ -0,0 +1,299 @@
+#include "pwmSequencer.hpp"
+
+#include <hardware/irq.h>
+#include <hardware/pwm.h>
+
+PwmSequencer* PwmSequencer::spChannels[NUM_DMA_CHANNELS] = {};
+bool PwmSequencer::sIsIrqInstalled = false;
+
+namespace
+{
+
+/**
+ * @brief Greatest common divisor
+ */
+uint64_t gcd(uint64_t a, uint64_t b)
+{
+    while(b != 0)
+    {
+        const uint64_t t = a % b;
+        a = b;
+        b = t;
+    }
+
+    return a;
+}
+
+} // End anonymous namespace
+
+PwmSequencer::PwmSequencer(const uint slice)
+:
+mSlice(slice),
+mDataChan(dma_claim_unused_channel(true)),
+mAuxChan(dma_claim_unused_channel(true)),
+mDreq(pwm_get_dreq(slice))
+{
+}
+
+PwmSequencer::~PwmSequencer()
+{
+    stop();
+
+    dma_channel_unclaim(mDataChan);
+    dma_channel_unclaim(mAuxChan);
+
+    if(mTimer >= 0)
+    {
+        dma_timer_unclaim(mTimer);
+    }
+}
+
+bool PwmSequencer::setPeriodsPerEntry(const uint32_t periods)
+{
+    if(periods == 0 || periods > 0xFFFF || isBusy())
+    {
+        return false;
+    }
+
+    if(periods == 1)
+    {
+        if(mTimer >= 0)
+        {
+            dma_timer_unclaim(mTimer);
+            mTimer = -1;
+        }
+
+        mDreq = pwm_get_dreq(mSlice);
+        return true;
+    }
+
+    // Entry time in 1/16 system clocks: divider (8.4) x ticks x periods
+    const uint32_t csr = pwm_hw->slice[mSlice].csr;
+    uint64_t ticks = pwm_hw->slice[mSlice].top + 1;
+    if(csr & PWM_CH0_CSR_PH_CORRECT_BITS)
+    {
+        ticks *= 2;
+    }
+
+    uint64_t den = pwm_hw->slice[mSlice].div * ticks * periods;
+    uint64_t num = 16;
+
+    // Timer rate is clk_sys * X / Y, both 16 bit; must be exact or the
+    // entries drift against the counter
+    const uint64_t div = gcd(num, den);
+    num /= div;
+    den /= div;
+
+    if(den > 0xFFFF)
+    {
+        return false;
+    }
+
+    if(mTimer < 0)
+    {
+        mTimer = dma_claim_unused_timer(false);
+        if(mTimer < 0)
+        {
+            return false;
+        }
+    }
+
+    dma_timer_set_fraction(mTimer, num, den);
+    mDreq = dma_get_timer_dreq(mTimer);
+
+    return true;
+}
+
+void PwmSequencer::configData
+(
+    const uint chan,
+    const uint chainTo,
+    const uint32_t* pData,
+    const size_t size
+)
+{
+    dma_channel_config config = dma_channel_get_default_config(chan);
+    channel_config_set_transfer_data_size(&config, DMA_SIZE_32);
+    channel_config_set_read_increment(&config, true);
+    channel_config_set_write_increment(&config, false);
+    channel_config_set_dreq(&config, mDreq);
+    channel_config_set_chain_to(&config, chainTo);
+
+    dma_channel_configure(chan, &config, &pwm_hw->slice[mSlice].cc,
+                            pData, size, false);
+}
+
+bool PwmSequencer::play
+(
+    const uint32_t* pTable,
+    const size_t size,
+    const Mode mode,
+    const bool shouldStart
+)
+{
+    if(pTable == nullptr || size == 0 || isBusy())
+    {
+        return false;
+    }
+
+    // Clear out a finished or never started table
+    stop();
+
+    mpTable = pTable;
+
+    if(mode == Mode::Loop)
+    {
+        // At the end of the table the aux channel writes its start back to
+        // the data channel's read address trigger, which restarts it with
+        // the same count
+        configData(mDataChan, mAuxChan, pTable, size);
+
+        dma_channel_config config = dma_channel_get_default_config(mAuxChan);
+        channel_config_set_transfer_data_size(&config, DMA_SIZE_32);
+        channel_config_set_read_increment(&config, false);
+        channel_config_set_write_increment(&config, false);
+
+        dma_channel_configure(mAuxChan, &config,
+                                &dma_hw->ch[mDataChan].al3_read_addr_trig,
+                                &mpTable, 1, false);
+    }
+    else
+    {
+        // Chaining to itself means no chaining
+        configData(mDataChan, mDataChan, pTable, size);
+    }
+
+    mIsActive = true;
+
+    if(shouldStart)
+    {
+        dma_channel_start(mDataChan);
+    }
+
+    return true;
+}
+
+bool PwmSequencer::stream
+(
+    uint32_t* pBufA,
+    uint32_t* pBufB,
+    const size_t size,
+    const RefillFunc pRefill,
+    void* pCtx,
+    const bool shouldStart
+)
+{
+    if(pBufA == nullptr || pBufB == nullptr || size == 0 ||
+        pRefill == nullptr || isBusy())
+    {
+        return false;
+    }
+
+    stop();
+
+    mpBuf[0] = pBufA;
+    mpBuf[1] = pBufB;
+    mBufSize = size;
+    mpRefill = pRefill;
+    mpRefillCtx = pCtx;
+
+    pRefill(pBufA, size, pCtx);
+    pRefill(pBufB, size, pCtx);
+
+    // Each channel starts the other when it finishes, then gets refilled
+    configData(mDataChan, mAuxChan, pBufA, size);
+    configData(mAuxChan, mDataChan, pBufB, size);
+
+    if(!sIsIrqInstalled)
+    {
+        irq_add_shared_handler(DMA_IRQ_0, irqHandler,
+                                PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+        irq_set_enabled(DMA_IRQ_0, true);
+        sIsIrqInstalled = true;
+    }
+
+    spChannels[mDataChan] = this;
+    spChannels[mAuxChan] = this;
+    dma_channel_set_irq0_enabled(mDataChan, true);
+    dma_channel_set_irq0_enabled(mAuxChan, true);
+
+    mIsActive = true;
+
+    if(shouldStart)
+    {
+        dma_channel_start(mDataChan);
+    }
+
+    return true;
+}
+
+void PwmSequencer::startTogether(PwmSequencer* const* pSeqs, const size_t count)
+{
+    uint32_t mask = 0;
+
+    for(size_t i = 0; i < count; i++)
+    {
+        mask |= 1u << pSeqs[i]->mDataChan;
+    }
+
+    dma_start_channel_mask(mask);
+}
+
+void PwmSequencer::stop()
+{
+    if(!mIsActive)
+    {
+        return;
+    }
+
+    const uint32_t mask = (1u << mDataChan) | (1u << mAuxChan);
+
+    // Aborting with the interrupt enabled can raise a spurious interrupt
+    dma_channel_set_irq0_enabled(mDataChan, false);
+    dma_channel_set_irq0_enabled(mAuxChan, false);
+
+    // Abort both together so neither can chain to the other
+    dma_hw->abort = mask;
+    while(dma_hw->abort & mask)
+    {
+        tight_loop_contents();
+    }
+
+    dma_hw->ints0 = mask;
+    spChannels[mDataChan] = nullptr;
+    spChannels[mAuxChan] = nullptr;
+    mIsActive = false;
+}
+
+bool PwmSequencer::isBusy()
+{
+    return dma_channel_is_busy(mDataChan) || dma_channel_is_busy(mAuxChan);
+}
+
+void PwmSequencer::onComplete(const uint chan)
+{
+    // The other channel is playing; rewind and refill this one's buffer
+    // before it chains back here
+    uint32_t* pBuf = mpBuf[(chan == mDataChan) ? 0 : 1];
+
+    mpRefill(pBuf, mBufSize, mpRefillCtx);
+    dma_channel_set_read_addr(chan, pBuf, false);
+}
+
+void PwmSequencer::irqHandler()
+{
+    uint32_t status = dma_hw->ints0;
+
+    while(status != 0)
+    {
+        const uint chan = __builtin_ctz(status);
+        status &= status - 1;
+
+        PwmSequencer* pSeq = spChannels[chan];
+        if(pSeq != nullptr)
+        {
+            dma_hw->ints0 = 1u << chan;
+            pSeq->onComplete(chan);
+        }
+    }
+}
@@ -0,0 +1,197 @@
+#include "stagedPwmPin.hpp"
+
+#include <hardware/irq.h>
+#include <hardware/pwm.h>
+#include <hardware/sync.h>
+
+#include "trace.hpp"
+
+StagedPwmPin* StagedPwmPin::spSlices[NUM_PWM_SLICES] = {};
+bool StagedPwmPin::sIsIrqInstalled = false;
+
+StagedPwmPin::StagedPwmPin
+(
+    const uint8_t gpioPin,
+    const uint32_t initFreq,
+    const uint8_t initDuty,
+    const bool enable
+)
+:
+PwmPin(gpioPin, initFreq, initDuty, enable),
+mStagedDiv(pwm_hw->slice[mSlice].div),
+mStagedTop(mWrap),
+mStagedLevel(mLevel)
+{
+    if(spSlices[mSlice] != nullptr)
+    {
+        return;
+    }
+
+    spSlices[mSlice] = this;
+    mIsRegistered = true;
+
+    if(!sIsIrqInstalled)
+    {
+        irq_add_shared_handler(PWM_IRQ_WRAP, irqHandler,
+                                PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+        irq_set_enabled(PWM_IRQ_WRAP, true);
+        sIsIrqInstalled = true;
+    }
+
+    pwm_clear_irq(mSlice);
+    pwm_set_irq_enabled(mSlice, true);
+}
+
+StagedPwmPin::~StagedPwmPin()
+{
+    if(mIsRegistered)
+    {
+        pwm_set_irq_enabled(mSlice, false);
+        spSlices[mSlice] = nullptr;
+    }
+}
+
+bool StagedPwmPin::stage(const uint32_t freq, const uint32_t frac)
+{
+    TRACE_SCOPE("StagedPwmPin::stage");
+
+    PwmSettings settings;
+
+    if(!mIsRegistered || !solveFreq(mClockFreq, freq, settings, mIsPhaseCorrect))
+    {
+        return false;
+    }
+
+    mFreq = freq;
+    mActualFreq = settings.freq;
+    mDiv16 = settings.div16;
+    mWrap = settings.wrap;
+    updateScale();
+
+    mDutyFrac = (frac < DUTY_FULL) ? frac : DUTY_FULL;
+    mDuty = (mDutyFrac * 100 + DUTY_FULL / 2) >> 16;
+    mLevel = (mDutyFrac == DUTY_FULL) ? mWrap + 1 : ((mWrap + 1) * mDutyFrac) >> 16;
+
+    publish(settings.div16, settings.wrap, mLevel);
+    return true;
+}
+
+bool StagedPwmPin::stageDutyFrac(const uint32_t frac)
+{
+    if(!mIsRegistered)
+    {
+        return false;
+    }
+
+    mDutyFrac = (frac < DUTY_FULL) ? frac : DUTY_FULL;
+    mDuty = (mDutyFrac * 100 + DUTY_FULL / 2) >> 16;
+    mLevel = (mDutyFrac == DUTY_FULL) ? mWrap + 1 : ((mWrap + 1) * mDutyFrac) >> 16;
+
+    publish(mDiv16, mWrap, mLevel);
+    return true;
+}
+
+bool StagedPwmPin::stageDutyTicks(const uint32_t ticks)
+{
+    if(!mIsRegistered || ticks > mWrap + 1)
+    {
+        return false;
+    }
+
+    mDutyFrac = (static_cast<uint64_t>(ticks) * mTickScale) >> 16;
+    mDuty = (mDutyFrac * 100 + DUTY_FULL / 2) >> 16;
+    mLevel = ticks;
+
+    publish(mDiv16, mWrap, mLevel);
+    return true;
+}
+
+void StagedPwmPin::publish(const uint32_t div, const uint32_t top, const uint32_t level)
+{
+    const uint32_t seq = mSeq;
+
+    // Odd while writing; the interrupt skips a half written stage
+    mSeq = seq + 1;
+    __dmb();
+
+    mStagedDiv = div;
+    mStagedTop = top;
+    mStagedLevel = (level > 0xFFFF) ? 0xFFFF : level;
+    mStagedWrap = mWraps;
+
+    __dmb();
+    mSeq = seq + 2;
+}
+
+void StagedPwmPin::commit()
+{
+    const uint32_t wraps = mWraps + 1;
+    mWraps = wraps;
+
+    pwm_slice_hw_t& slice = pwm_hw->slice[mSlice];
+
+    // The TOP and CC committed last wrap have just latched; the divider
+    // goes with them into the period starting now
+    if(mIsDivPending)
+    {
+        slice.div = mPendingDiv;
+        mIsDivPending = false;
+    }
+
+    const uint32_t seq = mSeq;
+
+    // Nothing new, or the producer is part way through
+    if(seq == mCommittedSeq || (seq & 1))
+    {
+        return;
+    }
+
+    __dmb();
+    const uint32_t div = mStagedDiv;
+    const uint32_t top = mStagedTop;
+    const uint32_t level = mStagedLevel;
+    const uint32_t stagedWrap = mStagedWrap;
+    __dmb();
+
+    // Restaged while copying; try again next wrap
+    if(mSeq != seq)
+    {
+        return;
+    }
+
+    // TOP and CC are latched at the next wrap, but DIV applies as soon as
+    // it is written, so it waits for the wrap that latches them
+    slice.top = top;
+    hw_write_masked(mpCc, level << mCcShift, mCcMask);
+
+    if(slice.div != div)
+    {
+        mPendingDiv = div;
+        mIsDivPending = true;
+    }
+
+    if(wraps - stagedWrap > 1)
+    {
+        mLateCommits = mLateCommits + 1;
+    }
+
+    mCommittedSeq = seq;
+}
+
+void StagedPwmPin::irqHandler()
+{
+    uint32_t status = pwm_get_irq_status_mask();
+
+    while(status != 0)
+    {
+        const uint slice = __builtin_ctz(status);
+        status &= status - 1;
+
+        StagedPwmPin* pPin = spSlices[slice];
+        if(pPin != nullptr)
+        {
+            pwm_clear_irq(slice);
+            pPin->commit();
+        }
+    }
+}
@@ -88,7 +88,9 @@ int main()
     // Create object that uses write, setPin, delayMs functions defined above
     SSD1306 oled(&write, &setPin, &delayMs, DC_PIN, RESET_PIN, WIDTH, HEIGHT);
 
-    Framebuffer fb(128, 64);
+    // Screen buffer in .bss, so it builds with RP_PICO_DRIVERS_STATIC too
+    static Framebuffer::Storage<128, 64> fbStorage;
+    Framebuffer fb(fbStorage);
     fb.setFont(&font);
 
     // Scroll "Hello World!" up and down    
@@ -0,0 +1,107 @@
+/**
+ * @file buffer.hpp
+ * @brief Fixed size array owned by a driver object, or lent to it by the
+ *        caller.
+ *
+ * Objects built from a size allocate their buffers on the heap; objects
+ * built from a Storage (see Framebuffer::Storage and friends) use the
+ * caller's memory, typically a static, so their RAM shows up in .bss at
+ * link time.  With RP_NO_HEAP (-DRP_PICO_DRIVERS_STATIC=ON) only the
+ * second kind exists and nothing in the driver allocates.
+ */
+#pragma once
+
+#include <cstddef>
+#include <utility>
+
+#ifndef RP_NO_HEAP
+#include <vector>
+#endif
+
+template <typename T>
+class Buffer
+{
+public:
+
+#ifndef RP_NO_HEAP
+    /**
+     * @brief Construct a new Buffer object on the heap
+     *
+     * @param size - number of elements
+     * @param value - initial value of every element
+     */
+    Buffer(const size_t size, const T& value)
+    :   mOwned(size, value),
+        mpData(mOwned.data()),
+        mSize(size)
+    {
+    }
+#endif
+
+    /**
+     * @brief Construct a new Buffer object in the caller's memory
+     *
+     * @param pData - at least size elements, used for the Buffer's lifetime
+     * @param size - number of elements
+     * @param value - initial value of every element
+     */
+    Buffer(T* pData, const size_t size, const T& value)
+    :   mpData(pData),
+        mSize(size)
+    {
+        for(size_t i = 0; i < size; i++)
+        {
+            pData[i] = value;
+        }
+    }
+
+    // Copies would share or lose the memory
+    Buffer(const Buffer&) = delete;
+    Buffer& operator=(const Buffer&) = delete;
+
+    /**
+     * @brief Exchange contents with another buffer of the same size, by
+     *        swapping pointers
+     */
+    void swap(Buffer& other)
+    {
+#ifndef RP_NO_HEAP
+        mOwned.swap(other.mOwned);
+#endif
+        std::swap(mpData, other.mpData);
+        std::swap(mSize, other.mSize);
+    }
+
+    T* data()
+    { return mpData; }
+
+    const T* data() const
+    { return mpData; }
+
+    size_t size() const
+    { return mSize; }
+
+    T& operator[](const size_t i)
+    { return mpData[i]; }
+
+    const T& operator[](const size_t i) const
+    { return mpData[i]; }
+
+    T* begin()
+    { return mpData; }
+
+    T* end()
+    { return mpData + mSize; }
+
+private:
+
+#ifndef RP_NO_HEAP
+    /// Heap memory, if the buffer owns it
+    std::vector<T> mOwned;
+#endif
+    /// Elements
+    T* mpData;
+    /// Number of elements
+    size_t mSize;
+
+}; // End class Buffer
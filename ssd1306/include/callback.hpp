@@ -0,0 +1,41 @@
+/**
+ * @file callback.hpp
+ * @brief Type of the functions the driver calls back (bus writes, pins,
+ *        clocks).
+ *
+ * Normally a std::function, so lambdas with captures and bound member
+ * functions can be passed.  When built with RP_NO_HEAP
+ * (-DRP_PICO_DRIVERS_STATIC=ON) it is a plain function pointer instead:
+ * std::function can allocate for large captures and brings in exception
+ * and RTTI support, and a function pointer member leaves the objects
+ * constant-initializable.  Free functions and lambdas without captures
+ * work in both builds.
+ */
+#pragma once
+
+#ifndef RP_NO_HEAP
+#include <functional>
+#endif
+
+#ifdef RP_NO_HEAP
+
+template <typename Signature>
+struct CallbackType;
+
+template <typename Result, typename... Args>
+struct CallbackType<Result(Args...)>
+{
+    using Type = Result (*)(Args...);
+};
+
+/// Function the driver calls, e.g. Callback<uint32_t()>
+template <typename Signature>
+using Callback = typename CallbackType<Signature>::Type;
+
+#else
+
+/// Function the driver calls, e.g. Callback<uint32_t()>
+template <typename Signature>
+using Callback = std::function<Signature>;
+
+#endif
@@ -0,0 +1,182 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "buffer.hpp"
+#include "callback.hpp"
+
+class SSD1306;
+
+/**
+ * @brief Sends frames to the display a few pages at a time, so a frame
+ *        never blocks the caller for longer than it allows.
+ *
+ * submit copies a frame into the session; step sends at most maxPages
+ * pages, or as many as fit in maxUs microseconds, then returns.  Call step
+ * from the main loop between real-time work until isIdle.
+ *
+ * Each step sets the RAM window to the pages it sends
+ * (SSD1306::writePages), so sending resumes at the right place even if
+ * other writes went to the display in between.
+ *
+ * Frames are handed over without tearing: the frame being sent is the
+ * session's own copy, and a frame submitted mid-flush waits in a second
+ * buffer until the current one is complete.  Submitting again before it
+ * starts replaces it, so the display always catches up with the newest
+ * frame and never shows a mix of two.
+ *
+ * The time budget is kept by timing the pages already sent; a step always
+ * sends at least one page, so a budget shorter than one page is exceeded
+ * by that page.
+ *
+ * Built from a Storage, the two frame buffers are the caller's; RP_NO_HEAP
+ * builds have only that constructor.
+ */
+class FlushSession
+{
+public:
+
+    /**
+     * @brief Memory for a session on a WIDTH x HEIGHT display
+     */
+    template <size_t WIDTH, size_t HEIGHT>
+    struct Storage
+    {
+        /// Frame being sent
+        uint8_t front[WIDTH * HEIGHT / 8];
+        /// Frame waiting
+        uint8_t pending[WIDTH * HEIGHT / 8];
+    };
+
+#ifndef RP_NO_HEAP
+    /**
+     * @brief Construct a new FlushSession object
+     *
+     * @param display - display to send frames to
+     * @param getUsFunc - Function returning a microsecond clock
+     */
+    FlushSession(SSD1306& display, Callback<uint32_t()> getUsFunc);
+#endif
+
+    /**
+     * @brief Construct a new FlushSession object in the caller's memory
+     *
+     * If the storage isn't the display's size every submit fails.
+     *
+     * @param display - display to send frames to
+     * @param getUsFunc - Function returning a microsecond clock
+     * @param storage - buffers, used for the session's lifetime
+     */
+    template <size_t WIDTH, size_t HEIGHT>
+    FlushSession(SSD1306& display, Callback<uint32_t()> getUsFunc, Storage<WIDTH, HEIGHT>& storage)
+    :   FlushSession(display, getUsFunc, storage.front, storage.pending, WIDTH * HEIGHT / 8)
+    {
+    }
+
+    /**
+     * @brief Queue a frame to be sent after the one in progress
+     *
+     * @param pData - pointer to page-major data (Framebuffer::getBuffer)
+     * @param size - size of data; must be a whole screen
+     * @return true if frame queued, false if size wrong
+     */
+    bool submit(const uint8_t* pData, const size_t size);
+
+    /**
+     * @brief Send part of the frame in progress
+     *
+     * Starts the queued frame once the current one is complete, in the same
+     * step if the budget allows.
+     *
+     * @param maxPages - most pages to send
+     * @param maxUs - time budget (us), 0 for no limit
+     * @return size_t - pages sent
+     */
+    size_t step(const size_t maxPages, const uint32_t maxUs = 0);
+
+    /**
+     * @brief Check if every submitted frame has been sent
+     */
+    bool isIdle() const
+    { return !mIsSending && !mIsPending; }
+
+    /**
+     * @brief Get the number of pages of the current frame already sent
+     */
+    size_t getPagesSent() const
+    { return mPage; }
+
+    /**
+     * @brief Get the number of pages in a frame
+     */
+    size_t getPageCount() const
+    { return mPageCount; }
+
+    /**
+     * @brief Get the number of frames sent completely
+     */
+    uint32_t getFramesSent() const
+    { return mFramesSent; }
+
+    /**
+     * @brief Get the number of queued frames replaced before being started
+     */
+    uint32_t getFramesReplaced() const
+    { return mFramesReplaced; }
+
+    /**
+     * @brief Get the measured time to send one page (us)
+     */
+    uint32_t getUsPerPage() const
+    { return mUsPerPage; }
+
+private:
+
+    /**
+     * @brief Construct a new FlushSession object on two caller buffers
+     *
+     * @param display - display to send frames to
+     * @param getUsFunc - Function returning a microsecond clock
+     * @param pFront - first buffer
+     * @param pPending - second buffer
+     * @param size - size of each buffer
+     */
+    FlushSession
+    (
+        SSD1306& display,
+        Callback<uint32_t()> getUsFunc,
+        uint8_t* pFront,
+        uint8_t* pPending,
+        const size_t size
+    );
+
+    /// Display being written
+    SSD1306& mDisplay;
+    /// Function object for reading the microsecond clock
+    Callback<uint32_t()> mGetUs;
+
+    /// Bytes per page
+    const size_t mPageSize;
+    /// Pages per frame
+    const size_t mPageCount;
+
+    /// Frame being sent
+    Buffer<uint8_t> mFront;
+    /// Frame waiting for mFront to finish
+    Buffer<uint8_t> mPending;
+
+    /// Next page of mFront to send
+    size_t mPage = 0;
+    /// True while mFront is part way sent
+    bool mIsSending = false;
+    /// True if mPending holds a frame
+    bool mIsPending = false;
+    /// Time to send one page (us), 0 until measured
+    uint32_t mUsPerPage = 0;
+    /// Frames sent
+    uint32_t mFramesSent = 0;
+    /// Pending frames replaced
+    uint32_t mFramesReplaced = 0;
+
+}; // End class FlushSession
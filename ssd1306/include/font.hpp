@@ -1,356 +1,16 @@
 /**
- * @file font.hpp 
+ * @file font.hpp
  * @brief Simple monochrome "font" graphics.
+ *
+ * The built-in 6x7 font, generated at build time from
+ * ssd1306/fonts/font6x7.bdf: printable ASCII, every glyph 8 pixels apart,
+ * 7 rows above the baseline and 2 for descenders.  fonts::FONT_6X7P is the
+ * same glyphs spaced by their own widths.
  */
 #pragma once
 
-#include <map>
-#include <vector>
+#include "font6x7.hpp"
+#include "font6x7p.hpp"
 
-std::map<char, std::vector<std::vector<bool>>> font =
-{
-    // Space
-    {
-        ' ',   {{0,0,0,0,0,0},
-                {0,0,0,0,0,0},
-                {0,0,0,0,0,0},
-                {0,0,0,0,0,0}, 
-                {0,0,0,0,0,0},
-                {0,0,0,0,0,0},
-                {0,0,0,0,0,0}}
-    },
-    {
-        'A',   {{0,0,1,1,0,0},
-                {0,1,0,0,1,0},
-                {1,0,0,0,0,1},
-                {1,0,0,0,0,1},
-                {1,1,1,1,1,1},
-                {1,0,0,0,0,1},
-                {1,0,0,0,0,1}}
-    },
-    {
-        'B',   {{1,1,1,1,1,0},
-                {1,0,0,0,0,1},
-                {1,0,0,0,0,1},
-                {1,1,1,1,1,0}, 
-                {1,0,0,0,0,1},
-                {1,0,0,0,0,1},
-                {1,1,1,1,1,0}}
-    },
-    {
-        'C',   {{0,0,1,1,1,0},
-                {0,1,0,0,0,1},
-                {1,0,0,0,0,0},
-                {1,0,0,0,0,0}, 
-                {1,0,0,0,0,0},
-                {0,1,0,0,0,1},
-                {0,0,1,1,1,0}}
-    },
-    {
-        'D',   {{1,1,1,1,0,0},
-                {1,0,0,0,1,0},
-                {1,0,0,0,0,1},
-                {1,0,0,0,0,1}, 
-                {1,0,0,0,0,1},
-                {1,0,0,0,1,0},
-                {1,1,1,1,0,0}}
-    },
-    {
-        'E',   {{1,1,1,1,1,1},
-                {1,0,0,0,0,0},
-                {1,0,0,0,0,0},
-                {1,1,1,1,1,0}, 
-                {1,0,0,0,0,0},
-                {1,0,0,0,0,0},
-                {1,1,1,1,1,1}}
-    },
-    {
-        'F',   {{1,1,1,1,1},
-                {1,0,0,0,0},
-                {1,0,0,0,0},
-                {1,1,1,1,0}, 
-                {1,0,0,0,0},
-                {1,0,0,0,0},
-                {1,0,0,0,0}}
-    },
-    {
-        'G',   {{0,1,1,1,1,0},
-                {1,0,0,0,0,1},
-                {1,0,0,0,0,0},
-                {1,0,0,0,0,0}, 
-                {1,0,0,1,1,1},
-                {1,0,0,0,0,1},
-                {0,1,1,1,1,0}}
-    },
-    {
-        'H',   {{1,0,0,0,0,1},
-                {1,0,0,0,0,1},
-                {1,0,0,0,0,1},
-                {1,1,1,1,1,1}, 
-                {1,0,0,0,0,1},
-                {1,0,0,0,0,1},
-                {1,0,0,0,0,1}}
-    },
-    {
-        'I',   {{1,1,1,1,1},
-                {0,0,1,0,0},
-                {0,0,1,0,0},
-                {0,0,1,0,0}, 
-                {0,0,1,0,0},
-                {0,0,1,0,0},
-                {1,1,1,1,1}}
-    },
-    {
-        'J',   {{0,0,0,0,0,1},
-                {0,0,0,0,0,1},
-                {0,0,0,0,0,1},
-                {0,0,0,0,0,1}, 
-                {1,0,0,0,0,1},
-                {1,0,0,0,0,1},
-                {0,1,1,1,1,0}}
-    },
-    {
-        'K',   {{1,0,0,0,1,0},
-                {1,0,0,1,0,0},
-                {1,0,1,0,0,0},
-                {1,1,1,0,0,0}, 
-                {1,0,0,1,0,0},
-                {1,0,0,0,1,0},
-                {1,0,0,0,0,1}}
-    },
-    {
-        'L',   {{1,0,0,0,0},
-                {1,0,0,0,0},
-                {1,0,0,0,0},
-                {1,0,0,0,0}, 
-                {1,0,0,0,0},
-                {1,0,0,0,0},
-                {1,1,1,1,1}}
-    },
-    {
-        'M',   {{1,0,0,0,0,1},
-                {1,1,0,0,1,1},
-                {1,0,1,1,0,1},
-                {1,0,0,0,0,1}, 
-                {1,0,0,0,0,1},
-                {1,0,0,0,0,1},
-                {1,0,0,0,0,1}}
-    },
-    {
-        'N',   {{1,0,0,0,0,1},
-                {1,1,0,0,0,1},
-                {1,0,1,0,0,1},
-                {1,0,1,0,0,1}, 
-                {1,0,0,1,0,1},
-                {1,0,0,0,1,1},
-                {1,0,0,0,0,1}}
-    },
-    {
-        'O',   {{0,1,1,1,1,0},
-                {1,0,0,0,0,1},
-                {1,0,0,0,0,1},
-                {1,0,0,0,0,1}, 
-                {1,0,0,0,0,1},
-                {1,0,0,0,0,1},
-                {0,1,1,1,1,0}}
-    },
-    {
-        'P',   {{1,1,1,1,1,0},
-                {1,0,0,0,0,1},
-                {1,0,0,0,0,1},
-                {1,1,1,1,1,0}, 
-                {1,0,0,0,0,0},
-                {1,0,0,0,0,0},
-                {1,0,0,0,0,0}}
-    },
-    {
-        'Q',   {{0,1,1,1,1,0},
-                {1,0,0,0,0,1},
-                {1,0,0,0,0,1},
-                {1,0,0,0,0,1}, 
-                {1,0,0,1,0,1},
-                {0,1,1,1,1,0},
-                {0,0,0,0,0,1}}
-    },
-    {
-        'R',   {{1,1,1,1,1,0},
-                {1,0,0,0,0,1},
-                {1,0,0,0,0,1},
-                {1,1,1,1,1,0}, 
-                {1,0,0,1,0,0},
-                {1,0,0,0,1,0},
-                {1,0,0,0,0,1}}
-    },
-    {
-        'S',   {{0,1,1,1,1,1},
-                {1,0,0,0,0,0},
-                {1,0,0,0,0,0},
-                {0,1,1,1,1,0}, 
-                {0,0,0,0,0,1},
-                {0,0,0,0,0,1},
-                {1,1,1,1,1,0}}
-    },
-    {
-        'T',   {{1,1,1,1,1},
-                {0,0,1,0,0},
-                {0,0,1,0,0},
-                {0,0,1,0,0}, 
-                {0,0,1,0,0},
-                {0,0,1,0,0},
-                {0,0,1,0,0}}
-    },
-    {
-        'U',   {{1,0,0,0,0,1},
-                {1,0,0,0,0,1},
-                {1,0,0,0,0,1},
-                {1,0,0,0,0,1}, 
-                {1,0,0,0,0,1},
-                {1,0,0,0,0,1},
-                {0,1,1,1,1,0}}
-    },
-    {
-        'V',   {{1,0,0,0,1},
-                {1,0,0,0,1},
-                {1,0,0,0,1},
-                {0,1,0,1,0}, 
-                {0,1,0,1,0},
-                {0,1,0,1,0},
-                {0,0,1,0,0}}
-    },
-    {
-        'W',   {{1,0,0,0,0,1},
-                {1,0,0,0,0,1},
-                {1,0,0,0,0,1},
-                {1,0,0,0,0,1}, 
-                {1,0,1,1,0,1},
-                {1,1,0,0,1,1},
-                {1,0,0,0,0,1}}
-    },
-    {
-        'X',   {{1,0,0,0,0,1},
-                {0,1,0,0,1,0},
-                {0,1,0,0,1,0},
-                {0,0,1,1,0,0}, 
-                {0,1,0,0,1,0},
-                {0,1,0,0,1,0},
-                {1,0,0,0,0,1}}
-    },
-    {
-        'Y',   {{1,0,0,0,1},
-                {0,1,0,1,0},
-                {0,0,1,0,0},
-                {0,0,1,0,0}, 
-                {0,0,1,0,0},
-                {0,0,1,0,0},
-                {0,0,1,0,0}}
-    },
-    {
-        'Z',   {{1,1,1,1,1,1},
-                {0,0,0,0,0,1},
-                {0,0,0,0,1,0},
-                {0,0,0,1,0,0}, 
-                {0,0,1,0,0,0},
-                {0,1,0,0,0,0},
-                {1,1,1,1,1,1}}
-    },
-    {
-        '0',   {{0,1,1,1,1,0},
-                {1,1,0,0,0,1},
-                {1,0,1,0,0,1},
-                {1,0,0,1,0,1}, 
-                {1,0,0,1,0,1},
-                {1,0,0,0,1,1},
-                {0,1,1,1,1,0}}
-    },
-    {
-        '1',   {{0,0,1,0,0},
-                {0,1,1,0,0},
-                {0,0,1,0,0},
-                {0,0,1,0,0}, 
-                {0,0,1,0,0},
-                {0,0,1,0,0},
-                {1,1,1,1,1}}
-    },
-    {
-        '2',   {{0,1,1,1,1,0},
-                {1,0,0,0,0,1},
-                {0,0,0,0,1,1},
-                {0,0,0,1,0,0}, 
-                {0,0,1,0,0,0},
-                {0,1,0,0,0,0},
-                {1,1,1,1,1,1}}
-    },
-    {
-        '3',   {{1,1,1,1,1,0},
-                {0,0,0,0,0,1},
-                {0,0,0,0,0,1},
-                {0,0,0,1,1,0}, 
-                {0,0,0,0,0,1},
-                {0,0,0,0,0,1},
-                {1,1,1,1,1,0}}
-    },
-    {
-        '4',   {{0,0,1,1,1,0},
-                {0,1,0,0,1,0},
-                {1,0,0,0,1,0},
-                {1,1,1,1,1,1}, 
-                {0,0,0,0,1,0},
-                {0,0,0,0,1,0},
-                {0,0,0,0,1,0}}
-    },
-    {
-        '5',   {{1,1,1,1,1,1},
-                {1,0,0,0,0,0},
-                {1,1,1,1,1,0},
-                {0,0,0,0,0,1}, 
-                {0,0,0,0,0,1},
-                {0,0,0,0,0,1},
-                {1,1,1,1,1,0}}
-    },
-    {
-        '6',   {{0,0,1,1,1,0},
-                {0,1,0,0,0,0},
-                {1,0,0,0,0,0},
-                {1,1,1,1,1,0}, 
-                {1,0,0,0,0,1},
-                {1,0,0,0,0,1},
-                {0,1,1,1,1,0}}
-    },
-    {
-        '7',   {{1,1,1,1,1,1},
-                {0,0,0,0,0,1},
-                {0,0,0,0,1,0},
-                {0,0,0,1,0,0}, 
-                {0,0,1,0,0,0},
-                {0,1,0,0,0,0},
-                {1,0,0,0,0,0}}
-    },
-    {
-        '8',   {{0,1,1,1,1,0},
-                {1,0,0,0,0,1},
-                {1,0,0,0,0,1},
-                {0,1,1,1,1,0}, 
-                {1,0,0,0,0,1},
-                {1,0,0,0,0,1},
-                {0,1,1,1,1,0}}
-    },
-    {
-        '9',   {{1,1,1,1,1,1},
-                {1,0,0,0,0,1},
-                {1,0,0,0,0,1},
-                {0,1,1,1,1,1}, 
-                {0,0,0,0,0,1},
-                {0,0,0,0,0,1},
-                {0,0,0,0,0,1}}
-    },
-    {
-        '!',   {{0,0,1,0,0},
-                {0,0,1,0,0},
-                {0,0,1,0,0},
-                {0,0,1,0,0}, 
-                {0,0,1,0,0},
-                {0,0,0,0,0},
-                {0,0,1,0,0}}
-    }
-
-}; // End font
\ No newline at end of file
+/// The built-in font, for Framebuffer::setFont(&font)
+inline const Font& font = fonts::FONT_6X7;
@@ -0,0 +1,274 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "buffer.hpp"
+#include "callback.hpp"
+
+/**
+ * @brief Streams what the display shows to a host, as compressed deltas.
+ *
+ * Attach with SSD1306::setMirror; every frame and page written to the
+ * display is copied into the mirror's picture of the screen.  Changes go
+ * out as packets: the screen XORed with the last picture sent, run-length
+ * encoded, so unchanged bytes cost almost nothing.  A keyframe (the screen
+ * itself, run-length encoded) starts the stream and repeats every
+ * keyInterval packets, so a host can join or recover at any time.
+ *
+ * A token bucket holds the stream to bytesPerSec.  A change that doesn't
+ * fit yet stays pending (the next packet carries it, merged with any
+ * later changes) instead of being queued, so memory and the time spent
+ * per display write stay bounded.  Call poll now and then so the last
+ * change is sent once the budget allows, even if the display goes idle.
+ *
+ * Packet, little endian:
+ *
+ *     0   2  magic 0xA5 'M'
+ *     2   1  type (1 keyframe, 2 delta)
+ *     3   1  reserved (0)
+ *     4   2  sequence number
+ *     6   4  time (ms)
+ *     10  2  width (pixels)
+ *     12  2  height (pixels)
+ *     14  2  payload length
+ *     16  n  payload
+ *     16+n 2 Fletcher-16 of bytes 2 to 15 + n
+ *
+ * Payload: PackBits style runs; a control byte c < 128 is followed by
+ * c + 1 literal bytes, c >= 128 by one byte repeated c - 125 times.  The
+ * decoded payload is a page-major frame (Framebuffer::getBuffer layout).
+ *
+ * ssd1306/tools/mirrorDecode.py rebuilds the frames on the host.
+ *
+ * Its buffers, about three screens' worth, can come from a Storage
+ * instead of the heap.
+ */
+class FrameMirror
+{
+public:
+
+    /// First byte of a packet
+    static constexpr uint8_t MAGIC_0 = 0xA5;
+    /// Second byte of a packet
+    static constexpr uint8_t MAGIC_1 = 'M';
+    /// Packet type: whole screen
+    static constexpr uint8_t TYPE_KEYFRAME = 1;
+    /// Packet type: XOR with the previous screen
+    static constexpr uint8_t TYPE_DELTA = 2;
+    /// Bytes before the payload
+    static constexpr size_t HEADER_SIZE = 16;
+    /// Bytes after the payload
+    static constexpr size_t TRAILER_SIZE = 2;
+    /// Longest literal run in a payload
+    static constexpr size_t MAX_LITERAL = 128;
+
+    /**
+     * @brief Get the size of the largest packet for a screen: a payload of
+     *        nothing but literal runs
+     *
+     * @param width - Screen width
+     * @param height - Screen height
+     * @return size_t - bytes
+     */
+    static constexpr size_t getMaxPacket(const size_t width, const size_t height)
+    {
+        return HEADER_SIZE + width * height / 8 +
+               (width * height / 8 + MAX_LITERAL - 1) / MAX_LITERAL + TRAILER_SIZE;
+    }
+
+    /**
+     * @brief Memory for a mirror of a WIDTH x HEIGHT screen
+     */
+    template <size_t WIDTH, size_t HEIGHT>
+    struct Storage
+    {
+        /// Screen as the display has it
+        uint8_t screen[WIDTH * HEIGHT / 8];
+        /// Screen as the host has it
+        uint8_t sent[WIDTH * HEIGHT / 8];
+        /// Packet being built
+        uint8_t packet[getMaxPacket(WIDTH, HEIGHT)];
+    };
+
+#ifndef RP_NO_HEAP
+    /**
+     * @brief Construct a new FrameMirror object
+     *
+     * @param writeFunc - Function to send bytes to the host (USB CDC, UART,
+     *                    pipe); should not block for long
+     *                    Signature:
+     *                      pData - pointer to data being written
+     *                      size - size of data being written
+     * @param getMsFunc - Function returning a millisecond clock
+     * @param width - Screen width
+     * @param height - Screen height
+     * @param bytesPerSec - Stream budget (bytes per second)
+     * @param keyInterval - Packets between keyframes
+     */
+    FrameMirror
+    (
+        Callback<void(const uint8_t* pData, const size_t size)> writeFunc,
+        Callback<uint32_t()> getMsFunc,
+        const size_t width,
+        const size_t height,
+        const uint32_t bytesPerSec = 4096,
+        const uint32_t keyInterval = 64
+    );
+#endif
+
+    /**
+     * @brief Construct a new FrameMirror object in the caller's memory
+     *
+     * @param writeFunc - Function to send bytes to the host
+     * @param getMsFunc - Function returning a millisecond clock
+     * @param storage - buffers for a WIDTH x HEIGHT screen, used for the
+     *                  mirror's lifetime
+     * @param bytesPerSec - Stream budget (bytes per second)
+     * @param keyInterval - Packets between keyframes
+     */
+    template <size_t WIDTH, size_t HEIGHT>
+    FrameMirror
+    (
+        Callback<void(const uint8_t* pData, const size_t size)> writeFunc,
+        Callback<uint32_t()> getMsFunc,
+        Storage<WIDTH, HEIGHT>& storage,
+        const uint32_t bytesPerSec = 4096,
+        const uint32_t keyInterval = 64
+    )
+    :   FrameMirror(writeFunc, getMsFunc, WIDTH, HEIGHT, bytesPerSec, keyInterval,
+                    storage.screen, storage.sent, storage.packet)
+    {
+    }
+
+    /**
+     * @brief Take a whole frame written to the display
+     *
+     * @param pData - pointer to page-major data
+     * @param size - size of data
+     */
+    void onFrame(const uint8_t* pData, const size_t size);
+
+    /**
+     * @brief Take a run of columns written to one page of the display
+     *
+     * @param page - page (row of 8 pixels)
+     * @param col - first column
+     * @param pData - pointer to one byte per column
+     * @param size - number of columns
+     */
+    void onPage(const size_t page, const size_t col, const uint8_t* pData, const size_t size);
+
+    /**
+     * @brief Send the pending change if the budget allows
+     *
+     * @return true if a packet was sent
+     */
+    bool poll();
+
+    /**
+     * @brief Make the next packet a keyframe
+     */
+    void requestKeyframe()
+    { mIsKeyRequested = true; }
+
+    /**
+     * @brief Get the number of packets sent
+     */
+    uint32_t getPacketsSent() const
+    { return mPacketsSent; }
+
+    /**
+     * @brief Get the number of bytes sent
+     */
+    uint32_t getBytesSent() const
+    { return mBytesSent; }
+
+    /**
+     * @brief Get the number of changes merged into a later packet because
+     *        the budget was spent
+     */
+    uint32_t getDeferred() const
+    { return mDeferred; }
+
+private:
+
+    /**
+     * @brief Construct a new FrameMirror object on caller buffers
+     *
+     * @param pScreen - width * height / 8 bytes
+     * @param pSent - width * height / 8 bytes
+     * @param pPacket - getMaxPacket(width, height) bytes
+     */
+    FrameMirror
+    (
+        Callback<void(const uint8_t*, const size_t)> writeFunc,
+        Callback<uint32_t()> getMsFunc,
+        const size_t width,
+        const size_t height,
+        const uint32_t bytesPerSec,
+        const uint32_t keyInterval,
+        uint8_t* pScreen,
+        uint8_t* pSent,
+        uint8_t* pPacket
+    );
+
+    /**
+     * @brief Encode the screen, or its XOR with the last one sent, into
+     *        mPacket's payload
+     *
+     * @param isKey - If true the screen, if false the XOR
+     * @return size_t - payload size
+     */
+    size_t encode(const bool isKey);
+
+    /**
+     * @brief Add the tokens earned since the last call
+     */
+    void refill();
+
+    /// Function object for writing to the host
+    Callback<void(const uint8_t*, const size_t)> mWrite;
+    /// Function object for reading the millisecond clock
+    Callback<uint32_t()> mGetMs;
+
+    /// Screen width, pixels
+    const size_t mWidth;
+    /// Screen height, pixels
+    const size_t mHeight;
+    /// Stream budget (bytes per second)
+    const uint32_t mBytesPerSec;
+    /// Packets between keyframes
+    const uint32_t mKeyInterval;
+    /// Largest packet; also the bucket size, so any packet can go
+    const size_t mMaxPacket;
+
+    /// Screen as the display has it
+    Buffer<uint8_t> mScreen;
+    /// Screen as the host has it
+    Buffer<uint8_t> mSent;
+    /// Packet being built
+    Buffer<uint8_t> mPacket;
+
+    /// Budget (bytes x 1000)
+    uint64_t mTokens;
+    /// Time of the last refill (ms)
+    uint32_t mLastMs;
+    /// Next sequence number
+    uint16_t mSeq = 0;
+    /// Packets since the last keyframe
+    uint32_t mSinceKey = 0;
+    /// True if mScreen changed since the last packet
+    bool mIsDirty = false;
+    /// True if the next packet must be a keyframe
+    bool mIsKeyRequested = true;
+    /// Size of the packet the budget last couldn't cover
+    size_t mNeeded = 0;
+    /// Packets sent
+    uint32_t mPacketsSent = 0;
+    /// Bytes sent
+    uint32_t mBytesSent = 0;
+    /// Changes merged into a later packet
+    uint32_t mDeferred = 0;
+
+}; // End class FrameMirror
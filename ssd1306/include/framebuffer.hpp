@@ -1,23 +1,95 @@
 #pragma once
 
 #include <cstdint>
-#include <map>
-#include <vector>
+
+#include "buffer.hpp"
+#include "packedFont.hpp"
+#include "pixelFormat.hpp"
+
+/**
+ * @brief Pixel layouts accepted by Framebuffer::setBuffer
+ */
+enum class ImageFormat
+{
+    /// The framebuffer's own pixel format, copied as is
+    Native,
+    /// SSD1306 RAM order: page by page, one byte per column, bit 0 on top
+    PageMajor,
+    /// Column by column, one byte per page, bit 0 on top
+    ColumnMajor,
+    /// Row by row, bit 7 is the leftmost pixel (PBM P4 style)
+    RowMajorMsbFirst,
+    /// Row by row, bit 0 is the leftmost pixel (XBM style)
+    RowMajorLsbFirst
+};
+
+/**
+ * @brief Horizontal placement of text in a box, for Framebuffer::setTextBox
+ */
+enum class TextAlign
+{
+    /// Against the left edge
+    Left,
+    /// Centered
+    Center,
+    /// Against the right edge
+    Right
+};
 
 /**
- * @brief Framebuffer represents SSD1306 RAM.
+ * @brief Framebuffer represents controller RAM.
+ * 
+ * Pixels are kept packed in the controller's own layout, given by the
+ * Format (see pixelFormat.hpp), so whole images can be copied in and out
+ * and every drawing operation is compiled for that layout.
+ * 
+ * A Storage puts the buffer in the caller's memory instead of the heap.
+ * 
+ * @tparam Format - pixel format, e.g. MonoPageFormat or Ssd1322Format
  */
-class Framebuffer
+template <typename Format>
+class BasicFramebuffer
 {
 public:
 
+    /// Pixel value type (bool for 1 bit per pixel)
+    using Pixel = typename Format::Pixel;
+
+    /// Largest text magnification
+    static constexpr size_t MAX_TEXT_SCALE = 4;
+
+    /**
+     * @brief Memory for a WIDTH x HEIGHT screen
+     */
+    template <size_t WIDTH, size_t HEIGHT>
+    struct Storage
+    {
+        /// Screen RAM, in Format's layout
+        uint8_t buf[Format::bufSize(WIDTH, HEIGHT)];
+    };
+
+#ifndef RP_NO_HEAP
     /**
      * @brief Construct a new Framebuffer object
      * 
      * @param width - width of the screen in pixels
      * @param height - height of the screen in pixels
      */
-    Framebuffer(const size_t width, const size_t height);
+    BasicFramebuffer(const size_t width, const size_t height);
+#endif
+
+    /**
+     * @brief Construct a new Framebuffer object in the caller's memory
+     * 
+     * @param storage - buffer, used for the framebuffer's lifetime
+     */
+    template <size_t WIDTH, size_t HEIGHT>
+    explicit BasicFramebuffer(Storage<WIDTH, HEIGHT>& storage)
+    :   mWidth(WIDTH),
+        mHeight(HEIGHT),
+        mBuf(storage.buf, sizeof(storage.buf), 0)
+    {
+    }
 
     /**
      * @brief Get the size of screen buffer, in bytes
@@ -25,7 +97,7 @@ public:
      * @return size_t number of bytes
      */
     size_t getBufSize()
-    { return mWidth * mHeight / 8; }
+    { return mBuf.size(); }
 
     /**
      * @brief Get the pixel value at a given location
@@ -34,7 +106,7 @@ public:
      * @param y - y coordinate of pixel
      * @return Value of pixel
      */
-    bool getPixel(const size_t x, const size_t y);
+    Pixel getPixel(const size_t x, const size_t y);
     
     /**
      * @brief Set the pixel value at given location
@@ -44,48 +116,109 @@ public:
      * @param val - value to set
      * @return true if x,y valid, false if invalid
      */
-    bool setPixel(const size_t x, const size_t y, const bool val);
+    bool setPixel(const size_t x, const size_t y, const Pixel val);
 
     /**
      * @brief Get pointer to buffer
      * 
-     * @return uint8_t* - pointer to buffer
+     * @return uint8_t* - pointer to buffer, ready for the controller
      */
     uint8_t* getBuffer();
 
     /**
      * @brief Directly set buffer
      * 
+     * Native data is copied as is.  1 bit per pixel layouts are converted a
+     * block of 8x8 pixels at a time for MonoPageFormat (where PageMajor is
+     * native), and to fully on/off pixels for other formats.  Row-major
+     * rows are padded to whole bytes.
+     * 
      * @param pData - pointer to buffer data
      * @param size - size of buffer data
+     * @param format - layout of buffer data
+     * @return true if size matches the screen in that layout, false otherwise
+     */
+    bool setBuffer
+    (
+        const uint8_t* pData, 
+        const size_t size, 
+        const ImageFormat format = ImageFormat::Native
+    );
+
+    /**
+     * @brief Set buffer from a PBM (P1 or P4) image the size of the screen
+     * 
+     * Set (black) PBM pixels turn the matching screen pixels fully on.
+     * 
+     * @param pData - pointer to PBM file contents
+     * @param size - size of PBM file contents
+     * @return true if image valid and matches the screen size, false otherwise
      */
-    void setBuffer(const uint8_t* pData, const size_t size);
+    bool loadPbm(const uint8_t* pData, const size_t size);
 
     /**
-     * @brief Set the font map used to look up characters
+     * @brief Set the font used to look up characters
      * 
-     * @param pFontMap - pointer to font map
+     * @param pFont - pointer to a generated font (see packedFont.hpp)
      */
-    void setFont(const std::map<char,std::vector<std::vector<bool>>>* pFontMap)
-    { mpFontMap = pFontMap; }
+    void setFont(const Font* pFont)
+    { mpFont = pFont; }
 
     /**
      * @brief Put a character at a given location
      * 
-     * @param c - character
+     * The glyph is placed by its metrics: x is the pen position and y the
+     * bottom of the line, so descenders sit above y.  Characters the font
+     * doesn't have are drawn as its fallback glyph.
+     * 
+     * @param codepoint - Unicode code point
      * @param x - x coordinate of character
      * @param y - y coordinate of character
-     * @return true if x,y valid, false if invalid
+     * @return true if x,y valid and the font has the character, false otherwise
+     */
+    bool setChar(const uint32_t codepoint, const size_t x, const size_t y);
+
+    /**
+     * @brief Set text color
+     * 
+     * @param fg - value for glyph pixels
+     * @param bg - value for the rest of each glyph cell
      */
-    bool setChar(const char c, const size_t x, const size_t y);
+    void setTextColor(const Pixel fg, const Pixel bg = Format::PIXEL_OFF)
+    { mTextFg = fg; mTextBg = bg; }
+
+    /**
+     * @brief Set how glyphs are combined with what is already drawn
+     * 
+     * @param op - raster op (RasterOp::Copy paints the whole glyph cell)
+     */
+    void setTextRasterOp(const RasterOp op)
+    { mTextOp = op; }
+
+    /**
+     * @brief Set text magnification
+     * 
+     * Glyph columns are expanded a byte at a time with lookup tables and
+     * each pixel becomes a scale x scale block; advances, offsets and line
+     * heights are scaled to match.
+     * 
+     * @param scale - 1 to MAX_TEXT_SCALE
+     * @return true if scale valid, false otherwise
+     */
+    bool setTextScale(const size_t scale);
 
     /**
      * @brief Set horizontal line of text at given location
      * 
+     * Text is UTF-8; bytes that aren't valid UTF-8 are drawn as U+FFFD
+     * (or the font's fallback glyph).  Each character moves the pen by its
+     * glyph's advance; characters the font doesn't have are drawn as its
+     * fallback glyph.
+     * 
      * @param x - x coordinate of text
      * @param y - y coordintate of text
-     * @param pText - text
-     * @param size - size of text
+     * @param pText - UTF-8 text
+     * @param size - size of text in bytes
      * @return true if text fit onto screen, false otherwise
      */
     bool setText
@@ -96,8 +229,57 @@ public:
         const size_t size
     );
 
+    /**
+     * @brief Get the width of a line of text in the current font
+     * 
+     * @param pText - UTF-8 text
+     * @param size - size of text in bytes
+     * @return size_t - width in pixels
+     */
+    size_t getTextWidth(const char* pText, const size_t size) const
+    { return (mpFont != nullptr) ? mpFont->getTextWidth(pText, size) * mTextScale : 0; }
+
+    /**
+     * @brief Lay out text in a box and draw it
+     * 
+     * Lines stack the way glyphs stand: the first line's cell is at the
+     * top of the box (its lineHeight rows below y1, times the text scale),
+     * the next one a line height below that, and so on while whole lines
+     * fit above y0.  '\n' starts a new line.
+     * 
+     * Each line is measured as it is broken, then aligned and drawn
+     * straight into the buffer; nothing is drawn twice.  When wrapping,
+     * lines break after the last whole word that fits (words wider than
+     * the box are split).  Text left over when the box is full, and lines
+     * too wide for the box when not wrapping, end in an ellipsis (U+2026 if
+     * the font has it, else "...").
+     * 
+     * @param x0 - left edge
+     * @param y0 - bottom edge
+     * @param x1 - right edge (exclusive)
+     * @param y1 - top edge (exclusive)
+     * @param pText - UTF-8 text
+     * @param size - size of text in bytes
+     * @param align - placement of each line
+     * @param isWrapped - if true wrap at word breaks, if false one line
+     *                    per '\n'
+     * @return size_t - offset of the first byte that didn't fit in the box,
+     *                  size if all of it did
+     */
+    size_t setTextBox
+    (
+        const size_t x0,
+        const size_t y0,
+        const size_t x1,
+        const size_t y1,
+        const char* pText,
+        const size_t size,
+        const TextAlign align = TextAlign::Left,
+        const bool isWrapped = true
+    );
+
     void clearScreen()
-    { setRect(0, 0, mWidth, mHeight, false); }
+    { setRect(0, 0, mWidth, mHeight, Format::PIXEL_OFF); }
 
     void setRect
     (
@@ -105,22 +287,50 @@ public:
         const size_t y0, 
         const size_t x1, 
         const size_t y1,
-        const bool val
+        const Pixel val
     );
 
 protected:
 
+    /**
+     * @brief Draw characters from the pen position, stopping at the right
+     *        edge of the screen
+     * 
+     * @param x - pen position
+     * @param y - bottom of the line
+     * @param pText - UTF-8 text
+     * @param pEnd - end of text
+     * @return size_t - pen position after the last character
+     */
+    size_t drawRun(size_t x, const size_t y, const char* pText, const char* pEnd);
+
     /// Screen width in pixels
     const size_t mWidth;
     /// Screen height in pixels
     const size_t mHeight;
-    /// Screen height in bytes
-    const size_t mHeightBytes;
-    /// Buffer representing screen RAM
-    std::vector<std::vector<bool>> mBuf;
-    /// Output buffer in format ready to SSD1306
-    std::vector<uint8_t> mOutBuf;
-    /// Font map used to look up character data
-    const std::map<char, std::vector<std::vector<bool>>>* mpFontMap;
-
-}; // End class Framebuffer
\ No newline at end of file
+    /// Buffer representing screen RAM, in Format's layout
+    Buffer<uint8_t> mBuf;
+    /// Font used to look up character data
+    const Font* mpFont = nullptr;
+    /// Value for glyph pixels
+    Pixel mTextFg = Format::PIXEL_ON;
+    /// Value for the rest of each glyph cell
+    Pixel mTextBg = Format::PIXEL_OFF;
+    /// How glyphs are combined with the buffer
+    RasterOp mTextOp = RasterOp::Copy;
+    /// Text magnification
+    size_t mTextScale = 1;
+
+}; // End class BasicFramebuffer
+
+// Supported formats are compiled once in framebuffer.cpp
+extern template class BasicFramebuffer<MonoPageFormat>;
+extern template class BasicFramebuffer<Ssd1322Format>;
+extern template class BasicFramebuffer<Ssd1327Format>;
+
+/// 1 bit per pixel framebuffer for SSD1306, SSD1309 and SH1106
+using Framebuffer = BasicFramebuffer<MonoPageFormat>;
+/// 4 bit per pixel framebuffer for SSD1322
+using Ssd1322Framebuffer = BasicFramebuffer<Ssd1322Format>;
+/// 4 bit per pixel framebuffer for SSD1327
+using Ssd1327Framebuffer = BasicFramebuffer<Ssd1327Format>;
\ No newline at end of file
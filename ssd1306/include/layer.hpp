@@ -0,0 +1,240 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "buffer.hpp"
+
+/**
+ * @brief Layer of packed pixels plus an opacity mask.
+ *
+ * Pixels and mask are stored page-major (one byte per column of each
+ * 8 pixel page, bit 0 at the top of the page) so they can be combined
+ * with the other layers of a LayerStack a word at a time.  Pixels with
+ * a clear mask bit are transparent and show the layers underneath.
+ *
+ * Every change records the columns it touched in each page, so only
+ * those bytes are recomposited and sent on the next flush.
+ *
+ * Pixels, mask and dirty spans live on the heap, or in a Storage.
+ */
+class Layer
+{
+public:
+
+    /**
+     * @brief Memory for a WIDTH x HEIGHT layer
+     */
+    template <size_t WIDTH, size_t HEIGHT>
+    struct Storage;
+
+#ifndef RP_NO_HEAP
+    /**
+     * @brief Construct a new, fully transparent Layer
+     *
+     * @param width - width of the screen in pixels
+     * @param height - height of the screen in pixels
+     */
+    Layer(const size_t width, const size_t height);
+#endif
+
+    /**
+     * @brief Construct a new, fully transparent Layer in the caller's memory
+     *
+     * @param storage - buffers, used for the layer's lifetime
+     */
+    template <size_t WIDTH, size_t HEIGHT>
+    explicit Layer(Storage<WIDTH, HEIGHT>& storage)
+    :   Layer(WIDTH, HEIGHT, storage.pixels, storage.mask, storage.dirty)
+    {
+    }
+
+    /**
+     * @brief Get the pixel value at a given location
+     *
+     * @param x - x coordinate of pixel
+     * @param y - y coordinate of pixel
+     * @return Value of pixel (false if transparent)
+     */
+    bool getPixel(const size_t x, const size_t y) const;
+
+    /**
+     * @brief Check if the pixel at a given location is opaque
+     *
+     * @param x - x coordinate of pixel
+     * @param y - y coordinate of pixel
+     * @return true if opaque, false if transparent or x,y invalid
+     */
+    bool isOpaque(const size_t x, const size_t y) const;
+
+    /**
+     * @brief Set an opaque pixel at a given location
+     *
+     * @param x - x coordinate of pixel
+     * @param y - y coordinate of pixel
+     * @param val - value to set
+     * @return true if x,y valid, false if invalid
+     */
+    bool setPixel(const size_t x, const size_t y, const bool val);
+
+    /**
+     * @brief Make the pixel at a given location transparent
+     *
+     * @param x - x coordinate of pixel
+     * @param y - y coordinate of pixel
+     * @return true if x,y valid, false if invalid
+     */
+    bool clearPixel(const size_t x, const size_t y);
+
+    /**
+     * @brief Fill a rectangle with opaque pixels
+     *
+     * @param x0 - left edge (inclusive)
+     * @param y0 - top edge (inclusive)
+     * @param x1 - right edge (exclusive)
+     * @param y1 - bottom edge (exclusive)
+     * @param val - value to set
+     */
+    void setRect
+    (
+        const size_t x0,
+        const size_t y0,
+        const size_t x1,
+        const size_t y1,
+        const bool val
+    );
+
+    /**
+     * @brief Make a rectangle transparent
+     *
+     * @param x0 - left edge (inclusive)
+     * @param y0 - top edge (inclusive)
+     * @param x1 - right edge (exclusive)
+     * @param y1 - bottom edge (exclusive)
+     */
+    void clearRect
+    (
+        const size_t x0,
+        const size_t y0,
+        const size_t x1,
+        const size_t y1
+    );
+
+    /**
+     * @brief Make the whole layer transparent
+     */
+    void clear()
+    { clearRect(0, 0, mWidth, mHeight); }
+
+    /**
+     * @brief Replace the whole layer with opaque page-major pixel data
+     *
+     * @param pData - pointer to width * height / 8 bytes, page-major
+     * @param size - size of data
+     * @return true if size matches the layer, false otherwise
+     */
+    bool setBuffer(const uint8_t* pData, const size_t size);
+
+    /**
+     * @brief Show/Hide the layer
+     *
+     * @param isVisible - if true layer is composited, if false it is skipped
+     */
+    void setVisible(const bool isVisible);
+
+    /**
+     * @brief Check if the layer is shown
+     *
+     * @return true if visible, false if hidden
+     */
+    bool isVisible() const
+    { return mIsVisible; }
+
+protected:
+
+    friend class LayerStack;
+
+    /// Columns of a page changed since the last flush (empty if x0 > x1)
+    struct DirtySpan
+    {
+        uint16_t x0;
+        uint16_t x1;
+    };
+
+    /**
+     * @brief Construct a new, fully transparent Layer on caller buffers
+     *
+     * @param pPixels - width * height / 8 bytes
+     * @param pMask - width * height / 8 bytes
+     * @param pDirty - height / 8 spans
+     */
+    Layer
+    (
+        const size_t width,
+        const size_t height,
+        uint8_t* pPixels,
+        uint8_t* pMask,
+        DirtySpan* pDirty
+    );
+
+    /**
+     * @brief Apply a pixel/mask update to a run of rows in one page
+     *
+     * @param page - page to update
+     * @param x0 - first column (inclusive)
+     * @param x1 - last column (exclusive)
+     * @param bits - rows of the page being updated
+     * @param opaque - if true make rows opaque, if false transparent
+     * @param val - pixel value for opaque rows
+     */
+    void updatePage
+    (
+        const size_t page,
+        const size_t x0,
+        const size_t x1,
+        const uint8_t bits,
+        const bool opaque,
+        const bool val
+    );
+
+    /**
+     * @brief Record columns of a page as changed
+     *
+     * @param page - page that changed
+     * @param x0 - first column (inclusive)
+     * @param x1 - last column (inclusive)
+     */
+    void markDirty(const size_t page, const size_t x0, const size_t x1);
+
+    /**
+     * @brief Record the whole layer as changed
+     */
+    void markAllDirty();
+
+    /// Screen width in pixels
+    const size_t mWidth;
+    /// Screen height in pixels
+    const size_t mHeight;
+    /// Screen height in pages (bytes)
+    const size_t mPages;
+    /// Pixel values, page-major; always 0 where mask is 0
+    Buffer<uint8_t> mPixels;
+    /// Opacity mask, page-major
+    Buffer<uint8_t> mMask;
+    /// Changed columns of each page
+    Buffer<DirtySpan> mDirty;
+    /// True if the layer is composited
+    bool mIsVisible = true;
+
+}; // End class Layer
+
+template <size_t WIDTH, size_t HEIGHT>
+struct Layer::Storage
+{
+    /// Pixel values, page-major
+    uint8_t pixels[WIDTH * HEIGHT / 8];
+    /// Opacity mask, page-major
+    uint8_t mask[WIDTH * HEIGHT / 8];
+    /// Changed columns of each page
+    DirtySpan dirty[HEIGHT / 8];
+};
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "buffer.hpp"
+#include "layer.hpp"
+#include "ssd1306.hpp"
+
+/**
+ * @brief Stack of Layers composited into SSD1306 RAM at flush time.
+ *
+ * Layers are drawn bottom (first pushed) to top.  On flush only the
+ * columns of each page that changed in any layer are recomposited,
+ * using word-wide AND/OR of the layer masks, and only those bytes are
+ * sent to the display.  Moving an overlay such as a cursor therefore
+ * costs a few bytes instead of redrawing the screen underneath it.
+ *
+ * The layer list has a fixed size, DEFAULT_MAX_LAYERS or the Storage's
+ * MAX_LAYERS.
+ */
+class LayerStack
+{
+public:
+
+    /// Layers a stack built from a size can hold
+    static constexpr size_t DEFAULT_MAX_LAYERS = 8;
+
+    /**
+     * @brief Memory for a WIDTH x HEIGHT stack of up to MAX_LAYERS layers
+     */
+    template <size_t WIDTH, size_t HEIGHT, size_t MAX_LAYERS = DEFAULT_MAX_LAYERS>
+    struct Storage
+    {
+        /// Layers, bottom first
+        Layer* layers[MAX_LAYERS];
+        /// Composited screen, page-major
+        uint8_t out[WIDTH * HEIGHT / 8];
+        /// Columns of each page waiting to be recomposited and sent
+        Layer::DirtySpan dirty[HEIGHT / 8];
+    };
+
+#ifndef RP_NO_HEAP
+    /**
+     * @brief Construct a new, empty LayerStack
+     *
+     * @param width - width of the screen in pixels
+     * @param height - height of the screen in pixels
+     * @param maxLayers - most layers the stack can hold
+     */
+    LayerStack(const size_t width, const size_t height, const size_t maxLayers = DEFAULT_MAX_LAYERS);
+#endif
+
+    /**
+     * @brief Construct a new, empty LayerStack in the caller's memory
+     *
+     * @param storage - buffers, used for the stack's lifetime
+     */
+    template <size_t WIDTH, size_t HEIGHT, size_t MAX_LAYERS>
+    explicit LayerStack(Storage<WIDTH, HEIGHT, MAX_LAYERS>& storage)
+    :   LayerStack(WIDTH, HEIGHT, storage.layers, MAX_LAYERS, storage.out, storage.dirty)
+    {
+    }
+
+    /**
+     * @brief Add a layer on top of the stack
+     *
+     * @param pLayer - pointer to layer, must outlive the stack
+     * @return true if added, false if null, wrong size, already present
+     *         or the stack is full
+     */
+    bool push(Layer* pLayer);
+
+    /**
+     * @brief Remove a layer from the stack
+     *
+     * @param pLayer - pointer to layer
+     * @return true if removed, false if not in the stack
+     */
+    bool remove(Layer* pLayer);
+
+    /**
+     * @brief Force the whole screen to be recomposited on the next flush
+     */
+    void invalidate();
+
+    /**
+     * @brief Composite changed pages and send them to the display
+     *
+     * @param display - display to write to
+     * @return size_t - number of pixel bytes sent
+     */
+    size_t flush(SSD1306& display);
+
+    /**
+     * @brief Composite changed pages without sending them
+     *
+     * @return uint8_t* - pointer to composited page-major screen buffer
+     */
+    const uint8_t* getBuffer();
+
+    /**
+     * @brief Get the size of screen buffer, in bytes
+     *
+     * @return size_t number of bytes
+     */
+    size_t getBufSize() const
+    { return mOut.size(); }
+
+protected:
+
+    /**
+     * @brief Construct a new, empty LayerStack on caller buffers
+     *
+     * @param ppLayers - maxLayers layer pointers
+     * @param maxLayers - most layers the stack can hold
+     * @param pOut - width * height / 8 bytes
+     * @param pDirty - height / 8 spans
+     */
+    LayerStack
+    (
+        const size_t width,
+        const size_t height,
+        Layer** ppLayers,
+        const size_t maxLayers,
+        uint8_t* pOut,
+        Layer::DirtySpan* pDirty
+    );
+
+    /**
+     * @brief Gather the changed columns of every page from all layers
+     */
+    void collectDirty();
+
+    /**
+     * @brief Recomposite columns of one page from all visible layers
+     *
+     * @param page - page to composite
+     * @param x0 - first column (inclusive)
+     * @param x1 - last column (inclusive)
+     */
+    void composite(const size_t page, const size_t x0, const size_t x1);
+
+    /// Screen width in pixels
+    const size_t mWidth;
+    /// Screen height in pixels
+    const size_t mHeight;
+    /// Screen height in pages (bytes)
+    const size_t mPages;
+    /// Layers, bottom first; the first mLayerCount are in use
+    Buffer<Layer*> mLayers;
+    /// Number of layers in the stack
+    size_t mLayerCount = 0;
+    /// Composited screen, page-major
+    Buffer<uint8_t> mOut;
+    /// Columns of each page waiting to be recomposited and sent
+    Buffer<Layer::DirtySpan> mDirty;
+
+}; // End class LayerStack
\ No newline at end of file
@@ -0,0 +1,164 @@
+/**
+ * @file packedFont.hpp
+ * @brief Bitmap fonts as packed tables in flash.
+ *
+ * Fonts are generated from BDF files at build time by
+ * ssd1306/tools/bdf2font.py (see ssd1306_add_font in the ssd1306
+ * CMakeLists.txt), so they are plain const data and need no RAM or
+ * start-up code.
+ *
+ * Code points are mapped to glyphs by a table of ranges (runs of
+ * consecutive code points with consecutive glyphs), searched by bisection,
+ * so a font with scattered scripts (Latin, Latin Extended, katakana) costs
+ * a few bytes per run rather than per code point, and a lookup is
+ * O(log ranges).  Printable ASCII is normally the first range and is
+ * found without searching.
+ *
+ * Glyph bitmaps are column-major: each column is (height + 7) / 8 bytes,
+ * bit 0 of the first byte is the glyph's bottom row.  That is the order
+ * Framebuffer draws a column in, so a column is drawn without reshuffling.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "utf8.hpp"
+
+/**
+ * @brief Metrics and bitmap location of one glyph
+ */
+struct Glyph
+{
+    /// Offset of the first column in Font::pBitmap
+    uint32_t offset;
+    /// Bitmap width (columns)
+    uint8_t width;
+    /// Bitmap height (rows, up to 32)
+    uint8_t height;
+    /// Columns from the pen position to the bitmap's first column
+    int8_t xOffset;
+    /// Rows from the bottom of the line to the bitmap's bottom row
+    int8_t yOffset;
+    /// Columns to move the pen by after the glyph
+    uint8_t advance;
+};
+
+/**
+ * @brief Run of consecutive code points with consecutive glyphs
+ */
+struct GlyphRange
+{
+    /// First code point
+    uint32_t first;
+    /// Number of code points
+    uint16_t count;
+    /// Index of the first code point's glyph
+    uint16_t glyph;
+};
+
+/**
+ * @brief A generated font
+ */
+struct Font
+{
+    /// Name given to the generator
+    const char* pName;
+    /// Glyphs, in code point order
+    const Glyph* pGlyphs;
+    /// Number of glyphs
+    uint16_t glyphCount;
+    /// Code point ranges, sorted
+    const GlyphRange* pRanges;
+    /// Number of ranges
+    uint16_t rangeCount;
+    /// Glyph drawn for code points the font doesn't have
+    uint16_t fallback;
+    /// Column data of every glyph
+    const uint8_t* pBitmap;
+    /// Rows from one line to the next (ascent + descent)
+    uint8_t lineHeight;
+    /// Rows from the baseline to the top of the line
+    uint8_t ascent;
+
+    /**
+     * @brief Look up a glyph
+     *
+     * @param codepoint - Unicode code point
+     * @return const Glyph* - glyph, nullptr if the font doesn't have it
+     */
+    const Glyph* findGlyph(const uint32_t codepoint) const
+    {
+        // Common case, no search
+        if(codepoint - pRanges[0].first < pRanges[0].count)
+        {
+            return &pGlyphs[pRanges[0].glyph + codepoint - pRanges[0].first];
+        }
+
+        // Last range starting at or before codepoint
+        size_t first = 1;
+        size_t last = rangeCount;
+
+        while(first < last)
+        {
+            const size_t mid = (first + last) / 2;
+
+            if(pRanges[mid].first <= codepoint)
+            {
+                first = mid + 1;
+            }
+            else
+            {
+                last = mid;
+            }
+        }
+
+        const GlyphRange& range = pRanges[first - 1];
+        const uint32_t index = codepoint - range.first;
+
+        return (index < range.count) ? &pGlyphs[range.glyph + index] : nullptr;
+    }
+
+    /**
+     * @brief Look up a glyph, or the fallback glyph if the font doesn't
+     *        have it
+     *
+     * @param codepoint - Unicode code point
+     * @return const Glyph& - glyph
+     */
+    const Glyph& getGlyph(const uint32_t codepoint) const
+    {
+        const Glyph* pGlyph = findGlyph(codepoint);
+
+        return (pGlyph != nullptr) ? *pGlyph : pGlyphs[fallback];
+    }
+
+    /**
+     * @brief Get the width of a line of text (sum of the advances)
+     *
+     * @param pText - UTF-8 text
+     * @param size - size of text in bytes
+     * @return size_t - width in pixels
+     */
+    size_t getTextWidth(const char* pText, const size_t size) const
+    {
+        const char* pEnd = pText + size;
+        size_t width = 0;
+
+        while(pText < pEnd)
+        {
+            width += getGlyph(utf8::decode(pText, pEnd)).advance;
+        }
+
+        return width;
+    }
+
+    /**
+     * @brief Get a glyph's column data
+     *
+     * @param glyph - glyph of this font
+     * @return const uint8_t* - first byte of the first column
+     */
+    const uint8_t* getBitmap(const Glyph& glyph) const
+    { return &pBitmap[glyph.offset]; }
+};
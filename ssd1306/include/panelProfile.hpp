@@ -0,0 +1,133 @@
+/**
+ * @file panelProfile.hpp
+ * @brief Controller/panel descriptions for the SSD1306 driver.
+ *
+ * Each profile carries its whole init sequence as a constexpr command
+ * table, so it stays in flash and is sent to the controller in a single
+ * burst.  All profiles leave the panel in the same orientation, so a
+ * Framebuffer looks the same on any of them.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Description of a controller and panel combination
+ */
+struct PanelProfile
+{
+    /// Init command sequence (display off ... display on)
+    const uint8_t* pInitCmds;
+    /// Size of init command sequence
+    size_t initCmdsSize;
+    /// Visible width in pixels
+    uint16_t width;
+    /// Visible height in pixels
+    uint16_t height;
+    /// RAM column of the first visible pixel
+    uint8_t colOffset;
+    /// True if the controller only supports page addressing (SH1106)
+    bool isPageAddressing;
+    /// Contrast set by the init sequence
+    uint8_t contrast;
+};
+
+namespace panels
+{
+
+/// SSD1306, 128x64, internal charge pump
+inline constexpr uint8_t SSD1306_128X64_INIT[] =
+{
+    0xAE,           // Display off
+    0x20, 0x00,     // Horizontal addressing
+    0x40,           // Start line 0
+    0xA1,           // Reverse segment remap
+    0xA8, 63,       // Mux ratio - 64 lines
+    0xC0,           // Normal COM dir
+    0xD3, 0x00,     // No display offset
+    0xDA, 0x12,     // Alternative COM pins, no remap
+    0xD5, 0x80,     // Oscillator freq 0x8, divide ratio 0
+    0xD9, 0xF1,     // Pre-charge 0x1 phase 1, 0xF phase 2
+    0xDB, 0x30,     // VCOM deselect 0.83 x Vcc
+    0x81, 0xFF,     // Contrast
+    0xA4,           // Display RAM
+    0xA6,           // Normal (no invert)
+    0x8D, 0x14,     // Enable charge pump
+    0xAF            // Display on
+};
+
+/// SSD1306, 128x32, internal charge pump
+inline constexpr uint8_t SSD1306_128X32_INIT[] =
+{
+    0xAE,           // Display off
+    0x20, 0x00,     // Horizontal addressing
+    0x40,           // Start line 0
+    0xA1,           // Reverse segment remap
+    0xA8, 31,       // Mux ratio - 32 lines
+    0xC0,           // Normal COM dir
+    0xD3, 0x00,     // No display offset
+    0xDA, 0x02,     // Sequential COM pins, no remap
+    0xD5, 0x80,     // Oscillator freq 0x8, divide ratio 0
+    0xD9, 0xF1,     // Pre-charge 0x1 phase 1, 0xF phase 2
+    0xDB, 0x30,     // VCOM deselect 0.83 x Vcc
+    0x81, 0x8F,     // Contrast
+    0xA4,           // Display RAM
+    0xA6,           // Normal (no invert)
+    0x8D, 0x14,     // Enable charge pump
+    0xAF            // Display on
+};
+
+/// SSD1309, 128x64, external Vcc (no charge pump)
+inline constexpr uint8_t SSD1309_128X64_INIT[] =
+{
+    0xAE,           // Display off
+    0x20, 0x00,     // Horizontal addressing
+    0x40,           // Start line 0
+    0xA1,           // Reverse segment remap
+    0xA8, 63,       // Mux ratio - 64 lines
+    0xC0,           // Normal COM dir
+    0xD3, 0x00,     // No display offset
+    0xDA, 0x12,     // Alternative COM pins, no remap
+    0xD5, 0xA0,     // Oscillator freq 0xA, divide ratio 0
+    0xD9, 0xF1,     // Pre-charge 0x1 phase 1, 0xF phase 2
+    0xDB, 0x3C,     // VCOM deselect 0.84 x Vcc
+    0x81, 0xFF,     // Contrast
+    0xA4,           // Display RAM
+    0xA6,           // Normal (no invert)
+    0xAF            // Display on
+};
+
+/// SH1106, 128x64 visible of 132 column RAM, page addressing only
+inline constexpr uint8_t SH1106_128X64_INIT[] =
+{
+    0xAE,           // Display off
+    0x40,           // Start line 0
+    0xA1,           // Reverse segment remap
+    0xA8, 63,       // Mux ratio - 64 lines
+    0xC0,           // Normal COM dir
+    0xD3, 0x00,     // No display offset
+    0xDA, 0x12,     // Alternative COM pins
+    0xD5, 0x80,     // Oscillator freq 0x8, divide ratio 0
+    0xD9, 0x22,     // Pre-charge 0x2 phase 1, 0x2 phase 2
+    0xDB, 0x35,     // VCOM deselect 0.77 x Vcc
+    0x81, 0xFF,     // Contrast
+    0xA4,           // Display RAM
+    0xA6,           // Normal (no invert)
+    0xAD, 0x8B,     // Enable DC-DC converter
+    0xAF            // Display on
+};
+
+inline constexpr PanelProfile SSD1306_128X64 =
+{ SSD1306_128X64_INIT, sizeof(SSD1306_128X64_INIT), 128, 64, 0, false, 0xFF };
+
+inline constexpr PanelProfile SSD1306_128X32 =
+{ SSD1306_128X32_INIT, sizeof(SSD1306_128X32_INIT), 128, 32, 0, false, 0x8F };
+
+inline constexpr PanelProfile SSD1309_128X64 =
+{ SSD1309_128X64_INIT, sizeof(SSD1309_128X64_INIT), 128, 64, 0, false, 0xFF };
+
+inline constexpr PanelProfile SH1106_128X64 =
+{ SH1106_128X64_INIT, sizeof(SH1106_128X64_INIT), 128, 64, 2, true, 0xFF };
+
+} // End namespace panels
\ No newline at end of file
@@ -0,0 +1,41 @@
+/**
+ * @file pbm.hpp
+ * @brief Minimal Netpbm bitmap (PBM) parser.
+ *
+ * Works on a buffer already in memory (flash or RAM) and never copies or
+ * allocates, so the same code runs on the host and on the device.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Bitmap described by a PBM header
+ */
+struct PbmImage
+{
+    /// Width in pixels
+    size_t width;
+    /// Height in pixels
+    size_t height;
+    /// True for plain (P1, ASCII '0'/'1') data, false for raw (P4) bits
+    bool isPlain;
+    /// Pointer to pixel data within the parsed buffer
+    const uint8_t* pPixels;
+    /// Size of pixel data in bytes
+    size_t size;
+};
+
+/**
+ * @brief Parse a PBM (P1 or P4) header
+ *
+ * P4 pixel data is row-major, MSB first, rows padded to whole bytes, and
+ * can be passed straight to Framebuffer::setBuffer().
+ *
+ * @param pData - pointer to PBM file contents
+ * @param size - size of PBM file contents
+ * @param image - filled in with image dimensions and pixel data location
+ * @return true if header valid and pixel data complete, false otherwise
+ */
+bool parsePbm(const uint8_t* pData, const size_t size, PbmImage& image);
\ No newline at end of file
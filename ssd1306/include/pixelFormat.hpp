@@ -0,0 +1,309 @@
+/**
+ * @file pixelFormat.hpp
+ * @brief Pixel formats for BasicFramebuffer.
+ *
+ * A format describes how pixels are packed into the buffer sent to the
+ * controller and provides the primitive operations the framebuffer is
+ * built from.  Each framebuffer is compiled for one format, so every
+ * fill, blit and glyph column goes straight to that format's packing.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/**
+ * @brief How glyph pixels change the pixels they are drawn over
+ */
+enum class RasterOp
+{
+    /// Set pixels become fg, clear pixels bg (opaque cell)
+    Copy,
+    /// Set pixels become fg, clear pixels are left alone
+    Or,
+    /// Set pixels become bg, clear pixels are left alone (erase)
+    AndNot,
+    /// Set pixels are inverted, clear pixels are left alone
+    Xor
+};
+
+/**
+ * @brief 1 bit per pixel, page-major (SSD1306, SSD1309, SH1106)
+ *
+ * Page by page, one byte per column of each 8 pixel page, bit 0 on top.
+ */
+struct MonoPageFormat
+{
+    /// Pixel value type
+    using Pixel = bool;
+
+    /// Brightest pixel value
+    static constexpr Pixel PIXEL_ON = true;
+    /// Darkest pixel value
+    static constexpr Pixel PIXEL_OFF = false;
+
+    /**
+     * @brief Get buffer size for a screen, in bytes
+     */
+    static constexpr size_t bufSize(const size_t width, const size_t height)
+    { return width * (height / 8); }
+
+    /**
+     * @brief Get pixel value (x,y must be valid)
+     */
+    static Pixel get(const uint8_t* pBuf, const size_t width, const size_t x, const size_t y)
+    { return pBuf[(y / 8) * width + x] & (1 << (y % 8)); }
+
+    /**
+     * @brief Set pixel value (x,y must be valid)
+     */
+    static void set(uint8_t* pBuf, const size_t width, const size_t x, const size_t y, const Pixel val)
+    {
+        uint8_t& b = pBuf[(y / 8) * width + x];
+        b = (val) ? (b | (1 << (y % 8))) : (b & ~(1 << (y % 8)));
+    }
+
+    /**
+     * @brief Fill a rectangle (already clipped to the screen)
+     *
+     * Works a page at a time so each column byte is touched once.
+     */
+    static void fillRect
+    (
+        uint8_t* pBuf,
+        const size_t width,
+        const size_t x0,
+        const size_t y0,
+        const size_t x1,
+        const size_t y1,
+        const Pixel val
+    )
+    {
+        for(size_t y = y0; y < y1; y = (y / 8 + 1) * 8)
+        {
+            const size_t pageEnd = (y / 8 + 1) * 8;
+            const size_t rows = ((y1 < pageEnd) ? y1 : pageEnd) - y;
+            const uint8_t bits = ((1 << rows) - 1) << (y % 8);
+
+            uint8_t* pPage = &pBuf[(y / 8) * width];
+
+            for(size_t x = x0; x < x1; x++)
+            {
+                pPage[x] = (val) ? (pPage[x] | bits) : (pPage[x] & ~bits);
+            }
+        }
+    }
+
+    /**
+     * @brief Draw one column of a glyph (x valid, rows clipped to height)
+     *
+     * Works a page at a time, so each column byte is read and written once
+     * whatever the glyph's height.
+     *
+     * @param pBits - column pixels, bit 0 of the first byte first
+     * @param first - first bit to draw, drawn at y
+     * @param rows - number of bits in the column
+     * @param fg - value for set bits
+     * @param bg - value for clear bits
+     * @param op - how the bits change the buffer
+     */
+    static void drawColumn
+    (
+        uint8_t* pBuf,
+        const size_t width,
+        const size_t height,
+        const size_t x,
+        const size_t y,
+        const uint8_t* pBits,
+        const size_t first,
+        const size_t rows,
+        const Pixel fg,
+        const Pixel bg,
+        const RasterOp op
+    )
+    {
+        if(first >= rows)
+        {
+            return;
+        }
+
+        const size_t yEnd = (y + rows - first < height) ? y + rows - first : height;
+
+        for(size_t yPos = y; yPos < yEnd; yPos = (yPos / 8 + 1) * 8)
+        {
+            const size_t pageEnd = (yPos / 8 + 1) * 8;
+            const size_t count = ((yEnd < pageEnd) ? yEnd : pageEnd) - yPos;
+            const uint8_t mask = ((1 << count) - 1) << (yPos % 8);
+
+            // The page's bits can straddle two column bytes
+            const size_t bit = first + (yPos - y);
+            uint32_t window = pBits[bit / 8];
+            if(bit % 8 + count > 8)
+            {
+                window |= pBits[bit / 8 + 1] << 8;
+            }
+            const uint8_t set = ((window >> (bit % 8)) << (yPos % 8)) & mask;
+
+            uint8_t& b = pBuf[(yPos / 8) * width + x];
+
+            switch(op)
+            {
+                case RasterOp::Copy:
+                    b = (b & ~mask) | ((fg) ? set : 0) | ((bg) ? (mask & ~set) : 0);
+                    break;
+                case RasterOp::Or:
+                    b = (fg) ? (b | set) : (b & ~set);
+                    break;
+                case RasterOp::AndNot:
+                    b = (bg) ? (b | set) : (b & ~set);
+                    break;
+                case RasterOp::Xor:
+                    b ^= set;
+                    break;
+            }
+        }
+    }
+};
+
+/**
+ * @brief 4 bits per pixel grayscale, row-major, two pixels per byte
+ *
+ * @tparam isHighNibbleFirst - true if the left pixel of each byte is in
+ *                             the high nibble (SSD1322), false if in the
+ *                             low nibble (SSD1327)
+ */
+template <bool isHighNibbleFirst>
+struct Gray4Format
+{
+    /// Pixel value type, 0 - 15
+    using Pixel = uint8_t;
+
+    /// Brightest pixel value
+    static constexpr Pixel PIXEL_ON = 0xF;
+    /// Darkest pixel value
+    static constexpr Pixel PIXEL_OFF = 0;
+
+    /**
+     * @brief Get buffer size for a screen, in bytes
+     */
+    static constexpr size_t bufSize(const size_t width, const size_t height)
+    { return (width + 1) / 2 * height; }
+
+    /**
+     * @brief Get pixel value (x,y must be valid)
+     */
+    static Pixel get(const uint8_t* pBuf, const size_t width, const size_t x, const size_t y)
+    {
+        const uint8_t b = pBuf[y * ((width + 1) / 2) + x / 2];
+        return (((x & 1) == 0) == isHighNibbleFirst) ? (b >> 4) : (b & 0xF);
+    }
+
+    /**
+     * @brief Set pixel value (x,y must be valid)
+     */
+    static void set(uint8_t* pBuf, const size_t width, const size_t x, const size_t y, const Pixel val)
+    {
+        uint8_t& b = pBuf[y * ((width + 1) / 2) + x / 2];
+
+        if(((x & 1) == 0) == isHighNibbleFirst)
+        {
+            b = (b & 0x0F) | (val << 4);
+        }
+        else
+        {
+            b = (b & 0xF0) | (val & 0xF);
+        }
+    }
+
+    /**
+     * @brief Fill a rectangle (already clipped to the screen)
+     *
+     * Whole bytes in the middle of each row are filled with memset.
+     */
+    static void fillRect
+    (
+        uint8_t* pBuf,
+        const size_t width,
+        const size_t x0,
+        const size_t y0,
+        const size_t x1,
+        const size_t y1,
+        const Pixel val
+    )
+    {
+        if(x0 >= x1)
+        {
+            return;
+        }
+
+        const size_t stride = (width + 1) / 2;
+        const uint8_t fill = (val << 4) | (val & 0xF);
+
+        // Odd pixels at either end share a byte with pixels outside
+        const size_t first = (x0 + 1) & ~size_t(1);
+        const size_t last = x1 & ~size_t(1);
+
+        for(size_t y = y0; y < y1; y++)
+        {
+            if(x0 != first)
+            {
+                set(pBuf, width, x0, y, val);
+            }
+
+            memset(&pBuf[y * stride + first / 2], fill, (last - first) / 2);
+
+            if(x1 != last)
+            {
+                set(pBuf, width, last, y, val);
+            }
+        }
+    }
+
+    /**
+     * @brief Draw one column of a glyph (x valid, rows clipped to height)
+     *
+     * @param pBits - column pixels, bit 0 of the first byte first
+     * @param first - first bit to draw, drawn at y
+     * @param rows - number of bits in the column
+     * @param fg - value for set bits
+     * @param bg - value for clear bits
+     * @param op - how the bits change the buffer
+     */
+    static void drawColumn
+    (
+        uint8_t* pBuf,
+        const size_t width,
+        const size_t height,
+        const size_t x,
+        const size_t y,
+        const uint8_t* pBits,
+        const size_t first,
+        const size_t rows,
+        const Pixel fg,
+        const Pixel bg,
+        const RasterOp op
+    )
+    {
+        for(size_t bit = first, yPos = y; bit < rows && yPos < height; bit++, yPos++)
+        {
+            const bool isSet = (pBits[bit / 8] >> (bit % 8)) & 1;
+
+            if(op == RasterOp::Copy)
+            {
+                set(pBuf, width, x, yPos, (isSet) ? fg : bg);
+            }
+            else if(isSet)
+            {
+                set(pBuf, width, x, yPos, (op == RasterOp::Or) ? fg :
+                                          (op == RasterOp::AndNot) ? bg :
+                                          get(pBuf, width, x, yPos) ^ PIXEL_ON);
+            }
+        }
+    }
+};
+
+/// SSD1322 256x64 grayscale: left pixel in the high nibble
+using Ssd1322Format = Gray4Format<true>;
+/// SSD1327 128x128 grayscale: left pixel in the low nibble
+using Ssd1327Format = Gray4Format<false>;
\ No newline at end of file
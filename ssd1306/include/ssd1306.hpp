@@ -1,13 +1,29 @@
 #pragma once
 
-#include <functional>
 #include <cstdint>
 
+#include "callback.hpp"
+#include "panelProfile.hpp"
+
+class FrameMirror;
+
 /**
  * @brief SSD1306 OLED Display Driver
  *        
  * The constructor takes function objects to abstract the underlying
- * hardware calls.
+ * hardware calls (plain function pointers when built with RP_NO_HEAP, see
+ * callback.hpp).
+ * 
+ * Compatible controllers (SSD1309, SH1106) and panel sizes are selected
+ * with a PanelProfile; screen data is always page-major, one byte per
+ * column of each 8 pixel page.
+ * 
+ * Contrast, inversion, display on/off, start line and display offset are
+ * kept in a shadow copy, so setting them to their current value sends
+ * nothing and the getters never touch the bus.
+ * 
+ * Screen data written through writeData and writePage can be copied to a
+ * FrameMirror, which streams it to a host.
  * 
  */
 class SSD1306
@@ -32,20 +48,43 @@ public:
      *                      delayMs - Milliseconds to delay 
      * @param dcPin - Data/Command pin number
      * @param resetPin - Reset pin number
-     * @param width - Screen width
-     * @param height - Screen height
+     * @param width - Screen width, 128
+     * @param height - Screen height, 64 or 32; any other size asserts in
+     *                 debug builds and falls back to 128x64 otherwise (see
+     *                 isProfileMatched), so other panels need the PanelProfile
+     *                 constructor
      */
     SSD1306
     (
-        std::function<void(const uint8_t* pData, const size_t size)> writeFunc,
-        std::function<void(const uint8_t pin, const bool isOn)> setPinFunc,
-        std::function<void(const uint32_t delayMs)> delayMsFunc,
+        Callback<void(const uint8_t* pData, const size_t size)> writeFunc,
+        Callback<void(const uint8_t pin, const bool isOn)> setPinFunc,
+        Callback<void(const uint32_t delayMs)> delayMsFunc,
         const uint8_t dcPin,
         const uint8_t resetPin,
         const size_t width, 
         const size_t height
     );
 
+    /**
+     * @brief Construct a new SSD1306 object for a specific controller/panel
+     * 
+     * @param writeFunc - Function to send data to SSD1306
+     * @param setPinFunc - Function to set pin high/low
+     * @param delayMsFunc - Function to delay number of milliseconds
+     * @param dcPin - Data/Command pin number
+     * @param resetPin - Reset pin number
+     * @param profile - Controller/panel profile, e.g. panels::SH1106_128X64
+     */
+    SSD1306
+    (
+        Callback<void(const uint8_t* pData, const size_t size)> writeFunc,
+        Callback<void(const uint8_t pin, const bool isOn)> setPinFunc,
+        Callback<void(const uint32_t delayMs)> delayMsFunc,
+        const uint8_t dcPin,
+        const uint8_t resetPin,
+        const PanelProfile& profile
+    );
+
     /**
      * @brief Turn display On/Off
      * 
@@ -53,8 +92,30 @@ public:
      */
     void setDisplayOn(const bool isOn);
 
+    /**
+     * @brief Check if display is on
+     * 
+     * @return true if on, false if off
+     */
+    bool isDisplayOn() const
+    { return mIsDisplayOn; }
+
+    /**
+     * @brief Check if the profile in use matches the size passed in
+     * 
+     * Only false if the width/height constructor got a size with no
+     * profile and fell back to 128x64.
+     * 
+     * @return true if matched, false if fallen back
+     */
+    bool isProfileMatched() const
+    { return mIsProfileMatched; }
+
     /**
      * @brief Reset SSD1306 to defaults
+     * 
+     * Invalidates the shadow copy of the configuration, so the next call to
+     * each setter is always sent.
      */
     void reset();
 
@@ -82,6 +143,14 @@ public:
      */
     bool setStartLine(const uint8_t line);
 
+    /**
+     * @brief Get the starting row in RAM
+     * 
+     * @return uint8_t - RAM start line
+     */
+    uint8_t getStartLine() const
+    { return mStartLine; }
+
     /**
      * @brief Set segment remap
      * 
@@ -114,6 +183,14 @@ public:
      */
     bool setDisplayOffset(const uint8_t offset);
 
+    /**
+     * @brief Get the Display Offset (vertical shift)
+     * 
+     * @return uint8_t - shift offset
+     */
+    uint8_t getDisplayOffset() const
+    { return mDisplayOffset; }
+
     /**
      * @brief Set the COM pin HW config
      * 
@@ -158,6 +235,14 @@ public:
      */
     void setContrast(const uint8_t level);
 
+    /**
+     * @brief Get contrast level
+     * 
+     * @return uint8_t - contrast level
+     */
+    uint8_t getContrast() const
+    { return mContrast; }
+
     /**
      * @brief Set screen inversion
      * 
@@ -167,6 +252,23 @@ public:
      */
     void setInvert(const bool isInverted);
 
+    /**
+     * @brief Check if screen is inverted
+     * 
+     * @return true if inverted, false if normal
+     */
+    bool isInverted() const
+    { return mIsInverted; }
+
+    /**
+     * @brief Forget the shadow copy of the configuration
+     * 
+     * Use if something else may have changed the controller's state; the
+     * next call to each cached setter is always sent.
+     */
+    void invalidateCache()
+    { mCacheValid = 0; }
+
     /**
      * @brief Enable/Disable charge pump
      * 
@@ -178,10 +280,86 @@ public:
     /**
      * @brief Write screen data to SSD1306 RAM
      * 
-     * @param pData - pointer to data
+     * @param pData - pointer to page-major data
      * @param size - size of data
      */
     void writeData(const uint8_t* pData, const size_t size);
+
+    /**
+     * @brief Set the column window used by horizontal/vertical addressing
+     * 
+     * @param start - first column (0 - width-1)
+     * @param end - last column (start - width-1)
+     * @return true if columns valid, false if invalid or the profile uses page
+     *         addressing (SH1106 has no window)
+     */
+    bool setColumnAddr(const uint8_t start, const uint8_t end);
+
+    /**
+     * @brief Set the page window used by horizontal/vertical addressing
+     * 
+     * @param start - first page (0 - height/8-1)
+     * @param end - last page (start - height/8-1)
+     * @return true if pages valid, false if invalid or the profile uses page
+     *         addressing (SH1106 has no window)
+     */
+    bool setPageAddr(const uint8_t start, const uint8_t end);
+
+    /**
+     * @brief Write a run of columns within a single page of SSD1306 RAM
+     * 
+     * Only the addressed bytes are sent, so small changes (a cursor, an
+     * icon) cost a few bytes instead of a full frame.  The next call to
+     * writeData() restores the full screen window.
+     * 
+     * @param page - page (row of 8 pixels) to write
+     * @param col - first column to write
+     * @param pData - pointer to one byte per column
+     * @param size - number of columns
+     * @return true if the run fits on screen, false otherwise
+     */
+    bool writePage
+    (
+        const uint8_t page, 
+        const uint8_t col, 
+        const uint8_t* pData, 
+        const size_t size
+    );
+
+    /**
+     * @brief Write whole pages of SSD1306 RAM
+     * 
+     * The RAM window is set to the pages and all of them go out in one
+     * data transfer (page addressing controllers address each page).
+     * The next call to writeData() restores the full screen window.
+     * 
+     * @param firstPage - first page (row of 8 pixels) to write
+     * @param pData - pointer to page-major data for those pages
+     * @param pageCount - number of pages
+     * @return true if the pages are on screen, false otherwise
+     */
+    bool writePages(const uint8_t firstPage, const uint8_t* pData, const size_t pageCount);
+
+    /**
+     * @brief Get screen width, pixels
+     */
+    size_t getWidth() const
+    { return mWidth; }
+
+    /**
+     * @brief Get screen height, pixels
+     */
+    size_t getHeight() const
+    { return mHeight; }
+
+    /**
+     * @brief Copy screen data to a FrameMirror as it is written
+     * 
+     * @param pMirror - mirror, or nullptr to stop mirroring
+     */
+    void setMirror(FrameMirror* pMirror)
+    { mpMirror = pMirror; }
+
 protected:
 
     /**
@@ -190,18 +368,54 @@ protected:
     void init();
 
     /**
-     * @brief 
+     * @brief Write a single command byte
      * 
-     * @param cmd 
+     * @param cmd - command byte
      */
     void writeCmd(const uint8_t cmd);
 
+    /**
+     * @brief Write a sequence of command bytes in one transfer
+     * 
+     * @param pCmds - pointer to command bytes
+     * @param size - number of command bytes
+     */
+    void writeCmds(const uint8_t* pCmds, const size_t size);
+
+    /**
+     * @brief Address and send a run of columns within a single page
+     * 
+     * writePage without the checks or the mirror.
+     */
+    void sendPage
+    (
+        const uint8_t page, 
+        const uint8_t col, 
+        const uint8_t* pData, 
+        const size_t size
+    );
+
+    /**
+     * @brief Pick the SSD1306 profile matching a panel size
+     * 
+     * Width and height must match a profile exactly; anything else fails
+     * an assert, or with NDEBUG gets the 128x64 profile.
+     * 
+     * @param width - Screen width
+     * @param height - Screen height
+     * @return Profile for a 128x32 or 128x64 panel
+     */
+    static const PanelProfile& selectProfile(const size_t width, const size_t height);
+
+    /// Controller/panel profile
+    const PanelProfile mProfile;
+
     /// Function object for writing to SSD1306
-    std::function<void(const uint8_t*, const size_t)> mWrite;
+    Callback<void(const uint8_t*, const size_t)> mWrite;
     /// Function object for setting a pin high/low
-    std::function<void(const uint8_t pin, const bool)> mSetPin;
+    Callback<void(const uint8_t pin, const bool)> mSetPin;
     /// Function object for delaying a number of milliseconds
-    std::function<void(const uint32_t)> mDelayMs;
+    Callback<void(const uint32_t)> mDelayMs;
 
     /// Pin number of DC pin (Data/Command)
     const uint8_t mDcPin;
@@ -213,4 +427,46 @@ protected:
     /// Screen height, pixels
     const size_t mHeight;
 
+    /// True if the RAM window no longer covers the whole screen
+    bool mIsWindowed = false;
+
+    /// False if the width/height constructor fell back to 128x64
+    bool mIsProfileMatched = true;
+
+    /// Mirror of screen data, if any
+    FrameMirror* mpMirror = nullptr;
+
+    /// Shadow copy entries (bits of mCacheValid)
+    enum CacheEntry : uint8_t
+    {
+        CACHE_CONTRAST = 0b1,
+        CACHE_INVERT = 0b10,
+        CACHE_DISPLAY_ON = 0b100,
+        CACHE_START_LINE = 0b1000,
+        CACHE_DISPLAY_OFFSET = 0b1'0000,
+        CACHE_ALL = 0b1'1111
+    };
+
+    /**
+     * @brief Check if a shadow copy entry matches the controller
+     * 
+     * @param entry - shadow copy entry
+     * @return true if valid, false if it must be sent
+     */
+    bool isCached(const CacheEntry entry) const
+    { return mCacheValid & entry; }
+
+    /// Shadow copy entries that match the controller
+    uint8_t mCacheValid = 0;
+    /// Shadow copy of contrast level
+    uint8_t mContrast = 0x7F;
+    /// Shadow copy of screen inversion
+    bool mIsInverted = false;
+    /// Shadow copy of display on/off
+    bool mIsDisplayOn = false;
+    /// Shadow copy of RAM start line
+    uint8_t mStartLine = 0;
+    /// Shadow copy of display offset
+    uint8_t mDisplayOffset = 0;
+
 }; // End class SSD1306
\ No newline at end of file
@@ -0,0 +1,90 @@
+/**
+ * @file utf8.hpp
+ * @brief UTF-8 decoding for text drawing.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace utf8
+{
+
+/// Code point returned for bytes that aren't valid UTF-8
+constexpr uint32_t REPLACEMENT = 0xFFFD;
+
+/**
+ * @brief Decode one code point and step past it
+ *
+ * Overlong forms, surrogates, values above U+10FFFF and truncated
+ * sequences decode as REPLACEMENT, consuming one byte, so decoding always
+ * makes progress and never reads past pEnd.
+ *
+ * @param pText - current position (pText < pEnd), advanced past the code point
+ * @param pEnd - end of text
+ * @return uint32_t - code point
+ */
+inline uint32_t decode(const char*& pText, const char* pEnd)
+{
+    const uint8_t lead = static_cast<uint8_t>(*pText++);
+
+    if(lead < 0x80)
+    {
+        return lead;
+    }
+
+    // Continuation bytes, smallest value for that length
+    size_t extra;
+    uint32_t min;
+    uint32_t codepoint;
+
+    if((lead & 0xE0) == 0xC0)
+    {
+        extra = 1;
+        min = 0x80;
+        codepoint = lead & 0x1F;
+    }
+    else if((lead & 0xF0) == 0xE0)
+    {
+        extra = 2;
+        min = 0x800;
+        codepoint = lead & 0x0F;
+    }
+    else if((lead & 0xF8) == 0xF0)
+    {
+        extra = 3;
+        min = 0x10000;
+        codepoint = lead & 0x07;
+    }
+    else
+    {
+        return REPLACEMENT;
+    }
+
+    if(static_cast<size_t>(pEnd - pText) < extra)
+    {
+        return REPLACEMENT;
+    }
+
+    for(size_t i = 0; i < extra; i++)
+    {
+        const uint8_t next = static_cast<uint8_t>(pText[i]);
+        if((next & 0xC0) != 0x80)
+        {
+            return REPLACEMENT;
+        }
+
+        codepoint = (codepoint << 6) | (next & 0x3F);
+    }
+
+    if(codepoint < min || codepoint > 0x10FFFF || (codepoint >= 0xD800 && codepoint <= 0xDFFF))
+    {
+        return REPLACEMENT;
+    }
+
+    pText += extra;
+
+    return codepoint;
+}
+
+} // End namespace utf8
@@ -0,0 +1,120 @@
+#include "flushSession.hpp"
+
+#include <cstring>
+
+#include "ssd1306.hpp"
+#include "trace.hpp"
+
+#ifndef RP_NO_HEAP
+FlushSession::FlushSession(SSD1306& display, Callback<uint32_t()> getUsFunc)
+:   mDisplay(display),
+    mGetUs(getUsFunc),
+    mPageSize(display.getWidth()),
+    mPageCount(display.getHeight() / 8),
+    mFront(mPageSize * mPageCount, 0),
+    mPending(mPageSize * mPageCount, 0)
+{
+}
+#endif
+
+FlushSession::FlushSession
+(
+    SSD1306& display,
+    Callback<uint32_t()> getUsFunc,
+    uint8_t* pFront,
+    uint8_t* pPending,
+    const size_t size
+)
+:   mDisplay(display),
+    mGetUs(getUsFunc),
+    mPageSize(display.getWidth()),
+    mPageCount(display.getHeight() / 8),
+    mFront(pFront, size, 0),
+    mPending(pPending, size, 0)
+{
+}
+
+bool FlushSession::submit(const uint8_t* pData, const size_t size)
+{
+    if(size != mPageSize * mPageCount || size != mPending.size())
+    {
+        return false;
+    }
+
+    mFramesReplaced += mIsPending;
+    memcpy(mPending.data(), pData, size);
+    mIsPending = true;
+
+    return true;
+}
+
+size_t FlushSession::step(const size_t maxPages, const uint32_t maxUs)
+{
+    TRACE_SCOPE("FlushSession::step");
+
+    const uint32_t start = mGetUs();
+    size_t sent = 0;
+
+    while(sent < maxPages)
+    {
+        // Hand over between frames only, so no frame is ever sent mixed
+        if(!mIsSending)
+        {
+            if(!mIsPending)
+            {
+                break;
+            }
+
+            mFront.swap(mPending);
+            mIsPending = false;
+            mIsSending = true;
+            mPage = 0;
+        }
+
+        // As many pages as the time left allows, and at least one per step
+        size_t count = maxPages - sent;
+        if(maxUs != 0 && mUsPerPage != 0)
+        {
+            const uint32_t elapsed = mGetUs() - start;
+            const size_t fit = (elapsed < maxUs) ? (maxUs - elapsed) / mUsPerPage : 0;
+
+            if(fit == 0 && sent > 0)
+            {
+                break;
+            }
+
+            count = (fit < count) ? ((fit > 0) ? fit : 1) : count;
+        }
+        else if(maxUs != 0)
+        {
+            // Not measured yet
+            count = 1;
+        }
+
+        count = (mPageCount - mPage < count) ? mPageCount - mPage : count;
+
+        const uint32_t before = mGetUs();
+        mDisplay.writePages(mPage, &mFront[mPage * mPageSize], count);
+        const uint32_t took = mGetUs() - before;
+        const uint32_t perPage = (took >= count) ? (took + count - 1) / count : 1;
+
+        // Follow changes in bus speed, without jumping on one slow write
+        mUsPerPage = (mUsPerPage == 0) ? perPage : (mUsPerPage * 3 + perPage + 3) / 4;
+
+        mPage += count;
+        sent += count;
+
+        if(mPage == mPageCount)
+        {
+            mIsSending = false;
+            mFramesSent++;
+        }
+
+        if(maxUs != 0 && mGetUs() - start >= maxUs)
+        {
+            break;
+        }
+    }
+
+    return sent;
+}
@@ -0,0 +1,245 @@
+#include "frameMirror.hpp"
+
+#include <cstring>
+
+#include "trace.hpp"
+
+namespace
+{
+
+/// Repeat run limits
+constexpr size_t MIN_REPEAT = 3;
+constexpr size_t MAX_REPEAT = 130;
+
+void putLe16(uint8_t* pOut, const uint32_t value)
+{
+    pOut[0] = value & 0xFF;
+    pOut[1] = (value >> 8) & 0xFF;
+}
+
+/**
+ * @brief Fletcher-16 checksum
+ */
+uint16_t fletcher16(const uint8_t* pData, const size_t size)
+{
+    uint32_t sum1 = 0;
+    uint32_t sum2 = 0;
+
+    for(size_t i = 0; i < size; i++)
+    {
+        sum1 = (sum1 + pData[i]) % 255;
+        sum2 = (sum2 + sum1) % 255;
+    }
+
+    return (sum2 << 8) | sum1;
+}
+
+} // End anonymous namespace
+
+#ifndef RP_NO_HEAP
+FrameMirror::FrameMirror
+(
+    Callback<void(const uint8_t*, const size_t)> writeFunc,
+    Callback<uint32_t()> getMsFunc,
+    const size_t width,
+    const size_t height,
+    const uint32_t bytesPerSec,
+    const uint32_t keyInterval
+)
+:   mWrite(writeFunc),
+    mGetMs(getMsFunc),
+    mWidth(width),
+    mHeight(height),
+    mBytesPerSec(bytesPerSec),
+    mKeyInterval(keyInterval),
+    mMaxPacket(getMaxPacket(width, height)),
+    mScreen(width * height / 8, 0),
+    mSent(width * height / 8, 0),
+    mPacket(mMaxPacket, 0),
+    mTokens(static_cast<uint64_t>(mMaxPacket) * 1000),
+    mLastMs(getMsFunc())
+{
+}
+#endif
+
+FrameMirror::FrameMirror
+(
+    Callback<void(const uint8_t*, const size_t)> writeFunc,
+    Callback<uint32_t()> getMsFunc,
+    const size_t width,
+    const size_t height,
+    const uint32_t bytesPerSec,
+    const uint32_t keyInterval,
+    uint8_t* pScreen,
+    uint8_t* pSent,
+    uint8_t* pPacket
+)
+:   mWrite(writeFunc),
+    mGetMs(getMsFunc),
+    mWidth(width),
+    mHeight(height),
+    mBytesPerSec(bytesPerSec),
+    mKeyInterval(keyInterval),
+    mMaxPacket(getMaxPacket(width, height)),
+    mScreen(pScreen, width * height / 8, 0),
+    mSent(pSent, width * height / 8, 0),
+    mPacket(pPacket, mMaxPacket, 0),
+    mTokens(static_cast<uint64_t>(mMaxPacket) * 1000),
+    mLastMs(getMsFunc())
+{
+}
+
+void FrameMirror::onFrame(const uint8_t* pData, const size_t size)
+{
+    const size_t count = (size < mScreen.size()) ? size : mScreen.size();
+
+    mDeferred += mIsDirty;
+    memcpy(mScreen.data(), pData, count);
+    mIsDirty = true;
+
+    poll();
+}
+
+void FrameMirror::onPage(const size_t page, const size_t col, const uint8_t* pData, const size_t size)
+{
+    if(page >= mHeight / 8 || col + size > mWidth)
+    {
+        return;
+    }
+
+    mDeferred += mIsDirty;
+    memcpy(&mScreen[page * mWidth + col], pData, size);
+    mIsDirty = true;
+
+    poll();
+}
+
+void FrameMirror::refill()
+{
+    const uint32_t now = mGetMs();
+    const uint64_t full = static_cast<uint64_t>(mMaxPacket) * 1000;
+
+    mTokens += static_cast<uint64_t>(now - mLastMs) * mBytesPerSec;
+    mTokens = (mTokens < full) ? mTokens : full;
+    mLastMs = now;
+}
+
+bool FrameMirror::poll()
+{
+    if(!mIsDirty && !mIsKeyRequested)
+    {
+        return false;
+    }
+
+    // Don't encode again until the budget covers the last packet that
+    // didn't fit, or the smallest packet there is
+    refill();
+    const size_t needed = (mNeeded > 0) ? mNeeded : HEADER_SIZE + 2 + TRAILER_SIZE;
+    if(mTokens < needed * 1000)
+    {
+        return false;
+    }
+
+    const bool isKey = mIsKeyRequested;
+    if(!isKey && memcmp(mScreen.data(), mSent.data(), mScreen.size()) == 0)
+    {
+        mIsDirty = false;
+        return false;
+    }
+
+    TRACE_SCOPE("FrameMirror::send");
+
+    const size_t payload = encode(isKey);
+    const size_t size = HEADER_SIZE + payload + TRAILER_SIZE;
+    if(mTokens < size * 1000)
+    {
+        mNeeded = size;
+        return false;
+    }
+
+    uint8_t* pOut = mPacket.data();
+    const uint32_t now = mLastMs;
+
+    pOut[0] = MAGIC_0;
+    pOut[1] = MAGIC_1;
+    pOut[2] = isKey ? TYPE_KEYFRAME : TYPE_DELTA;
+    pOut[3] = 0;
+    putLe16(&pOut[4], mSeq);
+    putLe16(&pOut[6], now);
+    putLe16(&pOut[8], now >> 16);
+    putLe16(&pOut[10], mWidth);
+    putLe16(&pOut[12], mHeight);
+    putLe16(&pOut[14], payload);
+    putLe16(&pOut[HEADER_SIZE + payload], fletcher16(&pOut[2], HEADER_SIZE - 2 + payload));
+
+    mWrite(pOut, size);
+
+    mTokens -= size * 1000;
+    mNeeded = 0;
+    memcpy(mSent.data(), mScreen.data(), mScreen.size());
+    mSeq++;
+    mPacketsSent++;
+    mBytesSent += size;
+    mIsDirty = false;
+
+    mSinceKey = isKey ? 0 : mSinceKey + 1;
+    mIsKeyRequested = (mSinceKey + 1 >= mKeyInterval);
+
+    return true;
+}
+
+size_t FrameMirror::encode(const bool isKey)
+{
+    const uint8_t* pScreen = mScreen.data();
+    const uint8_t* pSent = mSent.data();
+    const size_t size = mScreen.size();
+    uint8_t* pOut = &mPacket[HEADER_SIZE];
+    size_t out = 0;
+
+    auto at = [&](const size_t i) -> uint8_t
+    { return isKey ? pScreen[i] : pScreen[i] ^ pSent[i]; };
+
+    auto putLiterals = [&](size_t start, const size_t end)
+    {
+        while(start < end)
+        {
+            const size_t count = (end - start < MAX_LITERAL) ? end - start : MAX_LITERAL;
+
+            pOut[out++] = count - 1;
+            for(size_t j = 0; j < count; j++)
+            {
+                pOut[out++] = at(start + j);
+            }
+            start += count;
+        }
+    };
+
+    // Bytes from literalStart up to i wait to go out as literals
+    size_t literalStart = 0;
+    size_t i = 0;
+
+    while(i < size)
+    {
+        const uint8_t value = at(i);
+        size_t run = 1;
+
+        while(i + run < size && run < MAX_REPEAT && at(i + run) == value)
+        {
+            run++;
+        }
+
+        if(run >= MIN_REPEAT)
+        {
+            putLiterals(literalStart, i);
+            pOut[out++] = run + 128 - MIN_REPEAT;
+            pOut[out++] = value;
+            literalStart = i + run;
+        }
+
+        i += run;
+    }
+
+    putLiterals(literalStart, size);
+
+    return out;
+}
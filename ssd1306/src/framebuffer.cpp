@@ -1,115 +1,541 @@
 #include "framebuffer.hpp"
 
-Framebuffer::Framebuffer(const size_t width, const size_t height)
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+
+#include "pbm.hpp"
+#include "trace.hpp"
+#include "utf8.hpp"
+
+namespace
+{
+
+/**
+ * @brief Transpose an 8x8 block of pixels
+ *
+ * Based on transpose8 from Hacker's Delight; bit 7 of pIn[0] is the top
+ * left pixel, and pOut[j] receives column j with bit 7 on top.
+ *
+ * @param pIn - first row byte
+ * @param inStride - distance between row bytes
+ * @param pOut - 8 column bytes
+ */
+void transpose8(const uint8_t* pIn, const ptrdiff_t inStride, uint8_t* pOut)
+{
+    uint32_t x = (pIn[0] << 24) | (pIn[inStride] << 16) |
+                    (pIn[2 * inStride] << 8) | pIn[3 * inStride];
+    uint32_t y = (pIn[4 * inStride] << 24) | (pIn[5 * inStride] << 16) |
+                    (pIn[6 * inStride] << 8) | pIn[7 * inStride];
+    uint32_t t;
+
+    t = (x ^ (x >> 7)) & 0x00AA00AA;  x = x ^ t ^ (t << 7);
+    t = (y ^ (y >> 7)) & 0x00AA00AA;  y = y ^ t ^ (t << 7);
+
+    t = (x ^ (x >> 14)) & 0x0000CCCC;  x = x ^ t ^ (t << 14);
+    t = (y ^ (y >> 14)) & 0x0000CCCC;  y = y ^ t ^ (t << 14);
+
+    t = (x & 0xF0F0F0F0) | ((y >> 4) & 0x0F0F0F0F);
+    y = ((x << 4) & 0xF0F0F0F0) | (y & 0x0F0F0F0F);
+    x = t;
+
+    pOut[0] = x >> 24; pOut[1] = x >> 16; pOut[2] = x >> 8; pOut[3] = x;
+    pOut[4] = y >> 24; pOut[5] = y >> 16; pOut[6] = y >> 8; pOut[7] = y;
+}
+
+/**
+ * @brief Get the size of a 1 bit per pixel image in a given layout
+ *
+ * @param format - layout
+ * @param width - width in pixels
+ * @param height - height in pixels
+ * @return size_t - number of bytes
+ */
+size_t monoImageSize(const ImageFormat format, const size_t width, const size_t height)
+{
+    if(format == ImageFormat::RowMajorMsbFirst || format == ImageFormat::RowMajorLsbFirst)
+    {
+        return (width + 7) / 8 * height;
+    }
+
+    return width * (height / 8);
+}
+
+/**
+ * @brief Get one pixel of a 1 bit per pixel image in a given layout
+ *
+ * @param pData - image data
+ * @param format - layout (not Native)
+ * @param width - width in pixels
+ * @param height - height in pixels
+ * @param x - x coordinate of pixel
+ * @param y - y coordinate of pixel
+ * @return Value of pixel
+ */
+bool monoImagePixel
+(
+    const uint8_t* pData,
+    const ImageFormat format,
+    const size_t width,
+    const size_t height,
+    const size_t x,
+    const size_t y
+)
+{
+    switch(format)
+    {
+        case ImageFormat::PageMajor:
+            return pData[(y / 8) * width + x] & (1 << (y % 8));
+
+        case ImageFormat::ColumnMajor:
+            return pData[x * (height / 8) + y / 8] & (1 << (y % 8));
+
+        case ImageFormat::RowMajorMsbFirst:
+            return pData[y * ((width + 7) / 8) + x / 8] & (0x80 >> (x % 8));
+
+        case ImageFormat::RowMajorLsbFirst:
+            return pData[y * ((width + 7) / 8) + x / 8] & (1 << (x % 8));
+
+        default:
+            return false;
+    }
+}
+
+/**
+ * @brief Table spreading each bit of a byte over scale bits
+ *
+ * @tparam scale - 2 or 3
+ */
+template <size_t scale>
+struct BitExpandTable
+{
+    /// Expanded bits of each byte value
+    std::conditional_t<scale == 2, uint16_t, uint32_t> values[256];
+
+    constexpr BitExpandTable()
+    :
+    values()
+    {
+        for(size_t i = 0; i < 256; i++)
+        {
+            for(size_t bit = 0; bit < 8; bit++)
+            {
+                if(i & (1 << bit))
+                {
+                    values[i] |= ((1u << scale) - 1) << (bit * scale);
+                }
+            }
+        }
+    }
+};
+
+/// Bit doubling and tripling, in flash
+constexpr BitExpandTable<2> DOUBLE_BITS;
+constexpr BitExpandTable<3> TRIPLE_BITS;
+
+/**
+ * @brief Scale a glyph column vertically
+ *
+ * Each source byte becomes scale whole bytes, so the result is still a
+ * column of packed bytes.  4x is doubling twice.
+ *
+ * @param pIn - column bytes
+ * @param size - number of column bytes
+ * @param scale - 2, 3 or 4
+ * @param pOut - receives size * scale bytes
+ */
+void expandColumn(const uint8_t* pIn, const size_t size, const size_t scale, uint8_t* pOut)
+{
+    for(size_t i = 0; i < size; i++)
+    {
+        const uint32_t value = (scale == 3) ? TRIPLE_BITS.values[pIn[i]] : DOUBLE_BITS.values[pIn[i]];
+
+        if(scale == 4)
+        {
+            const uint32_t low = DOUBLE_BITS.values[value & 0xFF];
+            const uint32_t high = DOUBLE_BITS.values[value >> 8];
+            *pOut++ = low;
+            *pOut++ = low >> 8;
+            *pOut++ = high;
+            *pOut++ = high >> 8;
+        }
+        else
+        {
+            for(size_t j = 0; j < scale; j++)
+            {
+                *pOut++ = value >> (j * 8);
+            }
+        }
+    }
+}
+
+/**
+ * @brief The part of a line of text that fits in a given width
+ */
+struct LineFit
+{
+    /// End of the text to draw
+    const char* pEnd;
+    /// Start of the next line
+    const char* pNext;
+    /// Width of the text to draw
+    size_t width;
+    /// True if the line was cut short rather than broken or ended
+    bool isCut;
+};
+
+/**
+ * @brief Measure how much of a line fits in a given width
+ *
+ * @param font - font to measure with
+ * @param pText - start of the line
+ * @param pEnd - end of text
+ * @param maxWidth - width available (pixels)
+ * @param isWrapped - if true break after the last whole word that fits, if
+ *                    false cut at the last character that fits and skip
+ *                    the rest of the line
+ * @param scale - text magnification
+ * @return LineFit - what to draw and where the next line starts
+ */
+LineFit fitLine(const Font& font, const char* pText, const char* pEnd,
+                const size_t maxWidth, const bool isWrapped, const size_t scale)
+{
+    LineFit fit = {pEnd, pEnd, 0, false};
+    const char* pBreak = nullptr;
+    size_t breakWidth = 0;
+    const char* pPos = pText;
+
+    while(pPos < pEnd)
+    {
+        const char* pChar = pPos;
+        const uint32_t codepoint = utf8::decode(pPos, pEnd);
+
+        if(codepoint == '\n')
+        {
+            fit.pEnd = pChar;
+            fit.pNext = pPos;
+            return fit;
+        }
+
+        if(codepoint == ' ')
+        {
+            pBreak = pChar;
+            breakWidth = fit.width;
+        }
+
+        const size_t advance = font.getGlyph(codepoint).advance * scale;
+        if(fit.width + advance <= maxWidth)
+        {
+            fit.width += advance;
+            continue;
+        }
+
+        if(!isWrapped)
+        {
+            // Drop the rest of the line
+            fit.pEnd = pChar;
+            fit.isCut = true;
+            while(pPos < pEnd && *pPos++ != '\n')
+            {
+            }
+            fit.pNext = pPos;
+        }
+        else if(pBreak != nullptr)
+        {
+            // Break at the last space; the spaces themselves aren't drawn
+            fit.pEnd = pBreak;
+            fit.width = breakWidth;
+            while(pBreak < pEnd && *pBreak == ' ')
+            {
+                pBreak++;
+            }
+            fit.pNext = pBreak;
+        }
+        else
+        {
+            // Split a word wider than the line, keeping at least one
+            // character so every line makes progress
+            const bool isFirst = (pChar == pText);
+            fit.pEnd = isFirst ? pPos : pChar;
+            fit.width += isFirst ? advance : 0;
+            fit.isCut = isFirst;
+            fit.pNext = fit.pEnd;
+        }
+
+        return fit;
+    }
+
+    return fit;
+}
+
+} // End anonymous namespace
+
+#ifndef RP_NO_HEAP
+template <typename Format>
+BasicFramebuffer<Format>::BasicFramebuffer(const size_t width, const size_t height)
 :   mWidth(width),
     mHeight(height),
-    mHeightBytes(height / 8),
-    mBuf(width, std::vector<bool>(height, false)),
-    mOutBuf(width * mHeightBytes, 0)
+    mBuf(Format::bufSize(width, height), 0)
 {
 }
+#endif
 
-bool Framebuffer::getPixel(const size_t x, const size_t y)
+template <typename Format>
+typename BasicFramebuffer<Format>::Pixel
+BasicFramebuffer<Format>::getPixel(const size_t x, const size_t y)
 {
     if(x >= mWidth || y >= mHeight)
     {
-        return false;
+        return Format::PIXEL_OFF;
     }
 
-    return mBuf[x][y];
+    return Format::get(mBuf.data(), mWidth, x, y);
 }
 
-bool Framebuffer::setPixel(const size_t x, const size_t y, const bool val)
+template <typename Format>
+bool BasicFramebuffer<Format>::setPixel(const size_t x, const size_t y, const Pixel val)
 {
     if(x >= mWidth || y >= mHeight)
     {
         return false;
     }
 
-    mBuf[x][y] = val;
+    Format::set(mBuf.data(), mWidth, x, y, val);
     return true;
 }
 
-uint8_t* Framebuffer::getBuffer()
+template <typename Format>
+uint8_t* BasicFramebuffer<Format>::getBuffer()
 {
-    // Convert 2d vector<bool> to vector of bytes
-    size_t linearByte = 0;
+    TRACE_SCOPE("Framebuffer::getBuffer");
+
+    // Already in controller RAM order
+    return mBuf.data();
+}
 
-    for(size_t x = 0; x < mWidth; x++)
+template <typename Format>
+bool BasicFramebuffer<Format>::setBuffer
+(
+    const uint8_t* pData,
+    const size_t size,
+    const ImageFormat format
+)
+{
+    TRACE_SCOPE("Framebuffer::setBuffer");
+
+    constexpr bool isMonoPage = std::is_same_v<Format, MonoPageFormat>;
+
+    if(format == ImageFormat::Native || (isMonoPage && format == ImageFormat::PageMajor))
     {
-        uint8_t b = 0;
+        if(size != mBuf.size())
+        {
+            return false;
+        }
 
-        for(size_t y = 0; y < mHeight; y++)
+        memcpy(mBuf.data(), pData, size);
+        return true;
+    }
+
+    if(size != monoImageSize(format, mWidth, mHeight))
+    {
+        return false;
+    }
+
+    if constexpr (isMonoPage)
+    {
+        const size_t pages = mHeight / 8;
+
+        if(format == ImageFormat::ColumnMajor)
         {
-            b = b >> 1;
-            b |= (mBuf[x][y]) ? 0x80 : 0;
+            for(size_t x = 0; x < mWidth; x++)
+            {
+                for(size_t page = 0; page < pages; page++)
+                {
+                    mBuf[page * mWidth + x] = *pData++;
+                }
+            }
+            return true;
+        }
+
+        // Row-major - transpose a block of 8x8 pixels at a time
+        const size_t rowBytes = (mWidth + 7) / 8;
+        const bool isMsbFirst = (format == ImageFormat::RowMajorMsbFirst);
 
-            if(y % 8 == 7)
+        for(size_t page = 0; page < pages; page++)
+        {
+            // Bottom row of the page first so bit 0 ends up on top
+            const uint8_t* pRows = pData + (page * 8 + 7) * rowBytes;
+            uint8_t* pPage = &mBuf[page * mWidth];
+
+            for(size_t block = 0; block < rowBytes; block++)
             {
-                mOutBuf[linearByte] = b;
-                linearByte++;
-                b = 0;             
+                uint8_t cols[8];
+                transpose8(pRows + block, -static_cast<ptrdiff_t>(rowBytes), cols);
+
+                const size_t x = block * 8;
+                const size_t count = (mWidth - x < 8) ? mWidth - x : 8;
+
+                for(size_t i = 0; i < count; i++)
+                {
+                    pPage[x + i] = cols[(isMsbFirst) ? i : 7 - i];
+                }
             }
         }
+        return true;
+    }
+    else
+    {
+        // Expand 1 bit per pixel images to fully on/off pixels
+        for(size_t y = 0; y < mHeight; y++)
+        {
+            for(size_t x = 0; x < mWidth; x++)
+            {
+                const bool isOn = monoImagePixel(pData, format, mWidth, mHeight, x, y);
+                Format::set(mBuf.data(), mWidth, x, y,
+                            (isOn) ? Format::PIXEL_ON : Format::PIXEL_OFF);
+            }
+        }
+        return true;
     }
-
-    return mOutBuf.data();
 }
 
-void Framebuffer::setBuffer(const uint8_t* pData, const size_t size)
+template <typename Format>
+bool BasicFramebuffer<Format>::loadPbm(const uint8_t* pData, const size_t size)
 {
+    TRACE_SCOPE("Framebuffer::loadPbm");
+
+    PbmImage image;
+
+    if(!parsePbm(pData, size, image) ||
+        image.width != mWidth ||
+        image.height != mHeight)
+    {
+        return false;
+    }
+
+    if(!image.isPlain)
+    {
+        return setBuffer(image.pPixels, image.size, ImageFormat::RowMajorMsbFirst);
+    }
+
+    // Plain images are a character per pixel; no fast path worth having
+    size_t pixel = 0;
+
+    for(size_t i = 0; i < image.size && pixel < mWidth * mHeight; i++)
+    {
+        const uint8_t c = image.pPixels[i];
+
+        if(c == '0' || c == '1')
+        {
+            setPixel(pixel % mWidth, pixel / mWidth,
+                        (c == '1') ? Format::PIXEL_ON : Format::PIXEL_OFF);
+            pixel++;
+        }
+        else if(c == '#')
+        {
+            while(i < image.size && image.pPixels[i] != '\n')
+            {
+                i++;
+            }
+        }
+    }
 
+    return pixel == mWidth * mHeight;
 }
 
-bool Framebuffer::setChar(const char c, const size_t x, const size_t y)
+template <typename Format>
+bool BasicFramebuffer<Format>::setChar(const uint32_t codepoint, const size_t x, const size_t y)
 {
     // Bounds check
-    if(x >= mWidth || y >= mHeight)
+    if(x >= mWidth || y >= mHeight || mpFont == nullptr)
     {
         return false;
     }
 
-    // Ensure character font exists
-    const auto it = mpFontMap->find(c);
-    if(it == mpFontMap->end())
+    const Glyph* pGlyph = mpFont->findGlyph(codepoint);
+    const bool isFound = (pGlyph != nullptr);
+    if(!isFound)
     {
-        return false;
+        pGlyph = &mpFont->pGlyphs[mpFont->fallback];
     }
 
-    const std::vector<std::vector<bool>>* pCharVec = &(it->second);
-    
-    size_t yPos = y;
+    const uint8_t* pColumn = mpFont->getBitmap(*pGlyph);
+    const size_t colBytes = (pGlyph->height + 7) / 8;
+    const int32_t scale = static_cast<int32_t>(mTextScale);
 
-    // Process letter lines in reverse to match screen RAM
-    for(int i = pCharVec->size() - 1; i >= 0; i--)
+    // Offsets can put part of the glyph left of or below the screen
+    const int32_t left = static_cast<int32_t>(x) + pGlyph->xOffset * scale;
+    const int32_t bottom = static_cast<int32_t>(y) + pGlyph->yOffset * scale;
+    const size_t rows = pGlyph->height * mTextScale;
+    const size_t skipRows = (bottom < 0) ? -bottom : 0;
+    if(skipRows >= rows)
     {
-        const auto& line = pCharVec->at(i);
+        return isFound;
+    }
 
-        if(yPos >= mHeight)
+    // Columns are stored bottom row first, the order they are drawn in;
+    // scaled ones are expanded once and drawn scale times
+    uint8_t scaled[4 * MAX_TEXT_SCALE];
+
+    for(size_t col = 0; col < pGlyph->width; col++, pColumn += colBytes)
+    {
+        const uint8_t* pBits = pColumn;
+        if(mTextScale > 1)
         {
-            break;
+            expandColumn(pColumn, colBytes, mTextScale, scaled);
+            pBits = scaled;
         }
 
-        size_t xPos = x;
-
-        for(const bool bit : line)
+        for(int32_t copy = 0; copy < scale; copy++)
         {
-            if(xPos >= mWidth)
+            const int32_t colX = left + static_cast<int32_t>(col) * scale + copy;
+            if(colX < 0)
             {
                 continue;
             }
+            if(colX >= static_cast<int32_t>(mWidth))
+            {
+                return isFound;
+            }
 
-            mBuf[xPos][yPos] = bit;
-            xPos++;
+            Format::drawColumn(mBuf.data(), mWidth, mHeight, colX, bottom + skipRows,
+                                pBits, skipRows, rows, mTextFg, mTextBg, mTextOp);
         }
+    }
 
-        yPos++;
+    return isFound;
+} // End setChar
+
+template <typename Format>
+bool BasicFramebuffer<Format>::setTextScale(const size_t scale)
+{
+    if(scale < 1 || scale > MAX_TEXT_SCALE)
+    {
+        return false;
     }
 
+    mTextScale = scale;
+
     return true;
-} // End setChar
+}
 
-bool Framebuffer::setText
+template <typename Format>
+size_t BasicFramebuffer<Format>::drawRun(size_t x, const size_t y, const char* pText, const char* pEnd)
+{
+    while(pText < pEnd && x < mWidth)
+    {
+        const uint32_t codepoint = utf8::decode(pText, pEnd);
+
+        setChar(codepoint, x, y);
+        x += mpFont->getGlyph(codepoint).advance * mTextScale;
+    }
+
+    // Anything left is off the right edge
+    return (pText < pEnd) ? mWidth + 1 : x;
+}
+
+template <typename Format>
+bool BasicFramebuffer<Format>::setText
 (
     const size_t x,
     const size_t y,
@@ -117,50 +543,115 @@ bool Framebuffer::setText
     const size_t size
 )
 {
-    for(size_t i = 0; i < size; i++)
+    TRACE_SCOPE("Framebuffer::setText");
+
+    if(mpFont == nullptr)
     {
-        bool result = setChar(pText[i], x + (i * 8), y);
-        if(!result)
-        {
-            return false;
-        }
+        return false;
     }
 
-    return true;
+    return drawRun(x, y, pText, pText + size) <= mWidth;
 }
 
-void Framebuffer::setRect
+template <typename Format>
+size_t BasicFramebuffer<Format>::setTextBox
 (
-    const size_t x0, 
-    const size_t y0, 
-    const size_t x1, 
+    const size_t x0,
+    const size_t y0,
+    const size_t x1,
     const size_t y1,
-    const bool val
+    const char* pText,
+    const size_t size,
+    const TextAlign align,
+    const bool isWrapped
 )
 {
-    for(size_t x = x0; x < x1; x++)
+    TRACE_SCOPE("Framebuffer::setTextBox");
+
+    const size_t lineHeight = (mpFont != nullptr) ? mpFont->lineHeight * mTextScale : 0;
+    if(lineHeight == 0 || x0 >= x1 || y1 < y0 + lineHeight)
+    {
+        return 0;
+    }
+
+    const size_t boxWidth = x1 - x0;
+    const char* pStart = pText;
+    const char* pEnd = pText + size;
+
+    // Ellipsis, and its width
+    static constexpr char ELLIPSIS[] = "\xE2\x80\xA6";
+    static constexpr char DOTS[] = "...";
+    const bool hasEllipsis = (mpFont->findGlyph(0x2026) != nullptr);
+    const char* pEllipsis = hasEllipsis ? ELLIPSIS : DOTS;
+    const size_t ellipsisSize = hasEllipsis ? sizeof(ELLIPSIS) - 1 : sizeof(DOTS) - 1;
+    const size_t ellipsisWidth = getTextWidth(pEllipsis, ellipsisSize);
+
+    for(size_t bottom = y1 - lineHeight; pText < pEnd; bottom -= lineHeight)
     {
-        if(x >= mWidth)
+        const bool isLastLine = (bottom < y0 + lineHeight);
+        LineFit fit = fitLine(*mpFont, pText, pEnd, boxWidth, isWrapped, mTextScale);
+
+        // Make room for the ellipsis if text is cut here or runs out of box
+        const bool isClipped = fit.isCut || (isLastLine && fit.pNext < pEnd);
+        const bool isEllipsis = isClipped && ellipsisWidth <= boxWidth;
+        if(isEllipsis)
         {
-            // No more y pixels to write - bail
-            return;
+            const LineFit shortFit = fitLine(*mpFont, pText, pEnd, boxWidth - ellipsisWidth, false, mTextScale);
+            fit.pEnd = shortFit.pEnd;
+            fit.width = shortFit.width;
         }
 
-        for(size_t y = y0; y < y1; y++)
+        const size_t lineWidth = fit.width + (isEllipsis ? ellipsisWidth : 0);
+        size_t x = x0;
+        if(align == TextAlign::Center)
         {
-            if(y >= mHeight)
-            {
-                // Out of y pixels for this x, but there
-                // may be more for other x
-                continue;
-            }
+            x += (boxWidth - lineWidth) / 2;
+        }
+        else if(align == TextAlign::Right)
+        {
+            x += boxWidth - lineWidth;
+        }
+
+        x = drawRun(x, bottom, pText, fit.pEnd);
+        if(isEllipsis)
+        {
+            drawRun(x, bottom, pEllipsis, pEllipsis + ellipsisSize);
+        }
 
-            setPixel(x, y, val);
+        if(isLastLine)
+        {
+            return (fit.pNext < pEnd) ? fit.pEnd - pStart : size;
         }
+
+        pText = fit.pNext;
     }
+
+    return size;
+}
+
+template <typename Format>
+void BasicFramebuffer<Format>::setRect
+(
+    const size_t x0,
+    const size_t y0,
+    const size_t x1,
+    const size_t y1,
+    const Pixel val
+)
+{
+    TRACE_SCOPE("Framebuffer::setRect");
+
+    const size_t xEnd = (x1 < mWidth) ? x1 : mWidth;
+    const size_t yEnd = (y1 < mHeight) ? y1 : mHeight;
+
+    if(x0 >= xEnd || y0 >= yEnd)
+    {
+        return;
+    }
+
+    Format::fillRect(mBuf.data(), mWidth, x0, y0, xEnd, yEnd, val);
 }
 
-// void Framebuffer::clearScreen()
-// {
-//     clearRect(0, 0, mWidth, mHeight);
-// }
\ No newline at end of file
+template class BasicFramebuffer<MonoPageFormat>;
+template class BasicFramebuffer<Ssd1322Format>;
+template class BasicFramebuffer<Ssd1327Format>;
\ No newline at end of file
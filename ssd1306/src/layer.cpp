@@ -0,0 +1,220 @@
+#include "layer.hpp"
+
+#include <cstring>
+
+#ifndef RP_NO_HEAP
+Layer::Layer(const size_t width, const size_t height)
+:   mWidth(width),
+    mHeight(height),
+    mPages(height / 8),
+    mPixels(width * mPages, 0),
+    mMask(width * mPages, 0),
+    mDirty(mPages, DirtySpan{0xFFFF, 0})
+{
+}
+#endif
+
+Layer::Layer
+(
+    const size_t width,
+    const size_t height,
+    uint8_t* pPixels,
+    uint8_t* pMask,
+    DirtySpan* pDirty
+)
+:   mWidth(width),
+    mHeight(height),
+    mPages(height / 8),
+    mPixels(pPixels, width * mPages, 0),
+    mMask(pMask, width * mPages, 0),
+    mDirty(pDirty, mPages, DirtySpan{0xFFFF, 0})
+{
+}
+
+bool Layer::getPixel(const size_t x, const size_t y) const
+{
+    if(x >= mWidth || y >= mHeight)
+    {
+        return false;
+    }
+
+    return mPixels[(y / 8) * mWidth + x] & (1 << (y % 8));
+}
+
+bool Layer::isOpaque(const size_t x, const size_t y) const
+{
+    if(x >= mWidth || y >= mHeight)
+    {
+        return false;
+    }
+
+    return mMask[(y / 8) * mWidth + x] & (1 << (y % 8));
+}
+
+bool Layer::setPixel(const size_t x, const size_t y, const bool val)
+{
+    if(x >= mWidth || y >= mHeight)
+    {
+        return false;
+    }
+
+    updatePage(y / 8, x, x + 1, 1 << (y % 8), true, val);
+    return true;
+}
+
+bool Layer::clearPixel(const size_t x, const size_t y)
+{
+    if(x >= mWidth || y >= mHeight)
+    {
+        return false;
+    }
+
+    updatePage(y / 8, x, x + 1, 1 << (y % 8), false, false);
+    return true;
+}
+
+void Layer::setRect
+(
+    const size_t x0,
+    const size_t y0,
+    const size_t x1,
+    const size_t y1,
+    const bool val
+)
+{
+    const size_t xEnd = (x1 < mWidth) ? x1 : mWidth;
+    const size_t yEnd = (y1 < mHeight) ? y1 : mHeight;
+
+    // Work a page at a time so each column byte is touched once
+    for(size_t y = y0; y < yEnd; y = (y / 8 + 1) * 8)
+    {
+        const size_t pageEnd = (y / 8 + 1) * 8;
+        const size_t rows = ((yEnd < pageEnd) ? yEnd : pageEnd) - y;
+        const uint8_t bits = ((1 << rows) - 1) << (y % 8);
+
+        updatePage(y / 8, x0, xEnd, bits, true, val);
+    }
+}
+
+void Layer::clearRect
+(
+    const size_t x0,
+    const size_t y0,
+    const size_t x1,
+    const size_t y1
+)
+{
+    const size_t xEnd = (x1 < mWidth) ? x1 : mWidth;
+    const size_t yEnd = (y1 < mHeight) ? y1 : mHeight;
+
+    for(size_t y = y0; y < yEnd; y = (y / 8 + 1) * 8)
+    {
+        const size_t pageEnd = (y / 8 + 1) * 8;
+        const size_t rows = ((yEnd < pageEnd) ? yEnd : pageEnd) - y;
+        const uint8_t bits = ((1 << rows) - 1) << (y % 8);
+
+        updatePage(y / 8, x0, xEnd, bits, false, false);
+    }
+}
+
+bool Layer::setBuffer(const uint8_t* pData, const size_t size)
+{
+    if(size != mPixels.size())
+    {
+        return false;
+    }
+
+    memcpy(mPixels.data(), pData, size);
+    memset(mMask.data(), 0xFF, size);
+    markAllDirty();
+    return true;
+}
+
+void Layer::setVisible(const bool isVisible)
+{
+    if(isVisible != mIsVisible)
+    {
+        mIsVisible = isVisible;
+        markAllDirty();
+    }
+}
+
+void Layer::updatePage
+(
+    const size_t page,
+    const size_t x0,
+    const size_t x1,
+    const uint8_t bits,
+    const bool opaque,
+    const bool val
+)
+{
+    if(x0 >= x1)
+    {
+        return;
+    }
+
+    const uint8_t maskVal = (opaque) ? bits : 0;
+    const uint8_t pixelVal = (opaque && val) ? bits : 0;
+
+    uint8_t* pPixels = &mPixels[page * mWidth];
+    uint8_t* pMask = &mMask[page * mWidth];
+
+    // Only columns that actually change need to be recomposited
+    size_t first = x1;
+    size_t last = x0;
+
+    for(size_t x = x0; x < x1; x++)
+    {
+        const uint8_t mask = (pMask[x] & ~bits) | maskVal;
+        const uint8_t pixels = (pPixels[x] & ~bits) | pixelVal;
+
+        if(mask != pMask[x] || pixels != pPixels[x])
+        {
+            pMask[x] = mask;
+            pPixels[x] = pixels;
+
+            if(first == x1)
+            {
+                first = x;
+            }
+            last = x;
+        }
+    }
+
+    if(first != x1)
+    {
+        markDirty(page, first, last);
+    }
+}
+
+void Layer::markDirty(const size_t page, const size_t x0, const size_t x1)
+{
+    DirtySpan& span = mDirty[page];
+
+    // Empty span - take the new one as is
+    if(span.x0 > span.x1)
+    {
+        span.x0 = x0;
+        span.x1 = x1;
+        return;
+    }
+
+    if(x0 < span.x0)
+    {
+        span.x0 = x0;
+    }
+    if(x1 > span.x1)
+    {
+        span.x1 = x1;
+    }
+}
+
+void Layer::markAllDirty()
+{
+    for(auto& span : mDirty)
+    {
+        span.x0 = 0;
+        span.x1 = mWidth - 1;
+    }
+}
\ No newline at end of file
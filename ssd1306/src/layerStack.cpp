@@ -0,0 +1,216 @@
+#include "layerStack.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "trace.hpp"
+
+#ifndef RP_NO_HEAP
+LayerStack::LayerStack(const size_t width, const size_t height, const size_t maxLayers)
+:   mWidth(width),
+    mHeight(height),
+    mPages(height / 8),
+    mLayers(maxLayers, nullptr),
+    mOut(width * mPages, 0),
+    mDirty(mPages, Layer::DirtySpan{0, static_cast<uint16_t>(width - 1)})
+{
+}
+#endif
+
+LayerStack::LayerStack
+(
+    const size_t width,
+    const size_t height,
+    Layer** ppLayers,
+    const size_t maxLayers,
+    uint8_t* pOut,
+    Layer::DirtySpan* pDirty
+)
+:   mWidth(width),
+    mHeight(height),
+    mPages(height / 8),
+    mLayers(ppLayers, maxLayers, nullptr),
+    mOut(pOut, width * mPages, 0),
+    mDirty(pDirty, mPages, Layer::DirtySpan{0, static_cast<uint16_t>(width - 1)})
+{
+}
+
+bool LayerStack::push(Layer* pLayer)
+{
+    if(pLayer == nullptr ||
+        pLayer->mWidth != mWidth ||
+        pLayer->mHeight != mHeight)
+    {
+        return false;
+    }
+
+    Layer** ppEnd = mLayers.begin() + mLayerCount;
+    if(mLayerCount == mLayers.size() || std::find(mLayers.begin(), ppEnd, pLayer) != ppEnd)
+    {
+        return false;
+    }
+
+    mLayers[mLayerCount++] = pLayer;
+    pLayer->markAllDirty();
+    return true;
+}
+
+bool LayerStack::remove(Layer* pLayer)
+{
+    Layer** ppEnd = mLayers.begin() + mLayerCount;
+    Layer** ppLayer = std::find(mLayers.begin(), ppEnd, pLayer);
+    if(ppLayer == ppEnd)
+    {
+        return false;
+    }
+
+    // Keep the order of the layers above it
+    std::copy(ppLayer + 1, ppEnd, ppLayer);
+    mLayerCount--;
+
+    // Whatever the layer covered has to be redrawn from the rest
+    invalidate();
+    return true;
+}
+
+void LayerStack::invalidate()
+{
+    for(auto& span : mDirty)
+    {
+        span.x0 = 0;
+        span.x1 = mWidth - 1;
+    }
+}
+
+size_t LayerStack::flush(SSD1306& display)
+{
+    TRACE_SCOPE("LayerStack::flush");
+
+    collectDirty();
+
+    size_t sent = 0;
+
+    for(size_t page = 0; page < mPages; page++)
+    {
+        Layer::DirtySpan& span = mDirty[page];
+
+        if(span.x0 > span.x1)
+        {
+            continue;
+        }
+
+        composite(page, span.x0, span.x1);
+
+        const size_t size = span.x1 - span.x0 + 1;
+        display.writePage(page, span.x0, &mOut[page * mWidth + span.x0], size);
+        sent += size;
+
+        span.x0 = 0xFFFF;
+        span.x1 = 0;
+    }
+
+    return sent;
+}
+
+const uint8_t* LayerStack::getBuffer()
+{
+    TRACE_SCOPE("LayerStack::getBuffer");
+
+    collectDirty();
+
+    for(size_t page = 0; page < mPages; page++)
+    {
+        Layer::DirtySpan& span = mDirty[page];
+
+        if(span.x0 <= span.x1)
+        {
+            composite(page, span.x0, span.x1);
+        }
+    }
+
+    // Pages are composited but still need to be sent by flush()
+    return mOut.data();
+}
+
+void LayerStack::collectDirty()
+{
+    for(size_t i = 0; i < mLayerCount; i++)
+    {
+        Layer* pLayer = mLayers[i];
+
+        for(size_t page = 0; page < mPages; page++)
+        {
+            Layer::DirtySpan& layerSpan = pLayer->mDirty[page];
+
+            if(layerSpan.x0 > layerSpan.x1)
+            {
+                continue;
+            }
+
+            Layer::DirtySpan& span = mDirty[page];
+
+            if(span.x0 > span.x1)
+            {
+                span = layerSpan;
+            }
+            else
+            {
+                span.x0 = std::min(span.x0, layerSpan.x0);
+                span.x1 = std::max(span.x1, layerSpan.x1);
+            }
+
+            layerSpan.x0 = 0xFFFF;
+            layerSpan.x1 = 0;
+        }
+    }
+}
+
+void LayerStack::composite(const size_t page, const size_t x0, const size_t x1)
+{
+    const size_t offset = page * mWidth;
+
+    // Widen the span to whole words; recompositing a few extra
+    // unchanged columns is cheaper than handling the odd bytes
+    size_t start = x0;
+    size_t end = x1 + 1;
+    if(offset % 4 == 0)
+    {
+        start &= ~size_t(3);
+        end = std::min((end + 3) & ~size_t(3), mWidth);
+    }
+
+    uint8_t* pOut = &mOut[offset];
+    memset(pOut + start, 0, end - start);
+
+    for(size_t i = 0; i < mLayerCount; i++)
+    {
+        const Layer* pLayer = mLayers[i];
+
+        if(!pLayer->mIsVisible)
+        {
+            continue;
+        }
+
+        const uint8_t* pPixels = &pLayer->mPixels[offset];
+        const uint8_t* pMask = &pLayer->mMask[offset];
+
+        size_t x = start;
+
+        // Pixels are always 0 where the mask is, so out = (out & ~mask) | pixels
+        for(; x + 4 <= end; x += 4)
+        {
+            uint32_t out, pixels, mask;
+            memcpy(&out, pOut + x, sizeof(out));
+            memcpy(&pixels, pPixels + x, sizeof(pixels));
+            memcpy(&mask, pMask + x, sizeof(mask));
+
+            out = (out & ~mask) | pixels;
+            memcpy(pOut + x, &out, sizeof(out));
+        }
+
+        for(; x < end; x++)
+        {
+            pOut[x] = (pOut[x] & ~pMask[x]) | pPixels[x];
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,106 @@
+#include "pbm.hpp"
+
+namespace
+{
+
+/**
+ * @brief Check for PBM whitespace
+ */
+bool isSpace(const uint8_t c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' ||
+            c == '\v' || c == '\f';
+}
+
+/**
+ * @brief Skip whitespace and '#' comments
+ *
+ * @param pData - PBM data
+ * @param size - size of PBM data
+ * @param pos - position, advanced past whitespace/comments
+ */
+void skipSpace(const uint8_t* pData, const size_t size, size_t& pos)
+{
+    while(pos < size)
+    {
+        if(pData[pos] == '#')
+        {
+            while(pos < size && pData[pos] != '\n')
+            {
+                pos++;
+            }
+        }
+        else if(isSpace(pData[pos]))
+        {
+            pos++;
+        }
+        else
+        {
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Read a decimal header field
+ *
+ * @param pData - PBM data
+ * @param size - size of PBM data
+ * @param pos - position, advanced past the number
+ * @param value - number read
+ * @return true if a non-zero number was read, false otherwise
+ */
+bool readNumber(const uint8_t* pData, const size_t size, size_t& pos, size_t& value)
+{
+    skipSpace(pData, size, pos);
+
+    value = 0;
+    const size_t start = pos;
+
+    while(pos < size && pData[pos] >= '0' && pData[pos] <= '9')
+    {
+        value = value * 10 + (pData[pos] - '0');
+        pos++;
+    }
+
+    return pos != start && value != 0;
+}
+
+} // End anonymous namespace
+
+bool parsePbm(const uint8_t* pData, const size_t size, PbmImage& image)
+{
+    if(size < 2 || pData[0] != 'P' || (pData[1] != '1' && pData[1] != '4'))
+    {
+        return false;
+    }
+
+    size_t pos = 2;
+
+    image.isPlain = (pData[1] == '1');
+
+    if(!readNumber(pData, size, pos, image.width) ||
+        !readNumber(pData, size, pos, image.height))
+    {
+        return false;
+    }
+
+    if(image.isPlain)
+    {
+        image.pPixels = pData + pos;
+        image.size = size - pos;
+        return true;
+    }
+
+    // Raw data starts after exactly one whitespace character
+    if(pos >= size || !isSpace(pData[pos]))
+    {
+        return false;
+    }
+    pos++;
+
+    image.pPixels = pData + pos;
+    image.size = (image.width + 7) / 8 * image.height;
+
+    return size - pos >= image.size;
+}
\ No newline at end of file
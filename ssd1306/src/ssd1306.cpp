@@ -1,100 +1,287 @@
-#include "SSD1306.hpp"
+#include "ssd1306.hpp"
+
+#include <cassert>
+
+#include "frameMirror.hpp"
+#include "trace.hpp"
 
 SSD1306::SSD1306
 (
-    std::function<void(const uint8_t*, const size_t)> writeFunc,
-    std::function<void(const uint8_t pint, const bool)> setPinFunc,
-    std::function<void(const uint32_t)> delayMsFunc,
+    Callback<void(const uint8_t*, const size_t)> writeFunc,
+    Callback<void(const uint8_t pint, const bool)> setPinFunc,
+    Callback<void(const uint32_t)> delayMsFunc,
     const uint8_t dcPin,
     const uint8_t resetPin,
     const size_t width, 
     const size_t height
 )
-:   mWrite(writeFunc),
+:   SSD1306(writeFunc, setPinFunc, delayMsFunc, dcPin, resetPin,
+            selectProfile(width, height))
+{
+    // Release builds have no assert, so leave the mismatch for the caller
+    mIsProfileMatched = (mWidth == width && mHeight == height);
+}
+
+SSD1306::SSD1306
+(
+    Callback<void(const uint8_t*, const size_t)> writeFunc,
+    Callback<void(const uint8_t pint, const bool)> setPinFunc,
+    Callback<void(const uint32_t)> delayMsFunc,
+    const uint8_t dcPin,
+    const uint8_t resetPin,
+    const PanelProfile& profile
+)
+:   mProfile(profile),
+    mWrite(writeFunc),
     mSetPin(setPinFunc),
     mDelayMs(delayMsFunc),
     mDcPin(dcPin),
     mResetPin(resetPin),
-    mWidth(width),
-    mHeight(height)
+    mWidth(profile.width),
+    mHeight(profile.height)
 {
     init();
 }
 
+const PanelProfile& SSD1306::selectProfile(const size_t width, const size_t height)
+{
+    if(width == panels::SSD1306_128X32.width && height == panels::SSD1306_128X32.height)
+    {
+        return panels::SSD1306_128X32;
+    }
+
+    // Any other size is a wiring or build mistake, not something to guess;
+    // without asserts it gets the default, flagged by isProfileMatched
+    assert(width == panels::SSD1306_128X64.width && height == panels::SSD1306_128X64.height &&
+            "no SSD1306 profile for this size; pass a PanelProfile instead");
+    return panels::SSD1306_128X64;
+}
+
 void SSD1306::init()
 {
     mSetPin(mDcPin, true);
 
-    // Turn off display before configuring
-    setDisplayOn(false);
-
     // Reset display to defaults
     reset();
 
-    // Set memory address mode to horizontal
-    setMemAddrMode(1);
+    // Whole configuration goes out as one burst straight from flash
+    writeCmds(mProfile.pInitCmds, mProfile.initCmdsSize);
+
+    // Every init table leaves the controller in the same known state
+    mContrast = mProfile.contrast;
+    mIsInverted = false;
+    mIsDisplayOn = true;
+    mStartLine = 0;
+    mDisplayOffset = 0;
+    mCacheValid = CACHE_ALL;
+}
 
-    // Set starting line/row to 0
-    setStartLine(0);
+void SSD1306::writeCmd(const uint8_t cmd)
+{
+    mSetPin(mDcPin, false);
+    mWrite(&cmd, sizeof(cmd));
+}
 
-    // Set reverse segment remap
-    setSegRemap(true);
+void SSD1306::writeCmds(const uint8_t* pCmds, const size_t size)
+{
+    mSetPin(mDcPin, false);
+    mWrite(pCmds, size);
+}
 
-    // Set mux ratio (height?) to 64 lines
-    setMuxRatio(63);
+void SSD1306::writeData(const uint8_t* pData, const size_t size)
+{
+    TRACE_SCOPE_ARG("SSD1306::writeData", size);
 
-    // Reverse COM dir
-    setComDir(false);
+    // No auto-increment across pages - address each page in turn
+    if(mProfile.isPageAddressing)
+    {
+        for(size_t page = 0; page < mHeight / 8 && page * mWidth < size; page++)
+        {
+            const size_t remaining = size - page * mWidth;
+            sendPage(page, 0, pData + page * mWidth,
+                        (remaining < mWidth) ? remaining : mWidth);
+        }
+    }
+    else
+    {
+        // Full frames assume the window covers the whole screen
+        if(mIsWindowed)
+        {
+            setColumnAddr(0, mWidth - 1);
+            setPageAddr(0, mHeight / 8 - 1);
+            mIsWindowed = false;
+        }
+
+        mSetPin(mDcPin, true);
+        mWrite(pData, size);
+    }
 
-    // Set display offset to first line
-    setDisplayOffset(0);
+    if(mpMirror != nullptr)
+    {
+        mpMirror->onFrame(pData, size);
+    }
+}
 
-    // Set COM pin config - alternative com pin, remap disabled
-    setComPinConfig(true, false);
+bool SSD1306::setColumnAddr(const uint8_t start, const uint8_t end)
+{
+    // Bounds check; page addressing controllers have no window
+    if(mProfile.isPageAddressing || start > end || end >= mWidth)
+    {
+        return false;
+    }
 
-    // Set oscillator frequency to 0x8, divide ratio to 0
-    setOscillator(0, 0x8);
+    const uint8_t cmds[] = {0x21, start, end};
+    writeCmds(cmds, sizeof(cmds));
 
-    // Set pre-charge period, 0x1 for phase 1, 0xF for phase 2
-    setPreChargePeriod(0x1, 0xF);
+    // writeData restores the whole screen before a full frame
+    if(start != 0 || end != mWidth - 1)
+    {
+        mIsWindowed = true;
+    }
+    return true;
+}
 
-    // Set VCOM deselect level to 0.83 x Vcc
-    setVcomDeselectLevel(0b11);
+bool SSD1306::setPageAddr(const uint8_t start, const uint8_t end)
+{
+    // Bounds check; page addressing controllers have no window
+    if(mProfile.isPageAddressing || start > end || end >= mHeight / 8)
+    {
+        return false;
+    }
 
-    // Set contrast
-    setContrast(0xFF);
+    const uint8_t cmds[] = {0x22, start, end};
+    writeCmds(cmds, sizeof(cmds));
 
-    // Display RAM
-    setMode(false);
+    // Any page range short of the screen needs resetting for writeData
+    if(start != 0 || end != mHeight / 8 - 1)
+    {
+        mIsWindowed = true;
+    }
+    return true;
+}
 
-    // Set normal (no invert)
-    setInvert(false);
-    
-    // Enable charge pump
-    enableChargePump(true);
+bool SSD1306::writePage
+(
+    const uint8_t page, 
+    const uint8_t col, 
+    const uint8_t* pData, 
+    const size_t size
+)
+{
+    TRACE_SCOPE_ARG("SSD1306::writePage", size);
 
-    // Turn display on
-    setDisplayOn(true);
+    if(size == 0 || col + size > mWidth)
+    {
+        return false;
+    }
+
+    if(page >= mHeight / 8)
+    {
+        return false;
+    }
+
+    sendPage(page, col, pData, size);
+
+    if(mpMirror != nullptr)
+    {
+        mpMirror->onPage(page, col, pData, size);
+    }
+
+    return true;
 }
 
-void SSD1306::writeCmd(const uint8_t cmd)
+bool SSD1306::writePages(const uint8_t firstPage, const uint8_t* pData, const size_t pageCount)
 {
-    mSetPin(mDcPin, false);
-    mWrite(&cmd, sizeof(cmd));
+    TRACE_SCOPE_ARG("SSD1306::writePages", pageCount);
+
+    if(pageCount == 0 || firstPage + pageCount > mHeight / 8)
+    {
+        return false;
+    }
+
+    if(mProfile.isPageAddressing)
+    {
+        for(size_t i = 0; i < pageCount; i++)
+        {
+            sendPage(firstPage + i, 0, pData + i * mWidth, mWidth);
+        }
+    }
+    else
+    {
+        // The window wraps from the end of each page to the next one
+        const uint8_t cmds[] =
+        {
+            0x21, 0, static_cast<uint8_t>(mWidth - 1),
+            0x22, firstPage, static_cast<uint8_t>(firstPage + pageCount - 1)
+        };
+        writeCmds(cmds, sizeof(cmds));
+        mIsWindowed = (pageCount != mHeight / 8);
+
+        mSetPin(mDcPin, true);
+        mWrite(pData, pageCount * mWidth);
+    }
+
+    if(mpMirror != nullptr)
+    {
+        for(size_t i = 0; i < pageCount; i++)
+        {
+            mpMirror->onPage(firstPage + i, 0, pData + i * mWidth, mWidth);
+        }
+    }
+
+    return true;
 }
 
-void SSD1306::writeData(const uint8_t* pData, const size_t size)
+void SSD1306::sendPage
+(
+    const uint8_t page, 
+    const uint8_t col, 
+    const uint8_t* pData, 
+    const size_t size
+)
 {
+    if(mProfile.isPageAddressing)
+    {
+        // Page start address plus column start address low/high nibbles
+        const uint8_t ramCol = col + mProfile.colOffset;
+        const uint8_t cmds[] = 
+        {
+            static_cast<uint8_t>(0xB0 | page), 
+            static_cast<uint8_t>(ramCol & 0x0F), 
+            static_cast<uint8_t>(0x10 | (ramCol >> 4))
+        };
+        writeCmds(cmds, sizeof(cmds));
+    }
+    else
+    {
+        // A single page window makes every address mode step column by column
+        const uint8_t cmds[] = 
+        {
+            0x21, col, static_cast<uint8_t>(col + size - 1),
+            0x22, page, page
+        };
+        writeCmds(cmds, sizeof(cmds));
+        mIsWindowed = true;
+    }
+
     mSetPin(mDcPin, true);
     mWrite(pData, size);
 }
 
 void SSD1306::setDisplayOn(const bool isOn)
 {
+    if(isCached(CACHE_DISPLAY_ON) && mIsDisplayOn == isOn)
+    {
+        return;
+    }
+
     uint8_t displayCmd = 0xAE;
     displayCmd |= (isOn) ? 0b1 : 0;
     
     writeCmd(displayCmd);
+
+    mIsDisplayOn = isOn;
+    mCacheValid |= CACHE_DISPLAY_ON;
 }
 
 void SSD1306::setMode(const bool isTest)
@@ -109,6 +296,9 @@ void SSD1306::reset()
     mSetPin(mResetPin, false);
     mDelayMs(1);
     mSetPin(mResetPin, true);
+
+    // Controller is back to its defaults; don't trust the shadow copy
+    invalidateCache();
 }
 
 bool SSD1306::setMemAddrMode(const uint8_t mode)
@@ -119,8 +309,8 @@ bool SSD1306::setMemAddrMode(const uint8_t mode)
         return false;
     }
 
-    writeCmd(0x20);
-    writeCmd(mode);
+    const uint8_t cmds[] = {0x20, mode};
+    writeCmds(cmds, sizeof(cmds));
 
     return true;
 }   
@@ -133,8 +323,16 @@ bool SSD1306::setStartLine(const uint8_t line)
         return false;
     }
 
+    if(isCached(CACHE_START_LINE) && mStartLine == line)
+    {
+        return true;
+    }
+
     uint8_t startCmd = 0b100'0000 | line;
     writeCmd(startCmd);
+
+    mStartLine = line;
+    mCacheValid |= CACHE_START_LINE;
     return true;
 }
 
@@ -153,8 +351,8 @@ bool SSD1306::setMuxRatio(const uint8_t ratio)
         return false;
     }
 
-    writeCmd(0xA8);
-    writeCmd(ratio);
+    const uint8_t cmds[] = {0xA8, ratio};
+    writeCmds(cmds, sizeof(cmds));
     return true;
 }
 
@@ -172,8 +370,16 @@ bool SSD1306::setDisplayOffset(const uint8_t offset)
         return false;
     }
 
-    writeCmd(0xD3);
-    writeCmd(offset);
+    if(isCached(CACHE_DISPLAY_OFFSET) && mDisplayOffset == offset)
+    {
+        return true;
+    }
+
+    const uint8_t cmds[] = {0xD3, offset};
+    writeCmds(cmds, sizeof(cmds));
+
+    mDisplayOffset = offset;
+    mCacheValid |= CACHE_DISPLAY_OFFSET;
     return true;
 }
 
@@ -182,8 +388,8 @@ void SSD1306::setComPinConfig(const bool isAlternative, const bool enableRemap)
     uint8_t config = 0b10;
     config |= (isAlternative) ? 0b1'0000 : 0;
     config |= (enableRemap) ? 0b10'0000 : 0;
-    writeCmd(0xDA);
-    writeCmd(config);
+    const uint8_t cmds[] = {0xDA, config};
+    writeCmds(cmds, sizeof(cmds));
 }
 
 bool SSD1306::setOscillator(const uint8_t divRatio, const uint8_t freq)
@@ -194,8 +400,8 @@ bool SSD1306::setOscillator(const uint8_t divRatio, const uint8_t freq)
     }
 
     uint8_t data = (freq << 4) | divRatio;
-    writeCmd(0xD5);
-    writeCmd(data);
+    const uint8_t cmds[] = {0xD5, data};
+    writeCmds(cmds, sizeof(cmds));
     return true;
 }
 
@@ -211,8 +417,8 @@ bool SSD1306::setPreChargePeriod
     }
 
     uint8_t data = (phase2Period << 4) | phase1Period;
-    writeCmd(0xD9);
-    writeCmd(data);
+    const uint8_t cmds[] = {0xD9, data};
+    writeCmds(cmds, sizeof(cmds));
     return true;
 }
 
@@ -223,28 +429,44 @@ bool SSD1306::setVcomDeselectLevel(const uint8_t level)
         return false;
     }
 
-    writeCmd(0xDB);
-    writeCmd(level << 4);
+    const uint8_t cmds[] = {0xDB, static_cast<uint8_t>(level << 4)};
+    writeCmds(cmds, sizeof(cmds));
     return true;
 }
 
 void SSD1306::setContrast(const uint8_t level)
 {
-    writeCmd(0x81);
-    writeCmd(level);
+    if(isCached(CACHE_CONTRAST) && mContrast == level)
+    {
+        return;
+    }
+
+    const uint8_t cmds[] = {0x81, level};
+    writeCmds(cmds, sizeof(cmds));
+
+    mContrast = level;
+    mCacheValid |= CACHE_CONTRAST;
 }
 
 void SSD1306::setInvert(const bool isInverted)
 {
+    if(isCached(CACHE_INVERT) && mIsInverted == isInverted)
+    {
+        return;
+    }
+
     uint8_t cmd = 0xA6; 
     cmd |= (isInverted) ? 0b1 : 0;
     writeCmd(cmd);
+
+    mIsInverted = isInverted;
+    mCacheValid |= CACHE_INVERT;
 }
 
 void SSD1306::enableChargePump(const bool isEnabled)
 {
     uint8_t data = 0b1'0000;
     data |= (isEnabled) ? 0b100 : 0;
-    writeCmd(0x8D);
-    writeCmd(data);
+    const uint8_t cmds[] = {0x8D, data};
+    writeCmds(cmds, sizeof(cmds));
 }
\ No newline at end of file
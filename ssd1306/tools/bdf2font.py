@@ -0,0 +1,289 @@
+#!/usr/bin/env python3
+"""
+Compile a BDF bitmap font into packed flash tables (see packedFont.hpp).
+
+Writes NAME.hpp, declaring `extern const Font fonts::SYMBOL`, and NAME.cpp
+with the code point ranges, glyph table and column-major bitmaps.
+Normally run by ssd1306_add_font in the ssd1306 CMakeLists.txt.
+
+By default every glyph in the file is kept.  Giving any of --chars,
+--chars-file or --range keeps only those code points (plus the font's
+DEFAULT_CHAR), so a product ships just the glyphs its strings use.
+Requested code points the font lacks are reported on stderr.
+
+Code points without a glyph are drawn as the fallback glyph: DEFAULT_CHAR,
+else U+FFFD, else '?', else the first glyph.
+
+PCF fonts can be converted to BDF first with pcf2bdf.
+
+Usage: bdf2font.py FONT.bdf --name NAME [--symbol SYMBOL] [--out-dir DIR]
+                   [--chars TEXT]... [--chars-file FILE]...
+                   [--range FIRST-LAST]... [--spacing N]
+
+  --name NAME         output file stem
+  --symbol SYMBOL     variable name in namespace fonts (default NAME upper
+                      cased)
+  --out-dir DIR       where to write the files (default .)
+  --chars TEXT        keep the characters of TEXT
+  --chars-file FILE   keep the characters used in a UTF-8 file (strings
+                      table, translations)
+  --range FIRST-LAST  keep a range of code points, e.g. 0x20-0x7E or 0x410
+  --spacing N         make the font proportional: each glyph advances by
+                      its own width plus N instead of by its DWIDTH
+"""
+
+import argparse
+import os
+import sys
+
+# Framebuffer draws a column of up to 32 rows at once
+MAX_HEIGHT = 32
+
+
+class BdfGlyph:
+    def __init__(self):
+        self.codepoint = -1
+        self.advance = 0
+        self.width = 0
+        self.height = 0
+        self.xOffset = 0
+        self.yOffset = 0
+        self.rows = []
+
+
+def parseBdf(path):
+    """
+    Return (properties, glyphs); rows are ints, leftmost pixel in the
+    highest bit of the row's bytes.
+    """
+    properties = {}
+    glyphs = []
+    fontAdvance = 0
+    glyph = None
+    inBitmap = False
+
+    with open(path, encoding="latin-1") as file:
+        for number, line in enumerate(file, 1):
+            words = line.split()
+            if not words:
+                continue
+
+            key = words[0]
+
+            if inBitmap:
+                if key == "ENDCHAR":
+                    inBitmap = False
+                    glyphs.append(glyph)
+                    glyph = None
+                else:
+                    glyph.rows.append(int(key, 16))
+                continue
+
+            try:
+                if key == "FONTBOUNDINGBOX":
+                    properties.setdefault("BBX", [int(w) for w in words[1:5]])
+                elif key in ("FONT_ASCENT", "FONT_DESCENT", "DEFAULT_CHAR"):
+                    properties[key] = int(words[1])
+                elif key == "DWIDTH" and glyph is None:
+                    fontAdvance = int(words[1])
+                elif key == "STARTCHAR":
+                    glyph = BdfGlyph()
+                    glyph.advance = fontAdvance
+                elif key == "ENCODING":
+                    # ENCODING -1 n gives a code point in another encoding
+                    glyph.codepoint = int(words[1])
+                elif key == "DWIDTH":
+                    glyph.advance = int(words[1])
+                elif key == "BBX":
+                    glyph.width, glyph.height, glyph.xOffset, glyph.yOffset = \
+                        [int(w) for w in words[1:5]]
+                elif key == "BITMAP":
+                    inBitmap = True
+            except (ValueError, IndexError, AttributeError):
+                sys.exit(f"{path}:{number}: bad {key} line")
+
+    if "BBX" not in properties:
+        sys.exit(f"{path}: no FONTBOUNDINGBOX")
+
+    # Ascent and descent fall back to the font bounding box
+    bbx = properties["BBX"]
+    properties.setdefault("FONT_DESCENT", max(0, -bbx[3]))
+    properties.setdefault("FONT_ASCENT", bbx[1] + bbx[3])
+
+    return properties, [g for g in glyphs if g.codepoint >= 0]
+
+
+def parseRange(text):
+    first, _, last = text.partition("-")
+    first = int(first, 0)
+    last = int(last, 0) if last else first
+    if last < first:
+        sys.exit(f"bad range {text}")
+    return range(first, last + 1)
+
+
+def packColumns(glyph):
+    """
+    Column-major, (height + 7) / 8 bytes per column, bit 0 of the first
+    byte is the bottom row.
+    """
+    rowBits = ((glyph.width + 7) // 8) * 8
+    packed = bytearray()
+
+    for col in range(glyph.width):
+        bits = 0
+        for row in range(glyph.height):
+            line = glyph.rows[glyph.height - 1 - row] if glyph.height - 1 - row < len(glyph.rows) else 0
+            if line & (1 << (rowBits - 1 - col)):
+                bits |= 1 << row
+
+        for i in range((glyph.height + 7) // 8):
+            packed.append((bits >> (i * 8)) & 0xFF)
+
+    return bytes(packed)
+
+
+def describe(codepoint):
+    if 0x20 < codepoint < 0x7F and codepoint != 0x5C:
+        return f"'{chr(codepoint)}'"
+    return f"U+{codepoint:04X}"
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Compile a BDF font to packed tables")
+    parser.add_argument("bdf")
+    parser.add_argument("--name", required=True)
+    parser.add_argument("--symbol")
+    parser.add_argument("--out-dir", default=".")
+    parser.add_argument("--chars", action="append", default=[])
+    parser.add_argument("--chars-file", action="append", default=[])
+    parser.add_argument("--range", action="append", default=[])
+    parser.add_argument("--spacing", type=int)
+    args = parser.parse_args()
+
+    symbol = args.symbol or args.name.upper()
+    properties, glyphs = parseBdf(args.bdf)
+    ascent = properties["FONT_ASCENT"]
+    descent = properties["FONT_DESCENT"]
+
+    # Code points to keep; None keeps them all
+    wanted = None
+    if args.chars or args.chars_file or args.range:
+        wanted = set()
+        for text in args.chars:
+            wanted.update(ord(c) for c in text)
+        for path in args.chars_file:
+            with open(path, encoding="utf-8") as file:
+                wanted.update(ord(c) for c in file.read() if c not in "\r\n\t")
+        for text in args.range:
+            wanted.update(parseRange(text))
+        if "DEFAULT_CHAR" in properties:
+            wanted.add(properties["DEFAULT_CHAR"])
+
+    byCodepoint = {}
+    for glyph in glyphs:
+        if wanted is None or glyph.codepoint in wanted:
+            byCodepoint[glyph.codepoint] = glyph
+
+    if wanted is not None:
+        missing = sorted(wanted - byCodepoint.keys())
+        if missing:
+            print(f"{args.bdf}: no glyph for " + " ".join(describe(c) for c in missing),
+                  file=sys.stderr)
+
+    if not byCodepoint:
+        sys.exit(f"{args.bdf}: no glyphs selected")
+
+    # Identical bitmaps (blanks, look-alikes across scripts) are kept once
+    bitmap = bytearray()
+    offsets = {}
+    entries = []
+
+    for codepoint in sorted(byCodepoint):
+        glyph = byCodepoint[codepoint]
+
+        if glyph.height > MAX_HEIGHT or glyph.width > 255:
+            sys.exit(f"{args.bdf}: {describe(codepoint)} is {glyph.width}x{glyph.height}, "
+                     f"glyphs are limited to 255x{MAX_HEIGHT}")
+
+        if args.spacing is not None:
+            glyph.advance = max(0, glyph.xOffset + glyph.width + args.spacing)
+
+        yOffset = glyph.yOffset + descent
+        if not (-128 <= glyph.xOffset < 128 and -128 <= yOffset < 128 and 0 <= glyph.advance < 256):
+            sys.exit(f"{args.bdf}: {describe(codepoint)} metrics out of range")
+
+        packed = packColumns(glyph)
+        if packed not in offsets:
+            offsets[packed] = len(bitmap)
+            bitmap += packed
+
+        entries.append((codepoint, offsets[packed], glyph.width, glyph.height,
+                        glyph.xOffset, yOffset, glyph.advance))
+
+    # Runs of consecutive code points: [first, count, first glyph]
+    ranges = []
+    for index, entry in enumerate(entries):
+        if ranges and ranges[-1][0] + ranges[-1][1] == entry[0] and ranges[-1][1] < 0xFFFF:
+            ranges[-1][1] += 1
+        else:
+            ranges.append([entry[0], 1, index])
+
+    # Printable ASCII first, so it is found without a search
+    for index, run in enumerate(ranges):
+        if run[0] <= 0x41 < run[0] + run[1]:
+            ranges.insert(0, ranges.pop(index))
+            ranges[1:] = sorted(ranges[1:])
+            break
+
+    codepoints = [entry[0] for entry in entries]
+    fallback = 0
+    for candidate in (properties.get("DEFAULT_CHAR"), 0xFFFD, ord("?")):
+        if candidate in codepoints:
+            fallback = codepoints.index(candidate)
+            break
+
+    os.makedirs(args.out_dir, exist_ok=True)
+    source = os.path.basename(args.bdf)
+
+    with open(os.path.join(args.out_dir, args.name + ".hpp"), "w") as file:
+        file.write(f"// Generated by bdf2font.py from {source}; do not edit.\n")
+        file.write("#pragma once\n\n")
+        file.write("#include \"packedFont.hpp\"\n\n")
+        file.write("namespace fonts\n{\n\n")
+        file.write(f"/// {source}: {len(entries)} glyphs in {len(ranges)} ranges, "
+                   f"{len(bitmap)} bitmap bytes\n")
+        file.write(f"extern const Font {symbol};\n\n")
+        file.write("} // End namespace fonts\n")
+
+    with open(os.path.join(args.out_dir, args.name + ".cpp"), "w") as file:
+        file.write(f"// Generated by bdf2font.py from {source}; do not edit.\n")
+        file.write(f"#include \"{args.name}.hpp\"\n\n")
+        file.write("namespace\n{\n\n")
+
+        file.write("const uint8_t BITMAP[] =\n{\n")
+        for i in range(0, len(bitmap), 16):
+            file.write("    " + ", ".join(f"0x{b:02X}" for b in bitmap[i:i + 16]) + ",\n")
+        file.write("};\n\n")
+
+        file.write("const Glyph GLYPHS[] =\n{\n")
+        for entry in entries:
+            file.write("    {{ {}, {}, {}, {}, {}, {} }}, // {}\n".format(
+                *entry[1:], describe(entry[0])))
+        file.write("};\n\n")
+
+        file.write("const GlyphRange RANGES[] =\n{\n")
+        for run in ranges:
+            file.write("    {{ 0x{:04X}, {}, {} }},\n".format(*run))
+        file.write("};\n\n")
+
+        file.write("} // End anonymous namespace\n\n")
+        file.write("namespace fonts\n{\n\n")
+        file.write(f"const Font {symbol} =\n")
+        file.write(f"{{ \"{args.name}\", GLYPHS, {len(entries)}, RANGES, {len(ranges)}, {fallback}, "
+                   f"BITMAP, {ascent + descent}, {ascent} }};\n\n")
+        file.write("} // End namespace fonts\n")
+
+
+if __name__ == "__main__":
+    main()
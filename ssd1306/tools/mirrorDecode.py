@@ -0,0 +1,265 @@
+#!/usr/bin/env python3
+"""
+Rebuild the frames a FrameMirror streams and save them as images or video.
+
+Reads a capture file, a pipe (-) or a serial port.  Other output mixed into
+the stream (printf text) is skipped; packets are found by their magic and
+checked by their checksum.  Deltas after a lost packet are ignored until
+the next keyframe.
+
+Usage: mirrorDecode.py SOURCE [--pbm DIR] [--video OUT.mp4] [--fps N]
+                              [--scale N]
+
+  --pbm DIR       write every frame as DIR/frame_NNNNN.pbm
+  --video OUT     write a video with ffmpeg, frames held for their real
+                  duration (packet timestamps)
+  --fps N         video frame rate (default 30)
+  --scale N       video pixel size (default 4)
+"""
+
+import argparse
+import os
+import subprocess
+import sys
+
+MAGIC = b"\xa5M"
+HEADER_SIZE = 16
+TRAILER_SIZE = 2
+TYPE_KEYFRAME = 1
+TYPE_DELTA = 2
+
+
+def fletcher16(data):
+    sum1 = 0
+    sum2 = 0
+    for byte in data:
+        sum1 = (sum1 + byte) % 255
+        sum2 = (sum2 + sum1) % 255
+    return (sum2 << 8) | sum1
+
+
+def unpackRuns(payload, size):
+    """
+    Undo the PackBits style runs; None if they don't make size bytes
+    """
+    out = bytearray()
+    i = 0
+
+    while i < len(payload):
+        control = payload[i]
+        i += 1
+        if control < 128:
+            out += payload[i:i + control + 1]
+            i += control + 1
+        else:
+            out += bytes([payload[i]]) * (control - 125)
+            i += 1
+
+    return bytes(out) if len(out) == size else None
+
+
+class Decoder:
+    """
+    Feed bytes in, get (time ms, width, height, page-major frame) out
+    """
+
+    def __init__(self):
+        self.buf = bytearray()
+        self.frame = None
+        self.seq = None
+        self.packets = 0
+        self.bad = 0
+        self.skipped = 0
+
+    def feed(self, data):
+        self.buf += data
+        frames = []
+
+        while True:
+            start = self.buf.find(MAGIC)
+            if start < 0:
+                del self.buf[:max(0, len(self.buf) - 1)]
+                return frames
+
+            del self.buf[:start]
+            if len(self.buf) < HEADER_SIZE:
+                return frames
+
+            header = self.buf[:HEADER_SIZE]
+            payloadSize = int.from_bytes(header[14:16], "little")
+            size = HEADER_SIZE + payloadSize + TRAILER_SIZE
+            if len(self.buf) < size:
+                return frames
+
+            packet = bytes(self.buf[:size])
+            check = int.from_bytes(packet[-2:], "little")
+            if check != fletcher16(packet[2:-2]):
+                # Not a packet after all; look past this magic
+                self.bad += 1
+                del self.buf[:1]
+                continue
+
+            del self.buf[:size]
+            frame = self.apply(packet)
+            if frame is not None:
+                frames.append(frame)
+
+    def apply(self, packet):
+        kind = packet[2]
+        seq = int.from_bytes(packet[4:6], "little")
+        time = int.from_bytes(packet[6:10], "little")
+        width = int.from_bytes(packet[10:12], "little")
+        height = int.from_bytes(packet[12:14], "little")
+        data = unpackRuns(packet[HEADER_SIZE:-TRAILER_SIZE], width * height // 8)
+
+        self.packets += 1
+        isInSequence = self.seq is not None and seq == (self.seq + 1) & 0xFFFF
+        self.seq = seq
+
+        if data is None:
+            self.bad += 1
+            self.frame = None
+            return None
+
+        if kind == TYPE_KEYFRAME:
+            self.frame = data
+        elif kind == TYPE_DELTA and self.frame is not None and isInSequence \
+                and len(self.frame) == len(data):
+            self.frame = bytes(a ^ b for a, b in zip(self.frame, data))
+        else:
+            # Wait for a keyframe
+            self.skipped += 1
+            self.frame = None
+            return None
+
+        return (time, width, height, self.frame)
+
+
+def pixel(frame, width, x, y):
+    return (frame[(y // 8) * width + x] >> (y % 8)) & 1
+
+
+def writePbm(path, width, height, frame):
+    rowBytes = (width + 7) // 8
+    out = bytearray(b"P4\n%d %d\n" % (width, height))
+
+    for y in range(height):
+        row = bytearray(rowBytes)
+        for x in range(width):
+            if pixel(frame, width, x, y):
+                row[x // 8] |= 0x80 >> (x % 8)
+        out += row
+
+    with open(path, "wb") as file:
+        file.write(out)
+
+
+def grayImage(width, height, frame, scale):
+    out = bytearray()
+
+    for y in range(height):
+        row = bytearray()
+        for x in range(width):
+            row += (b"\xff" if pixel(frame, width, x, y) else b"\x00") * scale
+        out += bytes(row) * scale
+
+    return bytes(out)
+
+
+class VideoWriter:
+    """
+    Pipe frames to ffmpeg at a fixed rate, repeating each one until the next
+    """
+
+    def __init__(self, path, fps, scale):
+        self.path = path
+        self.fps = fps
+        self.scale = scale
+        self.proc = None
+        self.last = None
+        self.start = None
+        self.written = 0
+
+    def add(self, time, width, height, frame):
+        if self.proc is None:
+            self.proc = subprocess.Popen(
+                ["ffmpeg", "-loglevel", "error", "-y", "-f", "rawvideo", "-pix_fmt", "gray",
+                 "-s", "%dx%d" % (width * self.scale, height * self.scale), "-r", str(self.fps),
+                 "-i", "-", "-pix_fmt", "yuv420p", self.path],
+                stdin=subprocess.PIPE)
+            self.start = time
+
+        # Hold the previous frame until this one's time
+        if self.last is not None:
+            due = (time - self.start) * self.fps // 1000
+            while self.written < due:
+                self.proc.stdin.write(self.last)
+                self.written += 1
+
+        self.last = grayImage(width, height, frame, self.scale)
+
+    def close(self):
+        if self.proc is not None:
+            self.proc.stdin.write(self.last)
+            self.proc.stdin.close()
+            self.proc.wait()
+
+
+def openSource(source):
+    if source == "-":
+        return sys.stdin.buffer
+
+    if source.startswith("/dev/") or source.upper().startswith("COM"):
+        try:
+            import serial
+            return serial.Serial(source, 115200, timeout=0.1)
+        except ImportError:
+            pass
+
+    return open(source, "rb")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Rebuild FrameMirror frames")
+    parser.add_argument("source")
+    parser.add_argument("--pbm")
+    parser.add_argument("--video")
+    parser.add_argument("--fps", type=int, default=30)
+    parser.add_argument("--scale", type=int, default=4)
+    args = parser.parse_args()
+
+    if args.pbm:
+        os.makedirs(args.pbm, exist_ok=True)
+
+    video = VideoWriter(args.video, args.fps, args.scale) if args.video else None
+    decoder = Decoder()
+    source = openSource(args.source)
+    count = 0
+
+    try:
+        while True:
+            data = source.read(4096)
+            if not data:
+                if hasattr(source, "in_waiting"):
+                    continue
+                break
+
+            for time, width, height, frame in decoder.feed(data):
+                if args.pbm:
+                    writePbm(os.path.join(args.pbm, "frame_%05d.pbm" % count), width, height, frame)
+                if video:
+                    video.add(time, width, height, frame)
+                count += 1
+    except KeyboardInterrupt:
+        pass
+    finally:
+        if video:
+            video.close()
+
+    print("%d frames from %d packets, %d bad, %d skipped waiting for a keyframe"
+          % (count, decoder.packets, decoder.bad, decoder.skipped), file=sys.stderr)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
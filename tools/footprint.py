@@ -0,0 +1,230 @@
+#!/usr/bin/env python3
+"""
+Report the flash, RAM and static initialization cost of the driver
+libraries, object file by object file.
+
+Reads the ELF object files of each library (the `footprint` build target
+passes them) and sums their sections:
+
+    flash   code, constants, initial values of .data, init tables
+    RAM     .data, .bss and code copied to RAM (.time_critical)
+    init    static constructors: .init_array/.ctors entries and the bytes
+            of the functions they call (_GLOBAL__sub_I_*), which run
+            before main
+
+It also lists what each object pulls in from the C++ runtime: heap
+(operator new/delete, malloc), exceptions (throw, unwinding), RTTI
+(type_info), static destructors (atexit) and thread-safe static guards.
+
+With --strict any static constructor or runtime support fails the
+report, as for -DRP_PICO_DRIVERS_STATIC=ON.  --budget LIB:FLASH:RAM
+fails it if a library goes over, so size creep shows up in the build.
+
+Sizes are before linking: --gc-sections drops functions the firmware
+doesn't call, so a product's real cost is at most what is shown.
+
+Usage: footprint.py [--strict] [--budget LIB:FLASH:RAM]...
+                    --lib NAME OBJ... [--lib NAME OBJ...]...
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+
+SHT_SYMTAB = 2
+SHT_NOBITS = 8
+SHT_INIT_ARRAY = 14
+SHT_PREINIT_ARRAY = 16
+
+SHF_WRITE = 0x1
+SHF_ALLOC = 0x2
+
+# Undefined or defined symbols showing C++ runtime support, by kind
+RUNTIME = [
+    ("heap", re.compile(r"^(_Znw|_Zna|_Zdl|_Zda|malloc$|calloc$|realloc$|free$)")),
+    ("exceptions", re.compile(r"^(__cxa_throw|__cxa_allocate_exception|__cxa_begin_catch"
+                              r"|__gxx_personality|_Unwind_|__aeabi_unwind_cpp_pr[1-9]|_ZSt\d+__throw_)")),
+    ("rtti", re.compile(r"^(_ZTI|_ZTS|__dynamic_cast)")),
+    ("atexit", re.compile(r"^(__cxa_atexit|__aeabi_atexit|atexit$)")),
+    ("guard", re.compile(r"^__cxa_guard_")),
+]
+
+
+class Elf:
+    """
+    Sections and symbols of a relocatable ELF file
+    """
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            self.data = f.read()
+
+        if self.data[:4] != b"\x7fELF":
+            raise ValueError("%s: not an ELF file" % path)
+
+        self.is64 = self.data[4] == 2
+        self.endian = "<" if self.data[5] == 1 else ">"
+        self.pointerSize = 8 if self.is64 else 4
+
+        if self.is64:
+            shoff, = self.unpack("Q", 0x28)
+            shentsize, shnum, shstrndx = self.unpack("HHH", 0x3A)
+        else:
+            shoff, = self.unpack("I", 0x20)
+            shentsize, shnum, shstrndx = self.unpack("HHH", 0x2E)
+
+        self.sections = [self.readSection(shoff + i * shentsize) for i in range(shnum)]
+
+        names = self.sections[shstrndx]
+        for section in self.sections:
+            section["name"] = self.string(names["offset"], section["nameIndex"])
+
+    def unpack(self, fmt, offset):
+        return struct.unpack_from(self.endian + fmt, self.data, offset)
+
+    def string(self, base, index):
+        end = self.data.index(b"\0", base + index)
+        return self.data[base + index:end].decode("ascii", "replace")
+
+    def readSection(self, offset):
+        if self.is64:
+            name, kind, flags, _, fileOffset, size, link, _, _, entsize = \
+                self.unpack("IIQQQQIIQQ", offset)
+        else:
+            name, kind, flags, _, fileOffset, size, link, _, _, entsize = \
+                self.unpack("IIIIIIIIII", offset)
+
+        return {"nameIndex": name, "type": kind, "flags": flags, "offset": fileOffset,
+                "size": size, "link": link, "entsize": entsize}
+
+    def symbols(self):
+        """
+        Yield (name, size, section index) of every named symbol
+        """
+        for section in self.sections:
+            if section["type"] != SHT_SYMTAB:
+                continue
+
+            strtab = self.sections[section["link"]]["offset"]
+            for i in range(1, section["size"] // section["entsize"]):
+                offset = section["offset"] + i * section["entsize"]
+                if self.is64:
+                    name, _, _, shndx, _, size = self.unpack("IBBHQQ", offset)
+                else:
+                    name, _, size, _, _, shndx = self.unpack("IIIBBH", offset)
+
+                if name != 0:
+                    yield self.string(strtab, name), size, shndx
+
+
+def measure(path):
+    """
+    Flash, RAM and init cost of one object file, and the runtime support
+    it uses
+    """
+    elf = Elf(path)
+    cost = {"flash": 0, "ram": 0, "initEntries": 0, "initBytes": 0, "runtime": set()}
+
+    for section in elf.sections:
+        name = section["name"]
+        isInit = section["type"] in (SHT_INIT_ARRAY, SHT_PREINIT_ARRAY) or \
+            name.startswith(".ctors") or name.startswith(".init_array")
+
+        if isInit:
+            cost["initEntries"] += section["size"] // elf.pointerSize
+            cost["flash"] += section["size"]
+            continue
+
+        if not section["flags"] & SHF_ALLOC:
+            continue
+
+        if section["type"] != SHT_NOBITS:
+            cost["flash"] += section["size"]
+
+        if section["flags"] & SHF_WRITE or name.startswith(".time_critical"):
+            cost["ram"] += section["size"]
+
+    for name, size, _ in elf.symbols():
+        if name.startswith("_GLOBAL__sub_I_"):
+            cost["initBytes"] += size
+
+        for kind, pattern in RUNTIME:
+            if pattern.match(name):
+                cost["runtime"].add(kind)
+
+    return cost
+
+
+def parseBudget(text):
+    try:
+        lib, flash, ram = text.split(":")
+        return lib, int(flash, 0), int(ram, 0)
+    except ValueError:
+        raise argparse.ArgumentTypeError("expected LIB:FLASH:RAM, got %r" % text)
+
+
+def objectName(path):
+    """
+    Source name of an object file (framebuffer.cpp.obj -> framebuffer.cpp)
+    """
+    name = os.path.basename(path)
+    for suffix in (".obj", ".o"):
+        if name.endswith(suffix):
+            return name[:-len(suffix)]
+    return name
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Report flash, RAM and static init cost")
+    parser.add_argument("--lib", nargs="+", action="append", required=True,
+                        metavar=("NAME", "OBJ"), help="library name and its object files")
+    parser.add_argument("--budget", type=parseBudget, action="append", default=[],
+                        metavar="LIB:FLASH:RAM", help="fail if a library is over")
+    parser.add_argument("--strict", action="store_true",
+                        help="fail on static constructors or C++ runtime support")
+    args = parser.parse_args()
+
+    budgets = {lib: (flash, ram) for lib, flash, ram in args.budget}
+    failures = []
+
+    row = "%-28s %8s %8s %6s %8s  %s"
+    print(row % ("component", "flash", "ram", "init", "init B", "runtime"))
+
+    for lib in args.lib:
+        name, objects = lib[0], [path for path in lib[1:] if path]
+        total = {"flash": 0, "ram": 0, "initEntries": 0, "initBytes": 0, "runtime": set()}
+
+        print()
+        for path in sorted(objects, key=objectName):
+            cost = measure(path)
+            print(row % ("  " + objectName(path), cost["flash"], cost["ram"], cost["initEntries"],
+                         cost["initBytes"], " ".join(sorted(cost["runtime"]))))
+
+            for key in ("flash", "ram", "initEntries", "initBytes"):
+                total[key] += cost[key]
+            total["runtime"] |= cost["runtime"]
+
+            if args.strict and (cost["initEntries"] or cost["runtime"]):
+                failures.append("%s/%s: static constructors or runtime support (%s)" %
+                                (name, objectName(path), " ".join(sorted(cost["runtime"])) or "init"))
+
+        print(row % (name, total["flash"], total["ram"], total["initEntries"],
+                     total["initBytes"], " ".join(sorted(total["runtime"]))))
+
+        if name in budgets:
+            flash, ram = budgets[name]
+            if total["flash"] > flash:
+                failures.append("%s: flash %d over budget %d" % (name, total["flash"], flash))
+            if total["ram"] > ram:
+                failures.append("%s: RAM %d over budget %d" % (name, total["ram"], ram))
+
+    for failure in failures:
+        print("footprint: " + failure, file=sys.stderr)
+
+    return 1 if failures else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,197 @@
+#pragma once
+
+#include <cstdint>
+
+#ifdef RP_TRACE
+#include <hardware/structs/timer.h>
+#include <hardware/sync.h>
+#include <pico/platform.h>
+#endif
+
+/// Events kept per core; a power of 2
+#ifndef RP_TRACE_EVENTS
+#define RP_TRACE_EVENTS 512
+#endif
+
+/**
+ * @brief Timestamped begin/end events from the drivers, for finding where
+ *        the time goes.
+ *
+ * Built in only when RP_TRACE is defined (CMake option
+ * RP_PICO_DRIVERS_TRACE); otherwise the TRACE_ macros are empty and cost
+ * nothing.
+ *
+ * Each core writes its own ring of RP_TRACE_EVENTS events, so the cores
+ * never contend; interrupts are masked for the few instructions of a
+ * record so an interrupt handler tracing on the same core can't split
+ * one.  Full rings overwrite their oldest events.  Timestamps are the
+ * 1MHz timer, read from TIMERAWL (wraps every 71 minutes).
+ *
+ * Names must be string literals or otherwise outlive the trace; only the
+ * pointer is stored.
+ *
+ * dump prints the rings as text, which trace/tools/trace2chrome.py turns
+ * into Chrome trace JSON (chrome://tracing, ui.perfetto.dev).
+ */
+class Trace
+{
+public:
+
+    /**
+     * @brief Kind of event
+     */
+    enum class Phase : uint8_t
+    {
+        /// Start of a span
+        Begin = 'B',
+        /// End of a span
+        End = 'E',
+        /// Single point
+        Instant = 'I'
+    };
+
+    /**
+     * @brief One recorded event
+     */
+    struct Event
+    {
+        /// Timer (us)
+        uint32_t time;
+        /// Name
+        const char* pName;
+        /// User value
+        uint16_t arg;
+        /// Kind of event
+        Phase phase;
+    };
+
+    /// Events kept per core
+    static constexpr uint32_t EVENTS = RP_TRACE_EVENTS;
+    static_assert((EVENTS & (EVENTS - 1)) == 0, "RP_TRACE_EVENTS must be a power of 2");
+
+#ifdef RP_TRACE
+
+    /**
+     * @brief Record an event on the calling core
+     *
+     * @param pName - Name
+     * @param phase - Kind of event
+     * @param arg - User value
+     */
+    static inline void record(const char* pName, const Phase phase, const uint16_t arg = 0)
+    {
+        if(!sIsEnabled)
+        {
+            return;
+        }
+
+        const uint32_t status = save_and_disable_interrupts();
+
+        const uint core = get_core_num();
+        const uint32_t head = sHead[core];
+        Event& event = sEvents[core][head & (EVENTS - 1)];
+
+        event.time = timer_hw->timerawl;
+        event.pName = pName;
+        event.arg = arg;
+        event.phase = phase;
+        sHead[core] = head + 1;
+
+        restore_interrupts(status);
+    }
+
+    /**
+     * @brief Pause or resume recording on both cores
+     *
+     * @param isEnabled - If true record, if false ignore events
+     */
+    static void setEnabled(const bool isEnabled)
+    { sIsEnabled = isEnabled; }
+
+    /**
+     * @brief Discard every event
+     */
+    static void clear();
+
+    /**
+     * @brief Print every event with printf, oldest first per core
+     *
+     * Recording is paused while printing.  Format, one event per line:
+     *
+     *     # rp_trace 1
+     *     <core> <time us> <B|E|I> <arg> <name>
+     *     # lost <events overwritten>
+     */
+    static void dump();
+
+private:
+
+    /// Events of each core
+    static Event sEvents[NUM_CORES][EVENTS];
+    /// Events ever recorded by each core; next slot is head % EVENTS
+    static volatile uint32_t sHead[NUM_CORES];
+    /// True while recording
+    static volatile bool sIsEnabled;
+
+#else
+
+    static inline void record(const char*, const Phase, const uint16_t = 0) {}
+    static void setEnabled(const bool) {}
+    static void clear() {}
+    static void dump() {}
+
+#endif
+
+}; // End class Trace
+
+/**
+ * @brief Records a begin event now and the matching end event when it goes
+ *        out of scope
+ */
+class TraceScope
+{
+public:
+
+    TraceScope(const char* pName, const uint16_t arg = 0)
+    :
+    mpName(pName)
+    { Trace::record(pName, Trace::Phase::Begin, arg); }
+
+    ~TraceScope()
+    { Trace::record(mpName, Trace::Phase::End); }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+
+    /// Name of the span
+    const char* mpName;
+
+}; // End class TraceScope
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+
+#ifdef RP_TRACE
+
+/// Start a span
+#define TRACE_BEGIN(name) Trace::record((name), Trace::Phase::Begin)
+/// End a span
+#define TRACE_END(name) Trace::record((name), Trace::Phase::End)
+/// Mark a point, with a value
+#define TRACE_INSTANT(name, arg) Trace::record((name), Trace::Phase::Instant, (arg))
+/// Span from here to the end of the enclosing block
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(traceScope, __LINE__)(name)
+/// Span from here to the end of the enclosing block, with a value
+#define TRACE_SCOPE_ARG(name, arg) TraceScope TRACE_CONCAT(traceScope, __LINE__)((name), (arg))
+
+#else
+
+#define TRACE_BEGIN(name) ((void)0)
+#define TRACE_END(name) ((void)0)
+#define TRACE_INSTANT(name, arg) ((void)0)
+#define TRACE_SCOPE(name) ((void)0)
+#define TRACE_SCOPE_ARG(name, arg) ((void)0)
+
+#endif
@@ -0,0 +1,60 @@
+#include "trace.hpp"
+
+#ifdef RP_TRACE
+
+#include <cstdio>
+
+Trace::Event Trace::sEvents[NUM_CORES][EVENTS] = {};
+volatile uint32_t Trace::sHead[NUM_CORES] = {};
+volatile bool Trace::sIsEnabled = true;
+
+void Trace::clear()
+{
+    const bool wasEnabled = sIsEnabled;
+    sIsEnabled = false;
+
+    for(uint core = 0; core < NUM_CORES; core++)
+    {
+        sHead[core] = 0;
+    }
+
+    sIsEnabled = wasEnabled;
+}
+
+void Trace::dump()
+{
+    const bool wasEnabled = sIsEnabled;
+    sIsEnabled = false;
+
+    uint32_t lost = 0;
+
+    printf("# rp_trace 1\n");
+
+    for(uint core = 0; core < NUM_CORES; core++)
+    {
+        const uint32_t head = sHead[core];
+        uint32_t first = 0;
+
+        // The other core may have been part way through overwriting the
+        // oldest event when recording paused
+        if(head > EVENTS)
+        {
+            first = head - EVENTS + 1;
+            lost += first;
+        }
+
+        for(uint32_t i = first; i < head; i++)
+        {
+            const Event& event = sEvents[core][i & (EVENTS - 1)];
+
+            printf("%u %lu %c %u %s\n", core, static_cast<unsigned long>(event.time),
+                    static_cast<char>(event.phase), event.arg, event.pName);
+        }
+    }
+
+    printf("# lost %lu\n", static_cast<unsigned long>(lost));
+
+    sIsEnabled = wasEnabled;
+}
+
+#endif
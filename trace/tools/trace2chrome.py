@@ -0,0 +1,106 @@
+#!/usr/bin/env python3
+"""
+Convert a Trace::dump capture to Chrome trace JSON.
+
+Reads the text Trace::dump prints (other serial output around it is
+skipped) and writes a file chrome://tracing and ui.perfetto.dev open.
+Each core is a thread; timestamps are unwrapped past 32 bits.
+
+Usage: trace2chrome.py capture.txt [trace.json]
+"""
+
+import json
+import sys
+
+
+def parse(lines):
+    """
+    Collect the events of each core, in the order recorded
+    """
+    cores = {}
+    lost = 0
+    inDump = False
+
+    for line in lines:
+        line = line.strip()
+
+        if line.startswith("# rp_trace"):
+            inDump = True
+            cores = {}
+            continue
+
+        if not inDump:
+            continue
+
+        if line.startswith("# lost"):
+            lost = int(line.split()[2])
+            inDump = False
+            continue
+
+        fields = line.split(" ", 4)
+        if len(fields) != 5 or fields[2] not in ("B", "E", "I"):
+            continue
+
+        core, time, phase, arg, name = fields
+        cores.setdefault(int(core), []).append((int(time), phase, int(arg), name))
+
+    return cores, lost
+
+
+def toChrome(cores):
+    """
+    Build Chrome trace events, dropping ends whose begin was overwritten
+    """
+    events = []
+
+    for core, records in sorted(cores.items()):
+        events.append({"name": "thread_name", "ph": "M", "pid": 0, "tid": core,
+                        "args": {"name": "core %d" % core}})
+
+        base = 0
+        last = None
+        depth = 0
+
+        for time, phase, arg, name in records:
+            # TIMERAWL wraps every 2^32 us
+            if last is not None and time < last:
+                base += 1 << 32
+            last = time
+
+            event = {"name": name, "ph": phase, "ts": base + time, "pid": 0, "tid": core}
+
+            if phase == "B":
+                depth += 1
+                event["args"] = {"arg": arg}
+            elif phase == "E":
+                if depth == 0:
+                    continue
+                depth -= 1
+            else:
+                event["ph"] = "i"
+                event["s"] = "t"
+                event["args"] = {"arg": arg}
+
+            events.append(event)
+
+    return events
+
+
+def main():
+    if len(sys.argv) < 2:
+        print(__doc__.strip())
+        return 1
+
+    with open(sys.argv[1], errors="replace") as capture:
+        cores, lost = parse(capture)
+
+    events = toChrome(cores)
+    out = open(sys.argv[2], "w") if len(sys.argv) > 2 else sys.stdout
+    json.dump({"traceEvents": events}, out)
+
+    print("%d events, %d lost" % (len(events), lost), file=sys.stderr)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())